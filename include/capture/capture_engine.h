@@ -2,8 +2,11 @@
 
 #include <memory>
 #include <vector>
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <functional>
+#include "core/memory_pool.h"
 
 namespace talos {
 
@@ -91,8 +94,75 @@ enum class PixelFormat {
     NV12        // YUV 4:2:0 semi-planar
 };
 
+/**
+ * @brief Axis-aligned rectangle in frame pixel coordinates
+ */
+struct Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+/**
+ * @brief One bit per fixed-size tile, set when the tile changed
+ */
+struct DirtyTileMap {
+    int tileSize = 0;   // Tile edge in pixels; 0 when no map was computed
+    int columns = 0;
+    int rows = 0;
+    std::vector<uint64_t> bits;
+
+    void reset(int width, int height, int tile) {
+        tileSize = tile;
+        columns = (width + tile - 1) / tile;
+        rows = (height + tile - 1) / tile;
+        bits.assign((static_cast<size_t>(columns) * rows + 63) / 64, 0);
+    }
+
+    void clear() {
+        tileSize = columns = rows = 0;
+        bits.clear();
+    }
+
+    void setAll() {
+        size_t count = static_cast<size_t>(columns) * rows;
+        std::fill(bits.begin(), bits.end(), ~uint64_t(0));
+        if (count % 64 != 0) {
+            bits.back() = (uint64_t(1) << (count % 64)) - 1;
+        }
+    }
+
+    bool valid() const { return tileSize > 0; }
+
+    void set(int column, int row) {
+        size_t index = static_cast<size_t>(row) * columns + column;
+        bits[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    bool test(int column, int row) const {
+        size_t index = static_cast<size_t>(row) * columns + column;
+        return (bits[index / 64] >> (index % 64)) & 1;
+    }
+};
+
+/**
+ * @brief Pixel storage: 64-byte aligned for SIMD, not zero-filled on resize
+ */
+using FrameData = std::vector<uint8_t, AlignedAllocator<uint8_t, 64>>;
+
+/**
+ * @brief Hook that hands borrowed frame memory back to the capture source
+ */
+using ReleaseCallback = std::function<void()>;
+
 /**
  * @brief Captured frame data
+ *
+ * Pixels are either owned in data or borrowed from the capture source
+ * (SHM segment, CVPixelBuffer, ...) through borrow(). Borrowed memory stays
+ * valid until the frame is destroyed or recycled, at which point the
+ * release callback runs exactly once. Always read pixels through pixels().
  */
 struct Frame {
     int width;              // Frame width in pixels
@@ -100,7 +170,48 @@ struct Frame {
     int stride;             // Bytes per row (may include padding)
     PixelFormat pixelFormat; // Pixel format
     uint64_t timestamp;     // Timestamp in microseconds
-    std::vector<uint8_t> data; // Frame data
+    uint64_t sequence = 0;  // Capture order from FramePool; a gap means frames were dropped
+    FrameData data;         // Owned frame data (empty when borrowed)
+    const uint8_t* external = nullptr; // Borrowed frame data
+    ReleaseCallback releaseCallback;   // Returns borrowed data to its source
+    std::vector<Rect> dirtyRects; // Regions changed since the previous frame (empty = whole frame unless identical)
+    DirtyTileMap dirtyTiles;      // Changed tiles, when a ChangeDetector ran
+    bool identical = false;       // No pixel changed since the previous frame
+
+    Frame() = default;
+    ~Frame() { release(); }
+
+    // A copy would release borrowed memory twice
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+    /**
+     * @brief Pixel data, owned or borrowed
+     */
+    const uint8_t* pixels() const { return external ? external : data.data(); }
+
+    /**
+     * @brief Reference externally owned pixels instead of copying them
+     * @param memory Start of the first row; must stay valid until release
+     * @param release Called once when the frame no longer needs memory
+     */
+    void borrow(const uint8_t* memory, ReleaseCallback release) {
+        this->release();
+        external = memory;
+        releaseCallback = std::move(release);
+    }
+
+    /**
+     * @brief Drop borrowed pixels now, returning them to their source
+     */
+    void release() {
+        external = nullptr;
+        if (releaseCallback) {
+            ReleaseCallback callback = std::move(releaseCallback);
+            releaseCallback = nullptr;
+            callback();
+        }
+    }
 };
 
 /**
@@ -112,6 +223,9 @@ struct CaptureStats {
     uint64_t bytesCapture = 0;    // Total bytes captured
     float averageFps = 0.0f;      // Average frames per second
     float currentFps = 0.0f;      // Current frames per second
+    uint64_t poolHits = 0;        // Frames served from recycled buffers
+    uint64_t poolMisses = 0;      // Frames that needed a fresh buffer
+    size_t poolHighWater = 0;     // Peak number of frames in flight
 };
 
 /**
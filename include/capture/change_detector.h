@@ -0,0 +1,60 @@
+#pragma once
+
+#include "capture/capture_engine.h"
+#include <vector>
+
+namespace talos {
+namespace capture {
+
+/**
+ * @brief Software frame differencing for capture APIs without damage reports
+ *
+ * Keeps a shadow copy of the last frame and compares each new frame
+ * against it in tiles. Rows are compared whole first, so static content
+ * costs one sequential read of each frame; a tile stops being compared once
+ * it is known dirty, and only changed tiles are copied into the shadow.
+ * When the frame already carries damage rectangles, only tiles touching
+ * them are compared.
+ *
+ * process() fills Frame::dirtyTiles and Frame::identical and replaces
+ * Frame::dirtyRects with the changed tiles, merged into horizontal runs.
+ */
+class ChangeDetector {
+public:
+    /**
+     * @brief Create a detector
+     * @param tileSize Tile edge in pixels
+     */
+    explicit ChangeDetector(int tileSize = 64);
+
+    /**
+     * @brief Diff a frame against the previous one and annotate it
+     * @param frame Frame to inspect (4-byte pixel formats only)
+     */
+    void process(Frame& frame);
+
+    /**
+     * @brief Forget the previous frame; the next one is reported fully dirty
+     */
+    void reset();
+
+private:
+    bool compareTileRow(const uint8_t* pixels, int stride, int row, bool wholeRow,
+                        DirtyTileMap& tiles);
+    void appendTileRuns(const DirtyTileMap& tiles, int row, std::vector<Rect>& rects) const;
+    void markDamagedTiles(const std::vector<Rect>& rects);
+
+    int m_tileSize;
+
+    // Last frame, packed rows of m_width * 4 bytes
+    std::vector<uint8_t> m_shadow;
+    int m_width;
+    int m_height;
+    PixelFormat m_format;
+    bool m_valid;
+
+    DirtyTileMap m_candidates;  // Tiles that may have changed
+};
+
+} // namespace capture
+} // namespace talos
@@ -1,12 +1,13 @@
 #pragma once
 
 #include "capture/capture_engine.h"
+#include "core/frame_buffer.h"
+#include "core/frame_pool.h"
+#include "capture/change_detector.h"
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
-#include <queue>
 
 #ifdef __OBJC__
 @class AVCaptureSession;
@@ -56,11 +57,15 @@ private:
     AVCaptureVideoDataOutput* m_videoOutput;
     TalosCaptureDelegate* m_delegate;
     
-    // Frame queue
-    mutable std::mutex m_queueMutex;
-    std::condition_variable m_queueCondition;
-    std::queue<std::shared_ptr<Frame>> m_frameQueue;
-    static constexpr size_t MAX_QUEUE_SIZE = 5;
+    // Lock-free frame queue to the consumer
+    static constexpr size_t MAX_QUEUE_SIZE = 4;
+    FrameBuffer m_frameBuffer;
+    
+    // Recycled frame buffers
+    FramePool m_framePool;
+    
+    // Software damage detection, the capture API reports none
+    ChangeDetector m_changeDetector;
     
     // State
     std::atomic<bool> m_initialized;
@@ -4,12 +4,13 @@
 
 #include "capture/capture_engine.h"
 #include "capture/desktop_duplication_api.h"
+#include "core/frame_buffer.h"
+#include "core/frame_pool.h"
+#include "capture/change_detector.h"
 #include <memory>
 #include <atomic>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
-#include <queue>
 
 namespace talos {
 namespace capture {
@@ -59,11 +60,6 @@ private:
     // Capture thread function
     void captureThread();
     
-    // Frame queue management
-    void pushFrame(std::shared_ptr<Frame> frame);
-    std::shared_ptr<Frame> popFrame(uint32_t timeoutMs);
-    void clearFrameQueue();
-    
     // Desktop Duplication API wrapper
     std::unique_ptr<DesktopDuplicationAPI> m_duplicationAPI;
     
@@ -72,11 +68,14 @@ private:
     std::atomic<bool> m_capturing;
     std::atomic<bool> m_threadRunning;
     
-    // Frame queue
-    std::queue<std::shared_ptr<Frame>> m_frameQueue;
-    mutable std::mutex m_queueMutex;
-    std::condition_variable m_queueCondition;
-    size_t m_maxQueueSize;
+    // Lock-free frame queue to the consumer
+    FrameBuffer m_frameBuffer;
+    
+    // Recycled frame buffers
+    FramePool m_framePool;
+    
+    // Software damage detection, the capture API reports none
+    ChangeDetector m_changeDetector;
     
     // Configuration
     int m_monitorIndex;
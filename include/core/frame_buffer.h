@@ -0,0 +1,71 @@
+#pragma once
+
+#include "capture/capture_engine.h"
+#include "core/ring_buffer.h"
+#include "core/wait_event.h"
+#include <atomic>
+#include <memory>
+
+namespace talos {
+
+/**
+ * @brief Frame handoff between a capture thread and its consumer
+ *
+ * A lock-free single-producer/single-consumer ring of frames. When the
+ * consumer falls behind, push() evicts the oldest queued frame so the
+ * capture thread never blocks; evictions are counted. pop() sleeps on a
+ * WaitEvent, so an idle consumer costs nothing and the producer only pays
+ * for a wake-up system call when the consumer is actually asleep.
+ */
+class FrameBuffer {
+public:
+    /**
+     * @brief Create the buffer
+     * @param capacity Queued frames before the oldest is dropped (rounded up to a power of two)
+     */
+    explicit FrameBuffer(size_t capacity = 4);
+
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    /**
+     * @brief Queue a frame, dropping the oldest one if full (producer only)
+     * @param frame Frame to queue
+     * @return true if an older frame was dropped to make room
+     */
+    bool push(std::shared_ptr<capture::Frame> frame);
+
+    /**
+     * @brief Take the oldest frame, waiting up to timeoutMs (consumer only)
+     * @param timeoutMs Timeout in milliseconds
+     * @return Frame, or nullptr on timeout or after close()
+     */
+    std::shared_ptr<capture::Frame> pop(uint32_t timeoutMs);
+
+    /**
+     * @brief Let pop() wait again and reset the drop counter
+     */
+    void open();
+
+    /**
+     * @brief Wake any waiting consumer and make pop() return immediately when empty
+     */
+    void close();
+
+    /**
+     * @brief Drop all queued frames (not counted as drops)
+     */
+    void clear();
+
+    size_t size() const { return m_ring.size(); }
+    size_t capacity() const { return m_ring.capacity(); }
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    RingBuffer<std::shared_ptr<capture::Frame>> m_ring;
+    WaitEvent m_frameAvailable;
+    std::atomic<bool> m_closed;
+    std::atomic<uint64_t> m_dropped;
+};
+
+} // namespace talos
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "capture/capture_engine.h"
+#include "core/memory_pool.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace talos {
+
+/**
+ * @brief Frame pool statistics
+ */
+struct FramePoolStats {
+    uint64_t hits = 0;        // acquire() served by a recycled frame large enough
+    uint64_t misses = 0;      // acquire() that had to allocate or grow a buffer
+    size_t outstanding = 0;   // Frames currently held by consumers
+    size_t highWater = 0;     // Peak of outstanding frames
+    size_t pooled = 0;        // Frames waiting on the free list
+};
+
+/**
+ * @brief Recycling pool of capture frames
+ *
+ * acquire() hands out a shared_ptr<Frame> whose pixel buffer is reused from
+ * an earlier frame when possible. When the last reference drops, the frame
+ * (with its buffer capacity) goes back on the free list instead of being
+ * freed, and the shared_ptr control block is recycled as well, so a steady
+ * capture loop performs no heap allocations. Frames outstanding when the
+ * pool is destroyed are freed normally on release.
+ */
+class FramePool {
+public:
+    /**
+     * @brief Create a pool
+     * @param maxPooledFrames Free-list bound; extra released frames are freed
+     */
+    explicit FramePool(size_t maxPooledFrames = 8);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief Preallocate frames so the first captures are pool hits too
+     * @param count Number of frames
+     * @param dataSize Pixel buffer size of each frame in bytes
+     */
+    void reserve(size_t count, size_t dataSize);
+
+    /**
+     * @brief Get a frame whose data holds at least dataSize bytes
+     * @param dataSize Required pixel buffer size in bytes (contents undefined);
+     *                 0 for frames that will borrow() their pixels
+     * @return Frame with no change information and the next sequence number; other
+     *         metadata must be set by the caller
+     */
+    std::shared_ptr<capture::Frame> acquire(size_t dataSize);
+
+    /**
+     * @brief Get pool statistics
+     * @return Current statistics
+     */
+    FramePoolStats getStats() const;
+
+private:
+    struct State;
+
+    // Returns a frame to the pool state when the last shared_ptr drops
+    struct Recycler {
+        std::shared_ptr<State> state;
+        void operator()(capture::Frame* frame) const;
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace talos
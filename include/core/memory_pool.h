@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace talos {
+
+/**
+ * @brief Allocator returning over-aligned storage that is default-initialized
+ *
+ * Used for pixel buffers: the alignment suits any SIMD load width, and
+ * resize() does not zero-fill, since every byte is overwritten by capture.
+ */
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    // Default-initialize instead of value-initialize (no memset on resize)
+    template <typename U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+/**
+ * @brief Thread-safe recycler for fixed-size memory blocks
+ *
+ * The first allocation fixes the block size; blocks of that size are kept on
+ * a free list instead of being returned to the heap. Other sizes fall through
+ * to operator new.
+ */
+class BlockCache {
+public:
+    explicit BlockCache(std::size_t maxCachedBlocks = 64);
+    ~BlockCache();
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    void* allocate(std::size_t bytes);
+    void deallocate(void* block, std::size_t bytes) noexcept;
+
+private:
+    std::mutex m_mutex;
+    std::size_t m_blockSize;
+    std::size_t m_maxCachedBlocks;
+    std::vector<void*> m_freeBlocks;
+};
+
+/**
+ * @brief Standard allocator adapter drawing from a shared BlockCache
+ *
+ * Intended for std::allocate_shared / std::shared_ptr control blocks, which
+ * are always the same size for a given element and deleter type.
+ */
+template <typename T>
+class CachedAllocator {
+public:
+    using value_type = T;
+
+    explicit CachedAllocator(std::shared_ptr<BlockCache> cache) noexcept
+        : m_cache(std::move(cache)) {}
+
+    template <typename U>
+    CachedAllocator(const CachedAllocator<U>& other) noexcept
+        : m_cache(other.cache()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(m_cache->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        m_cache->deallocate(p, n * sizeof(T));
+    }
+
+    const std::shared_ptr<BlockCache>& cache() const noexcept { return m_cache; }
+
+    template <typename U>
+    bool operator==(const CachedAllocator<U>& other) const noexcept { return m_cache == other.cache(); }
+
+    template <typename U>
+    bool operator!=(const CachedAllocator<U>& other) const noexcept { return m_cache != other.cache(); }
+
+private:
+    std::shared_ptr<BlockCache> m_cache;
+};
+
+} // namespace talos
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "capture/capture_engine.h"
+#include "core/video_encoding_pipeline.h"
+#include "encoder/encoder_types.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace talos {
+
+/**
+ * @brief Load signals for one controller interval
+ */
+struct QualitySignals {
+    float captureDropRate = 0.0f;   // Fraction of captured frames dropped before encoding
+    float queueFill = 0.0f;         // Fullest pipeline queue, 0..1
+    float encodeMs = 0.0f;          // Slower of conversion and codec time per frame; the stages overlap
+    float frameBudgetMs = 0.0f;     // Frame interval at the current frame rate
+    float cpuUsage = 0.0f;          // Process CPU time per wall time, 0..1 of all cores
+    float sendQueueGrowth = 0.0f;   // Fastest-growing client send queue, bytes per second
+    uint64_t packetsDropped = 0;    // Packets discarded before publishing this interval
+};
+
+/**
+ * @brief Encoder settings chosen by the controller
+ */
+struct QualityLevel {
+    int bitrate = 0;
+    int framerate = 0;
+    int width = 0;
+    int height = 0;
+
+    bool operator==(const QualityLevel& other) const {
+        return bitrate == other.bitrate && framerate == other.framerate &&
+               width == other.width && height == other.height;
+    }
+    bool operator!=(const QualityLevel& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief What a QualityController decision changed
+ */
+enum class QualityAction {
+    BitrateDown,
+    FramerateDown,
+    ResolutionDown,
+    BitrateUp,
+    FramerateUp,
+    ResolutionUp
+};
+
+/**
+ * @brief Why a decision was taken
+ */
+enum class QualityReason {
+    NetworkCongestion,   // Send queues growing or packets dropped
+    EncoderOverload,     // Encoding slower than the frame budget or queues backing up
+    CpuOverload,         // Process CPU above the high threshold
+    CaptureDrops,        // Frames dropped before encoding
+    Recovered            // All signals below their low thresholds long enough
+};
+
+/**
+ * @brief One audited controller decision
+ */
+struct QualityEvent {
+    uint64_t timestamp = 0;         // steady_clock microseconds
+    QualityAction action = QualityAction::BitrateDown;
+    QualityReason reason = QualityReason::Recovered;
+    QualityLevel from;
+    QualityLevel to;
+    QualitySignals signals;         // Signals that triggered the decision
+};
+
+/**
+ * @brief Controller tuning
+ */
+struct QualityControllerConfig {
+    int minBitrate = 500000;
+    int minFramerate = 10;
+    std::vector<float> resolutionScales = {1.0f, 0.75f, 0.5f};  // Output size steps, largest first
+
+    float bitrateDownFactor = 0.75f;
+    float bitrateUpFactor = 1.15f;
+    int framerateStep = 5;
+
+    // Pressure thresholds; recovery needs every signal below the low ones
+    float cpuHigh = 0.85f;
+    float cpuLow = 0.60f;
+    float encodeBudgetHigh = 0.90f;     // encodeMs as a fraction of the frame budget
+    float encodeBudgetLow = 0.60f;
+    float queueFillHigh = 0.75f;
+    float queueFillLow = 0.25f;
+    float captureDropHigh = 0.05f;
+    float captureDropLow = 0.01f;
+    float sendQueueGrowthHigh = 64 * 1024.0f;
+    float sendQueueGrowthLow = 0.0f;
+
+    // Hysteresis, in controller intervals
+    int degradeAfter = 2;        // Consecutive pressured intervals before stepping down
+    int recoverAfter = 10;       // Consecutive clean intervals before stepping up
+    int cooldown = 3;            // Intervals after any change before the next one
+
+    size_t historySize = 64;     // Events kept for getHistory()
+};
+
+/**
+ * @brief Controller counters
+ */
+struct QualityControllerStats {
+    uint64_t intervals = 0;
+    uint64_t pressuredIntervals = 0;
+    uint64_t bitrateChanges = 0;
+    uint64_t framerateChanges = 0;
+    uint64_t resolutionChanges = 0;
+    QualityLevel current;
+};
+
+/**
+ * @brief Closed-loop adaptation of bitrate, frame rate and resolution
+ *
+ * Fed one QualitySignals sample per interval (typically a second). Under
+ * network pressure the controller steps bitrate down first, then frame
+ * rate, then output resolution. Encoder and CPU pressure skip the bitrate
+ * step, which costs the encoder no less work. Recovery walks the same
+ * ladder backwards. Stepping down needs degradeAfter pressured intervals
+ * in a row, stepping up recoverAfter clean ones, and every change is
+ * followed by a cooldown so its effect shows in the signals first.
+ *
+ * Each decision is logged, kept in a bounded history and passed to the
+ * listener, which applies the new level to the encoder, typically with
+ * VideoEncoder::reconfigure(configFor(base, event.to)). The controller owns
+ * the rate: configFor() turns a constant-quality configuration into a
+ * bitrate target with a VBV cap, since under CRF the bitrate steps would
+ * change nothing. Frame rate steps cost the encoder less because it drops
+ * frames captured faster than EncoderConfig::framerate.
+ */
+class QualityController {
+public:
+    using Listener = std::function<void(const QualityEvent&)>;
+
+    /**
+     * @brief Create a controller
+     * @param config Tuning
+     * @param ceiling Configured settings; the controller never exceeds them
+     */
+    QualityController(const QualityControllerConfig& config, const QualityLevel& ceiling);
+
+    /**
+     * @brief Register the consumer of decisions; called on the update() thread
+     */
+    void setListener(Listener listener);
+
+    /**
+     * @brief Evaluate one interval
+     * @param signals Signals measured over the interval
+     * @return true if the level changed
+     */
+    bool update(const QualitySignals& signals);
+
+    QualityLevel getLevel() const;
+    QualityControllerStats getStats() const;
+
+    /**
+     * @brief Most recent decisions, oldest first
+     */
+    std::vector<QualityEvent> getHistory() const;
+
+    /**
+     * @brief The level a configuration runs at, e.g. as the ceiling
+     */
+    static QualityLevel levelOf(const encoder::EncoderConfig& config);
+
+    /**
+     * @brief Encoder configuration for a level
+     *
+     * Everything but size, frame rate and rate control comes from base.
+     * Start the encoder with configFor(base, levelOf(base)) as well: moving
+     * from CRF to a bitrate target later rebuilds the codec.
+     *
+     * @param base Configuration the encoder was set up from
+     * @param level Level to apply
+     */
+    static encoder::EncoderConfig configFor(const encoder::EncoderConfig& base, const QualityLevel& level);
+
+    static const char* actionName(QualityAction action);
+    static const char* reasonName(QualityReason reason);
+
+private:
+    bool detectPressure(const QualitySignals& signals, QualityReason& reason) const;
+    bool isClean(const QualitySignals& signals) const;
+    bool stepDown(QualityReason reason, QualityAction& action);
+    bool stepUp(QualityAction& action);
+    void applyResolution();
+    void record(QualityAction action, QualityReason reason, const QualityLevel& from,
+                const QualitySignals& signals);
+
+    QualityControllerConfig m_config;
+    QualityLevel m_ceiling;
+    Listener m_listener;
+
+    mutable std::mutex m_mutex;
+    QualityLevel m_level;
+    size_t m_resolutionStep;     // Index into resolutionScales
+    int m_pressuredRun;
+    int m_cleanRun;
+    int m_cooldown;
+    QualityControllerStats m_stats;
+    std::deque<QualityEvent> m_history;
+};
+
+/**
+ * @brief Turns cumulative capture, pipeline and encoder counters into QualitySignals
+ *
+ * Keeps the previous counters and CPU time so that every sample covers
+ * exactly the interval since the last one.
+ */
+class QualitySampler {
+public:
+    QualitySampler();
+
+    /**
+     * @brief Measure the interval since the previous call
+     * @param capture Capture engine statistics
+     * @param pipeline Pipeline statistics
+     * @param encoder Encoder statistics
+     * @param framerate Frame rate currently configured
+     * @param sendQueueGrowth Fastest-growing client send queue in bytes per second
+     * @return Signals for QualityController::update()
+     */
+    QualitySignals sample(const capture::CaptureStats& capture, const PipelineStats& pipeline,
+                          const encoder::EncoderStats& encoder, int framerate,
+                          float sendQueueGrowth = 0.0f);
+
+    /**
+     * @brief CPU time used by this process so far, all threads, in seconds
+     */
+    static double processCpuSeconds();
+
+private:
+    bool m_primed;
+    std::chrono::steady_clock::time_point m_lastTime;
+    double m_lastCpuSeconds;
+    uint64_t m_lastCaptured;
+    uint64_t m_lastCaptureDropped;
+    uint64_t m_lastPipelineDropped;
+    uint64_t m_lastPacketsDropped;
+};
+
+} // namespace talos
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace talos {
+
+// Typical destructive-interference size; avoids false sharing between indices
+constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * @brief Bounded lock-free ring for one producer and one consumer
+ *
+ * Each slot carries a sequence number (Vyukov bounded queue), so the
+ * consumer never observes a half-written element and the producer never
+ * overwrites one still being read. The read index is claimed with a CAS,
+ * which lets the producer itself evict the oldest element when the ring is
+ * full (pushOverwrite) without any lock. Capacity is rounded up to a power
+ * of two.
+ */
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(std::size_t capacity)
+        : m_capacity(roundUpPowerOfTwo(capacity < 2 ? 2 : capacity))
+        , m_mask(m_capacity - 1)
+        , m_slots(new Slot[m_capacity]) {
+        for (std::size_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /**
+     * @brief Append an element (producer only)
+     * @return false if the ring is full; value is left untouched
+     */
+    bool tryPush(T& value) {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[pos & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != pos) {
+            return false;
+        }
+        slot.value = std::move(value);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        m_enqueuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Append an element, evicting the oldest ones while full (producer only)
+     * @return Number of elements evicted
+     */
+    std::size_t pushOverwrite(T value) {
+        std::size_t dropped = 0;
+        while (!tryPush(value)) {
+            T oldest;
+            if (tryPop(oldest)) {
+                dropped++;
+            } else {
+                // The consumer has claimed the slot we need and is still moving it out
+                std::this_thread::yield();
+            }
+        }
+        return dropped;
+    }
+
+    /**
+     * @brief Remove the oldest element (consumer, or producer when evicting)
+     * @return false if the ring is empty
+     */
+    bool tryPop(T& out) {
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[pos & m_mask];
+            std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(slot.value);
+                    slot.value = T();
+                    slot.sequence.store(pos + m_capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Approximate number of queued elements
+     */
+    std::size_t size() const {
+        std::size_t head = m_enqueuePos.load(std::memory_order_acquire);
+        std::size_t tail = m_dequeuePos.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    std::size_t capacity() const { return m_capacity; }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t roundUpPowerOfTwo(std::size_t value) {
+        std::size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const std::size_t m_capacity;
+    const std::size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(kCacheLineSize) std::atomic<std::size_t> m_enqueuePos;
+    alignas(kCacheLineSize) std::atomic<std::size_t> m_dequeuePos;
+};
+
+} // namespace talos
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "core/ring_buffer.h"
+#include "core/wait_event.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace talos {
+
+/**
+ * @brief What a full StageQueue does with a new item
+ */
+enum class OverflowPolicy {
+    DropOldest,      // Evict the oldest queued item
+    Block,           // Wait until the consumer makes room
+    DropToKeyframe   // Flush the queue and discard until the next keyframe
+};
+
+/**
+ * @brief Bounded hand-off between two pipeline stages
+ *
+ * A lock-free ring with one producer and one consumer thread. Both sides
+ * sleep on WaitEvents, so an idle stage costs nothing and a wake-up system
+ * call is only made when the other side is actually asleep.
+ *
+ * DropToKeyframe needs a predicate that recognizes keyframes; without one
+ * it behaves like DropOldest. It suits encoded packets, where a partial GOP
+ * is useless to the decoder.
+ */
+template <typename T>
+class StageQueue {
+public:
+    using KeyframePredicate = std::function<bool(const T&)>;
+
+    /**
+     * @brief Create a queue
+     * @param capacity Queued items (rounded up to a power of two)
+     * @param policy Behaviour when full
+     * @param isKeyframe Keyframe test for DropToKeyframe
+     */
+    StageQueue(std::size_t capacity, OverflowPolicy policy, KeyframePredicate isKeyframe = nullptr)
+        : m_ring(capacity)
+        , m_policy(isKeyframe || policy != OverflowPolicy::DropToKeyframe ? policy : OverflowPolicy::DropOldest)
+        , m_isKeyframe(std::move(isKeyframe))
+        , m_awaitingKeyframe(false)
+        , m_closed(false)
+        , m_dropped(0) {
+    }
+
+    StageQueue(const StageQueue&) = delete;
+    StageQueue& operator=(const StageQueue&) = delete;
+
+    /**
+     * @brief Queue an item according to the overflow policy (producer only)
+     * @param item Item to queue
+     * @return true if the item was queued, false if it was dropped or the queue is closed
+     */
+    bool push(T item) {
+        if (m_closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        switch (m_policy) {
+            case OverflowPolicy::DropOldest:
+                m_dropped.fetch_add(m_ring.pushOverwrite(std::move(item)), std::memory_order_relaxed);
+                break;
+
+            case OverflowPolicy::Block:
+                if (!pushBlocking(item)) {
+                    return false;
+                }
+                break;
+
+            case OverflowPolicy::DropToKeyframe:
+                if (!pushUntilOverflow(item)) {
+                    return false;
+                }
+                break;
+        }
+
+        m_itemAvailable.notify();
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest item, waiting up to timeoutMs (consumer only)
+     * @param item Receives the item
+     * @param timeoutMs Timeout in milliseconds
+     * @return true if an item was taken, false on timeout or when closed and empty
+     */
+    bool pop(T& item, uint32_t timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        for (;;) {
+            if (tryPop(item)) {
+                return true;
+            }
+            if (m_closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            // Re-check after registering so a push in between cannot be missed
+            uint32_t epoch = m_itemAvailable.prepareWait();
+            if (tryPop(item)) {
+                m_itemAvailable.cancelWait();
+                return true;
+            }
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (m_closed.load(std::memory_order_acquire) || remaining.count() <= 0) {
+                m_itemAvailable.cancelWait();
+                return tryPop(item);
+            }
+            if (!m_itemAvailable.wait(epoch, remaining)) {
+                return tryPop(item);
+            }
+        }
+    }
+
+    /**
+     * @brief Accept items again and reset the drop counter
+     */
+    void open() {
+        m_dropped.store(0, std::memory_order_relaxed);
+        m_awaitingKeyframe = false;
+        m_closed.store(false, std::memory_order_release);
+    }
+
+    /**
+     * @brief Reject new items and wake both sides; queued items can still be popped
+     */
+    void close() {
+        m_closed.store(true, std::memory_order_release);
+        m_itemAvailable.notify();
+        m_spaceAvailable.notify();
+    }
+
+    /**
+     * @brief Drop all queued items (not counted as drops)
+     */
+    void clear() {
+        T item;
+        while (m_ring.tryPop(item)) {
+        }
+        m_spaceAvailable.notify();
+    }
+
+    std::size_t size() const { return m_ring.size(); }
+    std::size_t capacity() const { return m_ring.capacity(); }
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    bool tryPop(T& item) {
+        if (!m_ring.tryPop(item)) {
+            return false;
+        }
+        m_spaceAvailable.notify();
+        return true;
+    }
+
+    bool pushBlocking(T& item) {
+        for (;;) {
+            if (m_ring.tryPush(item)) {
+                return true;
+            }
+            uint32_t epoch = m_spaceAvailable.prepareWait();
+            if (m_ring.tryPush(item)) {
+                m_spaceAvailable.cancelWait();
+                return true;
+            }
+            if (m_closed.load(std::memory_order_acquire)) {
+                m_spaceAvailable.cancelWait();
+                return false;
+            }
+            // Timed so a missed close() cannot hang the producer forever
+            m_spaceAvailable.wait(epoch, std::chrono::milliseconds(100));
+        }
+    }
+
+    bool pushUntilOverflow(T& item) {
+        // Producer-only state: resume with the first keyframe after a flush
+        if (m_awaitingKeyframe) {
+            if (!m_isKeyframe(item)) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            m_awaitingKeyframe = false;
+        }
+
+        if (m_ring.tryPush(item)) {
+            return true;
+        }
+
+        // Everything queued depends on a keyframe the consumer will never
+        // see in full, so discard it together with the rest of the GOP
+        T stale;
+        uint64_t flushed = 0;
+        while (m_ring.tryPop(stale)) {
+            flushed++;
+        }
+        m_spaceAvailable.notify();
+
+        if (m_isKeyframe(item)) {
+            flushed += m_ring.pushOverwrite(std::move(item));
+            m_dropped.fetch_add(flushed, std::memory_order_relaxed);
+            return true;
+        }
+        m_dropped.fetch_add(flushed + 1, std::memory_order_relaxed);
+        m_awaitingKeyframe = true;
+        return false;
+    }
+
+    RingBuffer<T> m_ring;
+    OverflowPolicy m_policy;
+    KeyframePredicate m_isKeyframe;
+    bool m_awaitingKeyframe;
+
+    WaitEvent m_itemAvailable;
+    WaitEvent m_spaceAvailable;
+    std::atomic<bool> m_closed;
+    std::atomic<uint64_t> m_dropped;
+};
+
+} // namespace talos
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace talos {
+
+/**
+ * @brief Persistent worker threads for data-parallel loops
+ *
+ * Workers are started once and sleep between jobs, so a per-frame
+ * parallelFor() costs a wake-up rather than thread creation. The calling
+ * thread takes part in the work, so a pool with N workers runs a loop on
+ * N + 1 threads. Jobs are handed out by an atomic index, which balances
+ * uneven items without any per-item locking.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Start the workers
+     * @param workerCount Threads besides the caller; 0 runs everything inline
+     */
+    explicit ThreadPool(size_t workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Run task(0) .. task(count - 1) across the pool and wait for all of them
+     * @param count Number of items
+     * @param task Called once per item, possibly concurrently
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    /**
+     * @brief Threads a parallelFor() runs on, including the caller
+     */
+    size_t concurrency() const { return m_workers.size() + 1; }
+
+    /**
+     * @brief Default thread count for CPU-bound work (at least 1)
+     */
+    static size_t hardwareConcurrency();
+
+private:
+    void workerLoop();
+    void runItems();
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_jobMutex;  // Serializes parallelFor() callers
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_jobFinished;
+
+    const std::function<void(size_t)>* m_task;
+    size_t m_count;
+    std::atomic<size_t> m_nextItem;
+    uint64_t m_generation;
+    size_t m_busyWorkers;
+    bool m_stopping;
+};
+
+} // namespace talos
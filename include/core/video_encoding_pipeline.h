@@ -0,0 +1,141 @@
+#pragma once
+
+#include "capture/capture_engine.h"
+#include "core/stage_queue.h"
+#include "encoder/video_encoder.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace talos {
+
+/**
+ * @brief Size and overflow policy of one pipeline queue
+ */
+struct StageQueueConfig {
+    size_t capacity;
+    OverflowPolicy policy;
+};
+
+/**
+ * @brief Pipeline configuration
+ */
+struct PipelineConfig {
+    // Captured frames waiting for conversion; a stale frame is worth nothing
+    StageQueueConfig frames = {2, OverflowPolicy::DropOldest};
+
+    // Converted pictures waiting for the encoder
+    StageQueueConfig prepared = {2, OverflowPolicy::DropOldest};
+
+    // Encoded packets waiting to be published; a gap breaks the GOP
+    StageQueueConfig packets = {64, OverflowPolicy::DropToKeyframe};
+
+    uint32_t stageTimeoutMs = 100;  // How often idle stages check for stop() and keep-alive pictures
+};
+
+/**
+ * @brief Pipeline statistics
+ */
+struct PipelineStats {
+    uint64_t framesCaptured = 0;
+    uint64_t framesPrepared = 0;     // Converted (frames skipped by the encoder excluded)
+    uint64_t framesEncoded = 0;
+    uint64_t packetsPublished = 0;
+
+    uint64_t framesDropped = 0;      // Overflow of the frame queue
+    uint64_t preparedDropped = 0;    // Overflow of the prepared queue
+    uint64_t packetsDropped = 0;     // Overflow of the packet queue
+    uint64_t errors = 0;             // Failed prepare or encode calls
+
+    // Queue depth at the time of the call
+    size_t framesQueued = 0;
+    size_t preparedQueued = 0;
+    size_t packetsQueued = 0;
+    float maxQueueFill = 0.0f;       // Fullest queue as a fraction of its capacity
+};
+
+/**
+ * @brief Capture, convert, encode and publish on one thread each
+ *
+ * Stages are joined by bounded StageQueues, so converting frame N+1
+ * overlaps encoding frame N and a slow stage only ever backs up into its
+ * own input queue. What happens then is set per queue by PipelineConfig.
+ * The capture frame goes back to its pool as soon as it is converted.
+ * While no frame arrives, the convert stage polls the encoder's
+ * prepareKeepAlive() every stageTimeoutMs, or sooner when the encoder
+ * holds changes of a dropped frame that are due within that time.
+ *
+ * The capture engine and encoder must be initialized; start() begins
+ * capturing if the engine is not capturing yet. Sinks run on the publish
+ * thread and should not block.
+ */
+class VideoEncodingPipeline {
+public:
+    using PacketSink = std::function<void(const encoder::EncodedPacketPtr&)>;
+
+    VideoEncodingPipeline(ICaptureEngine& captureEngine, VideoEncoder& encoder,
+                          const PipelineConfig& config = PipelineConfig());
+    ~VideoEncodingPipeline();
+
+    VideoEncodingPipeline(const VideoEncodingPipeline&) = delete;
+    VideoEncodingPipeline& operator=(const VideoEncodingPipeline&) = delete;
+
+    /**
+     * @brief Register a consumer of encoded packets; only before start()
+     * @param sink Called on the publish thread for every packet, in decode order
+     */
+    void addSink(PacketSink sink);
+
+    /**
+     * @brief Start the stage threads
+     * @return true if successful, false otherwise
+     */
+    bool start();
+
+    /**
+     * @brief Stop and join the stage threads; queued items are discarded
+     */
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Get pipeline statistics
+     * @return Current statistics
+     */
+    PipelineStats getStats() const;
+
+private:
+    void captureLoop();
+    void convertLoop();
+    void encodeLoop();
+    void publishLoop();
+
+    ICaptureEngine& m_captureEngine;
+    VideoEncoder& m_encoder;
+    PipelineConfig m_config;
+    std::vector<PacketSink> m_sinks;
+
+    StageQueue<std::shared_ptr<capture::Frame>> m_frameQueue;
+    StageQueue<encoder::PreparedFramePtr> m_preparedQueue;
+    StageQueue<encoder::EncodedPacketPtr> m_packetQueue;
+
+    std::atomic<bool> m_running;
+    bool m_startedCapture;
+    std::thread m_captureThread;
+    std::thread m_convertThread;
+    std::thread m_encodeThread;
+    std::thread m_publishThread;
+
+    // Counters written by one stage thread each
+    std::atomic<uint64_t> m_framesCaptured;
+    std::atomic<uint64_t> m_framesPrepared;
+    std::atomic<uint64_t> m_framesEncoded;
+    std::atomic<uint64_t> m_packetsPublished;
+    std::atomic<uint64_t> m_errors;
+};
+
+} // namespace talos
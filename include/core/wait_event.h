@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if !defined(PLATFORM_LINUX) && !defined(PLATFORM_WINDOWS)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace talos {
+
+/**
+ * @brief Event count for lock-free producer/consumer wakeups
+ *
+ * Consumers take a ticket with prepareWait(), re-check their queue and only
+ * then sleep in wait(). notify() bumps the epoch and issues a wake system
+ * call only when someone is actually sleeping, so the producer's fast path
+ * is two atomic operations and never blocks on a lock. Sleeps map to futex
+ * on Linux and WaitOnAddress on Windows; other platforms use a condition
+ * variable on the slow path.
+ */
+class WaitEvent {
+public:
+    WaitEvent() = default;
+
+    WaitEvent(const WaitEvent&) = delete;
+    WaitEvent& operator=(const WaitEvent&) = delete;
+
+    /**
+     * @brief Register as a waiter; must be followed by wait() or cancelWait()
+     * @return Epoch to pass to wait()
+     */
+    uint32_t prepareWait();
+
+    /**
+     * @brief Sleep until notify() moves the epoch past the ticket or the timeout expires
+     * @param epoch Value returned by prepareWait()
+     * @param timeout Maximum time to sleep
+     * @return true if notified, false on timeout
+     */
+    bool wait(uint32_t epoch, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Unregister after prepareWait() when the condition became true
+     */
+    void cancelWait();
+
+    /**
+     * @brief Wake all current waiters
+     */
+    void notify();
+
+private:
+    std::atomic<uint32_t> m_epoch{0};
+    std::atomic<uint32_t> m_waiters{0};
+
+#if !defined(PLATFORM_LINUX) && !defined(PLATFORM_WINDOWS)
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+#endif
+};
+
+} // namespace talos
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "capture/capture_engine.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace talos {
+namespace encoder {
+
+/**
+ * @brief YCbCr matrix used for RGB to YUV conversion
+ */
+enum class ColorMatrix {
+    BT601,
+    BT709
+};
+
+/**
+ * @brief Fixed-point conversion weights, ordered like the source bytes
+ *
+ * Luma weights are Q15 and applied per pixel; chroma weights are Q15 and
+ * applied to the sum of a 2x2 block, so chroma results are Q17.
+ */
+struct ConversionCoefficients {
+    int16_t y[4];     // Weights for bytes 0..2 of a pixel; [3] (alpha) is 0
+    int16_t u[4];
+    int16_t v[4];
+    int32_t yBias;    // (luma offset << 15) + rounding
+    int32_t uvBias;   // (128 << 17) + rounding
+};
+
+/**
+ * @brief Converts two source rows into two luma rows and one chroma row
+ *
+ * src0/src1 hold width 4-byte pixels. When v is null the chroma row is
+ * written interleaved (NV12) to u, otherwise as separate U and V rows.
+ */
+using RowPairKernel = void (*)(const ConversionCoefficients& coeffs,
+                               const uint8_t* src0, const uint8_t* src1,
+                               uint8_t* y0, uint8_t* y1,
+                               uint8_t* u, uint8_t* v, int width);
+
+namespace kernels {
+
+void convertRowPairScalar(const ConversionCoefficients& coeffs,
+                          const uint8_t* src0, const uint8_t* src1,
+                          uint8_t* y0, uint8_t* y1,
+                          uint8_t* u, uint8_t* v, int width);
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TALOS_COLOR_CONVERT_X86 1
+void convertRowPairSse41(const ConversionCoefficients& coeffs,
+                         const uint8_t* src0, const uint8_t* src1,
+                         uint8_t* y0, uint8_t* y1,
+                         uint8_t* u, uint8_t* v, int width);
+void convertRowPairAvx2(const ConversionCoefficients& coeffs,
+                        const uint8_t* src0, const uint8_t* src1,
+                        uint8_t* y0, uint8_t* y1,
+                        uint8_t* u, uint8_t* v, int width);
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TALOS_COLOR_CONVERT_NEON 1
+void convertRowPairNeon(const ConversionCoefficients& coeffs,
+                        const uint8_t* src0, const uint8_t* src1,
+                        uint8_t* y0, uint8_t* y1,
+                        uint8_t* u, uint8_t* v, int width);
+#endif
+
+} // namespace kernels
+
+/**
+ * @brief Same-size BGRA8/RGBA8 to YUV420P/NV12 converter
+ *
+ * Uses the widest SIMD kernel the CPU supports (AVX2, SSE4.1 or NEON) and
+ * falls back to scalar code otherwise. All kernels share the same
+ * fixed-point arithmetic, so output is bit-identical whichever one runs.
+ * Chroma is the rounded average of each 2x2 block.
+ */
+class ColorConverter {
+public:
+    ColorConverter();
+
+    /**
+     * @brief Select formats and colorimetry; cheap when nothing changed
+     * @param srcFormat BGRA8 or RGBA8
+     * @param dstFormat YUV420P or NV12
+     * @param matrix YCbCr matrix
+     * @param fullRange true for 0-255 output, false for 16-235/240
+     * @return true if the combination is supported
+     */
+    bool configure(capture::PixelFormat srcFormat, capture::PixelFormat dstFormat,
+                   ColorMatrix matrix, bool fullRange);
+
+    /**
+     * @brief Convert a whole image; configure() must have succeeded
+     * @param src First source row
+     * @param srcStride Source bytes per row
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @param dst Destination planes (Y, U, V; Y, UV for NV12)
+     * @param dstStride Destination bytes per row of each plane
+     */
+    void convert(const uint8_t* src, int srcStride, int width, int height,
+                 uint8_t* const* dst, const int* dstStride) const;
+
+    /**
+     * @brief Convert the band of rows [rowBegin, rowEnd); safe to call concurrently
+     *        for disjoint bands
+     * @param rowBegin First row, must be even
+     * @param rowEnd One past the last row, clamped to height
+     */
+    void convertRows(const uint8_t* src, int srcStride, int width, int height,
+                     int rowBegin, int rowEnd,
+                     uint8_t* const* dst, const int* dstStride) const;
+
+    /**
+     * @brief Convert one rectangle, widened to even coordinates so that it
+     *        covers whole chroma blocks; output matches a full conversion
+     * @param rect Region in pixels, clipped to the image
+     */
+    void convertRect(const uint8_t* src, int srcStride, int width, int height,
+                     const capture::Rect& rect,
+                     uint8_t* const* dst, const int* dstStride) const;
+
+    /**
+     * @brief Name of the kernel in use ("avx2", "sse4.1", "neon" or "scalar")
+     */
+    const char* kernelName() const { return m_kernelName; }
+
+    /**
+     * @brief Kernels this CPU can run, widest first; "scalar" is always last
+     */
+    static std::vector<std::string> supportedKernels();
+
+    /**
+     * @brief Use one of supportedKernels() instead of the widest, for tests
+     *        and benchmarks
+     * @return false if the kernel is unknown or unsupported on this CPU
+     */
+    bool selectKernel(const std::string& name);
+
+private:
+    void convertRegion(const uint8_t* src, int srcStride, int height,
+                       int x, int regionWidth, int rowBegin, int rowEnd,
+                       uint8_t* const* dst, const int* dstStride) const;
+
+    RowPairKernel m_kernel;
+    const char* m_kernelName;
+    ConversionCoefficients m_coeffs;
+
+    bool m_configured;
+    capture::PixelFormat m_srcFormat;
+    capture::PixelFormat m_dstFormat;
+    ColorMatrix m_matrix;
+    bool m_fullRange;
+};
+
+/**
+ * @brief Parse a configuration string ("bt601" or "bt709", default bt709)
+ */
+ColorMatrix parseColorMatrix(const std::string& name);
+
+} // namespace encoder
+} // namespace talos
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+extern "C" {
+    struct AVPacket;
+}
+
+namespace talos {
+namespace encoder {
+
+/**
+ * @brief Location of one NAL unit inside an Annex B packet
+ */
+struct NalUnit {
+    size_t offset;  // First byte after the start code
+    size_t size;    // Bytes up to the next start code
+    uint8_t type;   // nal_unit_type (H.264 or H.265 numbering)
+};
+
+/**
+ * @brief One encoded access unit or slice, shared between consumers without copying
+ *
+ * data/size point into the libavcodec packet buffer, which stays alive for
+ * as long as any consumer holds the EncodedPacket. Treat it as immutable.
+ * When an access unit is split into slices, keyframe is only set on the
+ * first of them and endOfFrame only on the last.
+ */
+struct EncodedPacket {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    int64_t pts = 0;               // In the encoder time base
+    int64_t dts = 0;
+    int timeBaseNum = 1;
+    int timeBaseDen = 1;
+    bool keyframe = false;         // Decoding can start here (IDR or recovery point)
+    bool disposable = false;       // No other frame references it, so it can be dropped alone
+    bool endOfFrame = true;        // Last packet of the access unit (RTP marker bit)
+    uint64_t captureTimestamp = 0; // Frame::timestamp of the source frame, microseconds
+    int streamId = 0;              // EncoderConfig::streamId of the encoder that produced it
+
+    std::vector<NalUnit> nalUnits;
+
+    std::shared_ptr<AVPacket> avPacket; // Owns the buffer data points into
+};
+
+using EncodedPacketPtr = std::shared_ptr<const EncodedPacket>;
+
+/**
+ * @brief Split an Annex B byte stream into NAL units
+ * @param data Stream start
+ * @param size Stream length in bytes
+ * @param hevc true for H.265 NAL header layout, false for H.264
+ * @param units Receives the NAL units in stream order (cleared first)
+ */
+void parseAnnexB(const uint8_t* data, size_t size, bool hevc, std::vector<NalUnit>& units);
+
+/**
+ * @brief Whether every slice of a packet is a non-reference picture
+ *
+ * H.264 slices with nal_ref_idc 0, or H.265 sub-layer non-reference slices
+ * (TRAIL_N, RASL_N, ...), which with a single temporal layer no other
+ * picture predicts from.
+ *
+ * @param packet Packet with parsed nalUnits
+ * @param hevc true for H.265 NAL unit types, false for H.264
+ * @return false if the packet holds no slice
+ */
+bool isNonReference(const EncodedPacket& packet, bool hevc);
+
+/**
+ * @brief Split an access unit into one packet per slice
+ *
+ * Non-VCL units (parameter sets, SEI) travel with the slice that follows
+ * them. The slices share the buffer of the original packet.
+ *
+ * @param packet Access unit with parsed nalUnits
+ * @param hevc true for H.265 NAL unit types, false for H.264
+ * @param slices Receives the slice packets in order (cleared first); just
+ *               packet itself if it holds at most one slice
+ */
+void splitSlices(const EncodedPacketPtr& packet, bool hevc, std::vector<EncodedPacketPtr>& slices);
+
+} // namespace encoder
+} // namespace talos
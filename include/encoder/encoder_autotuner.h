@@ -0,0 +1,100 @@
+#pragma once
+
+#include "encoder/encoder_types.h"
+#include <string>
+#include <vector>
+
+namespace talos {
+namespace encoder {
+
+/**
+ * @brief What the autotuner benchmarks and where it keeps the result
+ */
+struct AutotuneOptions {
+    // Software presets, fastest first
+    std::vector<std::string> presets = {"ultrafast", "superfast", "veryfast", "faster", "fast", "medium"};
+    std::vector<int> threadCounts;   // Empty = 1, half of the cores and all cores
+    bool includeHardware = true;     // Also try the platform's hardware encoders
+
+    int clipFrames = 90;             // Length of the synthetic clip
+    float fpsHeadroom = 1.25f;       // Required speed as a multiple of the target frame rate
+    float bitrateTolerance = 0.15f;  // Candidates this close to the smallest output count as equally efficient
+
+    std::string cachePath = "encoder_tuning.json";
+};
+
+/**
+ * @brief Measurement of one encoder/preset/thread-count combination
+ */
+struct AutotuneResult {
+    std::string encoderName;
+    std::string preset;
+    int threadCount = 0;
+
+    float fps = 0.0f;           // Frames encoded per wall-clock second
+    float cpuPercent = 0.0f;    // Process CPU over the run, 100 = all cores busy
+    float bitrate = 0.0f;       // Bits per second at the target frame rate
+    bool meetsTarget = false;   // fps reached framerate * fpsHeadroom
+    bool hardware = false;      // Ran in the hardware comparison class
+};
+
+/**
+ * @brief Picks the encoder, preset and thread count for this host by benchmark
+ *
+ * Encodes a synthetic screen-content clip (text typing and scrolling, a
+ * moving cursor, periodic window switches) at the configured resolution
+ * and CRF through every available combination. Hardware encoders run in
+ * their constant-quality mode at the same value (see EncoderConfig::crf).
+ * Slower presets are skipped once a faster one misses the frame rate
+ * target.
+ *
+ * Bitrates are only compared within a class: software encoders share the
+ * CRF scale, but a hardware QP gives a different quality than the same
+ * CRF. In each class, the combinations that meet the target and are
+ * within bitrateTolerance of the class's smallest output count as equally
+ * good, and the one using the least CPU wins. Between the two class
+ * winners, the one using less CPU is chosen.
+ *
+ * The choice is cached in a JSON file keyed by codec, resolution, frame
+ * rate, CRF and core count, so later starts skip the benchmark.
+ */
+class EncoderAutotuner {
+public:
+    explicit EncoderAutotuner(const AutotuneOptions& options = AutotuneOptions());
+
+    /**
+     * @brief Apply the cached or freshly benchmarked choice to config
+     * @param config Configuration to tune; encoderName, preset and threadCount are set
+     * @param force Benchmark even when a cached result exists
+     * @return true if config was tuned, false if no combination could be measured
+     */
+    bool tune(EncoderConfig& config, bool force = false);
+
+    /**
+     * @brief Measure every available combination for config
+     * @param config Resolution, frame rate, codec and CRF to benchmark at
+     * @param results Receives one entry per combination that could be opened
+     * @return true if at least one combination was measured
+     */
+    bool benchmark(const EncoderConfig& config, std::vector<AutotuneResult>& results);
+
+    /**
+     * @brief Choose from benchmark results as described above
+     * @return false if results is empty; otherwise best is set, with
+     *         meetsTarget false when nothing reached the target (fastest wins)
+     */
+    bool selectBest(const std::vector<AutotuneResult>& results, AutotuneResult& best) const;
+
+private:
+    bool measure(const EncoderConfig& config, AutotuneResult& result);
+    const AutotuneResult* selectInClass(const std::vector<AutotuneResult>& results, bool hardware) const;
+    bool loadCache(const EncoderConfig& config, AutotuneResult& result) const;
+    void saveCache(const EncoderConfig& config, const AutotuneResult& result) const;
+    std::string cacheKey(const EncoderConfig& config) const;
+    std::vector<int> threadCounts() const;
+
+    AutotuneOptions m_options;
+};
+
+} // namespace encoder
+} // namespace talos
@@ -2,10 +2,31 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
 
 namespace talos {
 namespace encoder {
 
+/**
+ * @brief Operator-assigned quality priority for part of the screen
+ */
+struct RoiRegion {
+    int x = 0;              // Capture coordinates
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    float qualityOffset = -0.3f; // -1 (best) .. 1 (worst), relative to the rate control
+};
+
+/**
+ * @brief A lower-resolution stream encoded next to the main one
+ */
+struct RenditionConfig {
+    int width = 0;      // 0 = from height, keeping the aspect ratio
+    int height = 360;
+    int bitrate = 0;    // 0 = main bitrate scaled by area
+};
+
 /**
  * @brief Encoder configuration
  */
@@ -13,33 +34,100 @@ struct EncoderConfig {
     // Video parameters
     int width = 1920;
     int height = 1080;
-    int framerate = 30;
+    int framerate = 30;     // Upper bound: frames captured faster are dropped
     int bitrate = 4000000;  // 4 Mbps
     int gopSize = 60;       // Keyframe interval
+    int keyframeRequestIntervalMs = 1000; // Minimum spacing of keyframes forced by requestKeyframe()
+    bool sceneCut = true;   // Let the codec add keyframes at scene changes; off keeps parallel streams GOP-aligned
+    
+    // PTS always follow capture timestamps. Variable frame rate keeps them
+    // exact (microsecond time base) instead of rounding them to 1/framerate,
+    // and skips unchanged frames as well
+    bool variableFrameRate = false;
+    int keepAliveMs = 1000; // Re-encode a static screen at least this often
     
     // Codec settings
     std::string codec = "h264";  // h264, h265, av1
+    std::string encoderName;     // libavcodec encoder, e.g. "libx264" or "h264_nvenc"; empty = probe
     std::string preset = "fast"; // ultrafast, superfast, veryfast, faster, fast, medium, slow, slower, veryslow
     std::string profile = "main"; // baseline, main, high
     
     // Quality settings
-    int crf = 23;  // Constant Rate Factor (0-51, lower is better quality)
+    int crf = 23;  // Constant Rate Factor (0-51, lower is better quality), a QP for hardware encoders; -1 = bitrate with a VBV cap
     bool useHardwareAccel = true;
     
+    // Low latency: no B-frames or lookahead, slice threading and a VBV of
+    // one frame; each slice is output as its own packet
+    bool lowLatency = false;
+    int sliceCount = 4;          // Slices per frame in low-latency mode
+    bool intraRefresh = true;    // Low-latency mode: refresh column sweeping over gopSize frames instead of IDRs
+    
+    // Region of interest: quality offsets attached to every frame for
+    // encoders that support them (libx264, libx265, QSV, ...). Where regions
+    // overlap, focus regions win over changed areas, which win over the rest.
+    bool regionOfInterest = false;
+    std::vector<RoiRegion> focusRegions; // Always-important areas, e.g. a blotter window
+    float roiChangedOffset = -0.1f;      // Areas that changed since the previous frame
+    float roiStaticOffset = 0.0f;        // Everything else; 0 = left to the rate control
+    
+    // Color settings
+    std::string colorMatrix = "bt709"; // bt601, bt709
+    bool fullRange = false;            // false = limited (16-235) range
+    
+    // Tiled encoding (TiledEncoder): the frame is split into a grid and
+    // every tile is encoded as a separate stream by its own encoder
+    int tileColumns = 1;
+    int tileRows = 1;
+    int streamId = 0;     // Stamped on every packet; tiles are numbered row by row
+    
+    // Rendition ladder (RenditionLadder): sub-streams scaled down from the
+    // main picture, largest first, numbered streamId + 1, + 2, ...
+    std::vector<RenditionConfig> renditions;
+    
     // Performance settings
     int threadCount = 0;  // 0 = auto
+    int conversionBands = 0; // Parallel color conversion bands, 0 = one per core
+    bool incrementalConversion = true;     // Re-convert only the dirty regions of the previous picture
+    float fullConversionThreshold = 0.5f;  // Dirty area fraction above which the whole frame is converted
+};
+
+/**
+ * @brief Outcome of VideoEncoder::reconfigure()
+ */
+struct ReconfigureResult {
+    bool success = false;
+    bool keyframeForced = false;  // The next frame is an IDR frame; decoders resync there
+    bool codecRebuilt = false;    // The codec was reopened (new parameter sets)
 };
 
 /**
  * @brief Encoder statistics
  */
 struct EncoderStats {
+    std::string encoderName;        // libavcodec encoder in use
     uint64_t framesEncoded = 0;
+    uint64_t framesSkipped = 0;     // Dropped above framerate, or identical in VFR mode
+    uint64_t keepAliveFrames = 0;   // Pictures repeated by prepareKeepAlive()
     uint64_t bytesEncoded = 0;
     uint64_t packetsGenerated = 0;
-    float averageFps = 0.0f;
-    float currentBitrate = 0.0f;
+    float averageFps = 0.0f;        // Encoded frames per second since the first frame
+    float currentBitrate = 0.0f;    // Bits per second over the last complete second
+    float encodeMs = 0.0f;          // Codec time per frame (exponentially smoothed)
     uint64_t keyFrames = 0;
+    uint64_t keyframeRequests = 0;  // requestKeyframe() calls
+    uint64_t requestedKeyframes = 0; // Keyframes forced to answer them
+    
+    // Capture to encoded packet, measured on the first packet of each frame
+    float latencyMs = 0.0f;                 // Exponentially smoothed
+    float maxLatencyMs = 0.0f;
+    
+    // Color conversion
+    uint64_t fullConversions = 0;
+    uint64_t partialConversions = 0;       // Frames where only dirty regions were converted
+    
+    // Color conversion timing (exponentially smoothed)
+    float conversionMs = 0.0f;              // Wall time per frame
+    std::vector<float> conversionBandMs;    // Time of each parallel band
 };
 
 } // namespace encoder
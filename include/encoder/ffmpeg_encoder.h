@@ -1,9 +1,14 @@
 #pragma once
 
 #include "encoder/video_encoder.h"
+#include "encoder/color_converter.h"
+#include "encoder/yuv_scaler.h"
+#include "core/thread_pool.h"
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <deque>
 
 // Forward declare FFmpeg types to avoid including headers
 extern "C" {
@@ -11,6 +16,7 @@ extern "C" {
     struct AVFrame;
     struct AVPacket;
     struct AVCodec;
+    struct AVBufferPool;
     struct SwsContext;
 }
 
@@ -28,15 +34,21 @@ public:
     // VideoEncoder interface
     bool initialize(const EncoderConfig& config) override;
     void shutdown() override;
+    ReconfigureResult reconfigure(const EncoderConfig& config) override;
     bool encodeFrame(const capture::Frame& frame) override;
+    bool prepareFrame(const capture::Frame& frame, PreparedFramePtr& prepared) override;
+    bool prepareKeepAlive(uint64_t timestamp, PreparedFramePtr& prepared) override;
+    uint64_t pendingChangesDue() override;
+    bool encodePreparedFrame(const PreparedFramePtr& prepared) override;
+    void requestKeyframe() override;
     bool isInitialized() const override { return m_initialized; }
     
     /**
-     * @brief Get the next encoded packet
-     * @param packet Output buffer for encoded data
+     * @brief Take the next encoded packet from the output queue
+     * @param packet Receives the packet
      * @return true if packet is available, false otherwise
      */
-    bool getEncodedPacket(std::vector<uint8_t>& packet) override;
+    bool getEncodedPacket(EncodedPacketPtr& packet) override;
     
     /**
      * @brief Get encoder statistics
@@ -44,21 +56,108 @@ public:
      */
     EncoderStats getStats() const override;
     
+    /**
+     * @brief libavcodec encoder names worth trying for a codec, in order of preference
+     * @param codec "h264", "h265" or "av1"
+     * @param hardware true for GPU/ASIC encoders on this platform, false for software ones
+     */
+    static std::vector<std::string> candidateEncoders(const std::string& codec, bool hardware);
+    
+    /**
+     * @brief Like prepareFrame(), but the picture is downscaled from an
+     *        already converted one instead of converted from the capture
+     *
+     * frame still supplies the timestamp, sequence and dirty regions, so
+     * skipping and PTS behave as in prepareFrame(); its pixels are not read.
+     *
+     * @param source Picture of a larger rendition, see getPicture()
+     * @param frame The capture frame source was made from
+     * @param prepared Receives the picture, or null if the frame was skipped
+     * @return true if successful, false otherwise
+     */
+    bool prepareScaled(const PlanarImage& source, const capture::Frame& frame, PreparedFramePtr& prepared);
+    
+    /**
+     * @brief The YUV picture held by a prepared frame of an FFmpegEncoder
+     * @param prepared Frame from prepareFrame() or prepareScaled(); keep it
+     *                 alive while using picture
+     * @param picture Receives the planes
+     * @return false if prepared does not come from an FFmpegEncoder
+     */
+    static bool getPicture(const PreparedFramePtr& prepared, PlanarImage& picture);
+    
 private:
     // Helper methods
     bool initializeCodec(const EncoderConfig& config);
+    void applyRateControl(const EncoderConfig& config);
+    void applyLowLatency(const EncoderConfig& config);
+    bool initializePicture();
+    void initializeConversion(const EncoderConfig& config);
     bool initializeScaler(int srcWidth, int srcHeight, int srcFormat);
+    bool needsCodecRebuild(const EncoderConfig& config) const;
+    bool supportsRateReconfig(const EncoderConfig& config) const;
+    bool rebuildCodec(const EncoderConfig& config);
+    void releasePicture();
     void cleanupFFmpeg();
+    bool allocatePicture(AVFrame* frame);
+    bool makePictureWritable(bool preserveContent);
     bool convertFrame(const capture::Frame& frame, AVFrame* avFrame);
+    void convertBands(const capture::Frame& frame, AVFrame* avFrame);
+    bool canConvertIncrementally(const capture::Frame& frame) const;
+    void convertDirtyRects(const capture::Frame& frame, AVFrame* avFrame);
+    void recordConversionTime(float totalMs, bool fullFrame);
+    void attachRegionsOfInterest(const capture::Frame& frame, bool contiguous, AVFrame* avFrame);
     bool encodeAVFrame(AVFrame* frame);
+    EncodedPacketPtr wrapPacket(AVPacket* packet);
+    void recordLatency(const EncodedPacket& packet);
+    uint64_t takeCaptureTimestamp(int64_t pts);
+    bool finishPrepare(const capture::Frame& frame, bool contiguous, PreparedFramePtr& prepared);
+    bool shouldSkipFrame(const capture::Frame& frame);
+    void skipFrame(const capture::Frame& frame, bool contiguous);
+    bool convertPicture(const capture::Frame& frame);
+    int64_t nextPts(const capture::Frame& frame);
     
     // FFmpeg contexts
     AVCodecContext* m_codecContext;
     const AVCodec* m_codec;
     SwsContext* m_swsContext;
+    int m_scalerSrcWidth;            // Source the scaler was built for
+    int m_scalerSrcHeight;
+    int m_scalerSrcFormat;
+    ColorConverter m_colorConverter; // Same-size conversion, bypasses swscale
+    YuvScaler m_yuvScaler;           // prepareScaled() from a larger picture
+    std::unique_ptr<ThreadPool> m_conversionPool;
+    size_t m_conversionBands;
+    std::vector<float> m_bandMs;     // Per-band time of the current frame
+    
+    // m_frame still holds the previous picture, so dirty regions suffice
+    bool m_yuvValid;
+    capture::PixelFormat m_yuvSourceFormat;
+    uint64_t m_yuvSequence;
     AVFrame* m_frame;
+    AVBufferPool* m_picturePool;     // Buffers for m_frame while the codec holds older ones
     AVPacket* m_packet;
     
+    // prepareFrame() and encodePreparedFrame() may run on different threads;
+    // reconfigure() takes both to run between frames
+    std::mutex m_prepareMutex;
+    std::mutex m_encodeMutex;
+    uint64_t m_codecGeneration;      // Bumped when reconfigure() rebuilds the codec
+    
+    // Keyframes forced on top of the codec's own GOP (encode side)
+    int m_keyframeInterval;          // 0 = codec GOP only
+    int m_framesSinceKeyframe;
+    std::atomic<bool> m_keyframeRequested;
+    std::chrono::steady_clock::time_point m_lastRequestedKeyframe;
+    
+    // Encoded output, in decode order
+    std::mutex m_packetMutex;
+    std::deque<EncodedPacketPtr> m_packetQueue;
+    std::vector<EncodedPacketPtr> m_slices;
+    
+    // Capture timestamps of frames still inside the codec, keyed by PTS
+    std::deque<std::pair<int64_t, uint64_t>> m_pendingTimestamps;
+    
     // Configuration
     EncoderConfig m_config;
     
@@ -66,10 +165,23 @@ private:
     std::atomic<bool> m_initialized;
     mutable std::mutex m_statsMutex;
     EncoderStats m_stats;
+    std::chrono::steady_clock::time_point m_firstFrameTime;
+    std::chrono::steady_clock::time_point m_rateWindowStart;
+    uint64_t m_rateWindowBytes;
     
     // Frame management
     int64_t m_frameNumber;
     int64_t m_pts;
+    
+    // Frame rate and skipping (prepare side)
+    bool m_hasEncoded;
+    uint64_t m_firstTimestamp;        // Capture time of PTS 0
+    uint64_t m_lastEncodedTimestamp;
+    uint64_t m_nextDueTimestamp;      // Frames captured well before this are dropped
+    bool m_skippedChanges;            // m_frame holds changes of dropped frames not prepared yet
+    std::vector<capture::Rect> m_skippedRects; // Where they are, for the regions of interest
+    bool m_hasPicture;                // m_frame holds a converted picture to repeat
+    uint64_t m_lastSequence;          // Last frame handed to prepareFrame()
 };
 
 } // namespace encoder
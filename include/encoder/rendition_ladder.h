@@ -0,0 +1,103 @@
+#pragma once
+
+#include "encoder/video_encoder.h"
+#include "encoder/ffmpeg_encoder.h"
+#include "core/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace talos {
+namespace encoder {
+
+/**
+ * @brief Main stream plus lower-resolution sub-streams from one capture
+ *
+ * The main rung converts the captured frame as a plain FFmpegEncoder
+ * would. Every lower rung (EncoderConfig::renditions) scales the YUV
+ * picture of the rung above it with YuvScaler, so the frame is converted
+ * from RGB once, and each sub-stream adds a downscale and its own encode.
+ * The rungs are encoded in parallel.
+ *
+ * Packets carry streamId (main) and streamId + 1, + 2, ... for the
+ * renditions, so the publisher can offer each as its own stream path.
+ * Keyframe requests can target one stream or all of them.
+ */
+class RenditionLadder : public VideoEncoder {
+public:
+    RenditionLadder();
+    ~RenditionLadder() override;
+
+    // VideoEncoder interface
+    bool initialize(const EncoderConfig& config) override;
+    void shutdown() override;
+    ReconfigureResult reconfigure(const EncoderConfig& config) override;
+    bool encodeFrame(const capture::Frame& frame) override;
+    bool prepareFrame(const capture::Frame& frame, PreparedFramePtr& prepared) override;
+    bool prepareKeepAlive(uint64_t timestamp, PreparedFramePtr& prepared) override;
+    uint64_t pendingChangesDue() override;
+    bool encodePreparedFrame(const PreparedFramePtr& prepared) override;
+    void requestKeyframe() override;
+    bool isInitialized() const override { return m_initialized; }
+    bool getEncodedPacket(EncodedPacketPtr& packet) override;
+
+    /**
+     * @brief Statistics of the main stream, with byte, packet and bitrate
+     *        figures summed over all renditions
+     */
+    EncoderStats getStats() const override;
+
+    /**
+     * @brief Ask for an IDR frame on one stream only, e.g. for a client
+     *        joining a sub-stream
+     * @param streamId EncodedPacket::streamId of the stream
+     */
+    void requestKeyframe(int streamId);
+
+    /**
+     * @brief Statistics of one stream
+     * @param streamId EncodedPacket::streamId of the stream
+     * @param stats Receives the statistics
+     * @return false if there is no such stream
+     */
+    bool getStreamStats(int streamId, EncoderStats& stats) const;
+
+    /**
+     * @brief Configuration each stream was opened with, main stream first
+     */
+    std::vector<EncoderConfig> getStreams() const;
+
+private:
+    static bool rungConfigs(const EncoderConfig& config, std::vector<EncoderConfig>& rungs);
+    bool createRungs(const std::vector<EncoderConfig>& rungs);
+    void flushRungs();
+    void collectPackets();
+
+    std::vector<std::unique_ptr<FFmpegEncoder>> m_rungs;
+    std::vector<EncoderConfig> m_rungConfigs;
+    mutable std::mutex m_rungsMutex;  // Guards replacing m_rungs against the stats getters
+    std::unique_ptr<ThreadPool> m_encodePool;
+
+    // Same split as FFmpegEncoder; reconfigure() takes both
+    std::mutex m_prepareMutex;
+    std::mutex m_encodeMutex;
+    uint64_t m_generation;            // Bumped when the rungs are rebuilt
+    uint64_t m_lastSequence;          // Last frame handed to prepareFrame()
+
+    // Packets of all rungs, grouped by frame
+    std::mutex m_packetMutex;
+    std::deque<EncodedPacketPtr> m_packetQueue;
+
+    EncoderConfig m_config;
+    std::atomic<bool> m_initialized;
+
+    mutable std::mutex m_statsMutex;
+    uint64_t m_keyframeRequests;
+    float m_encodeMs;                 // Wall time of one parallel encode (smoothed)
+};
+
+} // namespace encoder
+} // namespace talos
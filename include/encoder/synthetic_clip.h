@@ -0,0 +1,53 @@
+#pragma once
+
+#include "capture/capture_engine.h"
+#include <cstdint>
+
+namespace talos {
+namespace encoder {
+
+/**
+ * @brief Deterministic desktop-like clip: a text window that is typed into
+ *        and scrolled, a moving cursor, and a window switch every kSceneLength frames
+ *
+ * Frames are stamped one frame interval apart however fast they are
+ * rendered, so the encoder's frame rate gate lets every one through. Every
+ * frame lists its dirty regions, like a capture engine's would. Used by the
+ * encoder autotuner and the encoder benchmarks.
+ */
+class SyntheticClip {
+public:
+    static constexpr int kSceneLength = 60;
+
+    SyntheticClip(int width, int height, int framerate);
+
+    /**
+     * @brief Draw frame index into frame; frames must be rendered in order
+     *        from 0, into the same Frame
+     */
+    void render(int index, capture::Frame& frame);
+
+private:
+    uint32_t random();
+    uint8_t* pixel(capture::Frame& frame, int x, int y);
+    void fillRect(capture::Frame& frame, const capture::Rect& rect, uint32_t color);
+    void drawScene(int scene, capture::Frame& frame);
+    void typeGlyphs(capture::Frame& frame, int count);
+    void scrollText(capture::Frame& frame);
+    void toggleCursor(capture::Frame& frame);
+
+    int m_width;
+    int m_height;
+    uint64_t m_intervalUs;
+    uint64_t m_startUs;
+    uint32_t m_seed;
+    capture::Rect m_window;
+    capture::Rect m_text;
+    int m_caretColumn;
+    int m_caretRow;
+    int m_cursorX;
+    int m_cursorY;
+};
+
+} // namespace encoder
+} // namespace talos
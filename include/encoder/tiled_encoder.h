@@ -0,0 +1,117 @@
+#pragma once
+
+#include "encoder/video_encoder.h"
+#include "capture/capture_engine.h"
+#include "core/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace talos {
+namespace encoder {
+
+/**
+ * @brief Position of one tile stream in the canvas
+ */
+struct TileInfo {
+    int streamId;        // EncodedPacket::streamId of the tile's packets
+    capture::Rect rect;  // In encoder (EncoderConfig width/height) coordinates
+};
+
+/**
+ * @brief Encodes a canvas too large for one encoder as a grid of streams
+ *
+ * The frame is split into tileColumns x tileRows tiles on 16-pixel
+ * boundaries. Each tile gets its own FFmpegEncoder, fed a view into the
+ * captured frame, and the tiles are converted and encoded in parallel on
+ * one thread each. Packets carry the tile's streamId so the publisher can
+ * send every tile as a separate track.
+ *
+ * The tiles stay aligned: every tile sees every frame with the same
+ * timestamp, scene-cut keyframes are disabled, and keyframe requests are
+ * applied to all tiles on the same frame. A client can therefore start
+ * all tracks at one keyframe and present them side by side by PTS.
+ */
+class TiledEncoder : public VideoEncoder {
+public:
+    TiledEncoder();
+    ~TiledEncoder() override;
+
+    // VideoEncoder interface
+    bool initialize(const EncoderConfig& config) override;
+    void shutdown() override;
+    ReconfigureResult reconfigure(const EncoderConfig& config) override;
+    bool encodeFrame(const capture::Frame& frame) override;
+    bool prepareFrame(const capture::Frame& frame, PreparedFramePtr& prepared) override;
+    bool prepareKeepAlive(uint64_t timestamp, PreparedFramePtr& prepared) override;
+    uint64_t pendingChangesDue() override;
+    bool encodePreparedFrame(const PreparedFramePtr& prepared) override;
+    void requestKeyframe() override;
+    bool isInitialized() const override { return m_initialized; }
+    bool getEncodedPacket(EncodedPacketPtr& packet) override;
+
+    /**
+     * @brief Get statistics summed over the tiles
+     *
+     * Byte, packet and bitrate figures are totals; frame counts are per
+     * tile (they are equal); latency and fps are those of the slowest tile.
+     * conversionBandMs holds the conversion time of each tile.
+     */
+    EncoderStats getStats() const override;
+
+    /**
+     * @brief Current tiles, in streamId order
+     */
+    std::vector<TileInfo> getTiles() const;
+
+    /**
+     * @brief Split a canvas into a grid on 16-pixel boundaries
+     * @return Tiles row by row, or empty if a tile would be narrower or lower than 16 pixels
+     */
+    static std::vector<capture::Rect> layoutTiles(int width, int height, int columns, int rows);
+
+private:
+    EncoderConfig tileConfig(const EncoderConfig& config, const capture::Rect& rect, int streamId) const;
+    bool createTiles(const EncoderConfig& config, const std::vector<capture::Rect>& rects);
+    void destroyTiles();
+    void flushTiles();
+    void collectPackets();
+    void makeView(const capture::Frame& frame, size_t tile);
+
+    // One encoder, rectangle and frame view per tile
+    std::vector<std::unique_ptr<VideoEncoder>> m_tiles;
+    std::vector<capture::Rect> m_rects;
+    std::vector<std::unique_ptr<capture::Frame>> m_views;
+    mutable std::mutex m_tilesMutex;  // Guards replacing m_tiles against getStats()
+
+    // Separate pools so converting one frame overlaps encoding the previous
+    std::unique_ptr<ThreadPool> m_preparePool;
+    std::unique_ptr<ThreadPool> m_encodePool;
+
+    // Same split as FFmpegEncoder; reconfigure() takes both
+    std::mutex m_prepareMutex;
+    std::mutex m_encodeMutex;
+    uint64_t m_generation;            // Bumped when the tiles are rebuilt
+
+    // Requests are spaced here and handed to all tiles between frames
+    std::atomic<bool> m_keyframeRequested;
+    std::chrono::steady_clock::time_point m_lastRequestedKeyframe;
+
+    // Packets of all tiles, grouped by frame
+    std::mutex m_packetMutex;
+    std::deque<EncodedPacketPtr> m_packetQueue;
+
+    EncoderConfig m_config;
+    std::atomic<bool> m_initialized;
+
+    mutable std::mutex m_statsMutex;
+    uint64_t m_keyframeRequests;
+    uint64_t m_requestedKeyframes;
+    float m_encodeMs;                 // Wall time of one parallel encode (smoothed)
+};
+
+} // namespace encoder
+} // namespace talos
@@ -4,6 +4,7 @@
 #include <memory>
 #include <cstdint>
 #include "encoder/encoder_types.h"
+#include "encoder/encoded_packet.h"
 
 namespace talos {
 
@@ -12,6 +13,26 @@ namespace capture {
     struct Frame;
 }
 
+namespace encoder {
+
+/**
+ * @brief A converted picture waiting to be encoded
+ *
+ * Produced by VideoEncoder::prepareFrame() and consumed by
+ * encodePreparedFrame(). Each encoder derives its own type holding the
+ * picture; the capture frame is no longer needed once this exists.
+ */
+struct PreparedFrame {
+    virtual ~PreparedFrame() = default;
+    
+    int64_t pts = 0;                // Presentation timestamp in codec time base
+    uint64_t captureTimestamp = 0;  // Frame::timestamp of the source frame
+};
+
+using PreparedFramePtr = std::shared_ptr<PreparedFrame>;
+
+} // namespace encoder
+
 /**
  * @brief Video encoder interface
  */
@@ -39,6 +60,19 @@ public:
      */
     virtual void shutdown() = 0;
     
+    /**
+     * @brief Apply a new configuration to a running encoder
+     *
+     * Settings the codec can change on the fly are applied in place; only
+     * the parts affected by the rest are rebuilt. Packets the codec still
+     * held are queued before a rebuild, so nothing is lost. Safe to call
+     * between frames from any thread.
+     *
+     * @param config New configuration
+     * @return Whether it succeeded and whether a keyframe was forced
+     */
+    virtual encoder::ReconfigureResult reconfigure(const encoder::EncoderConfig& config) = 0;
+    
     /**
      * @brief Encode a captured frame
      * @param frame The frame to encode
@@ -46,6 +80,61 @@ public:
      */
     virtual bool encodeFrame(const capture::Frame& frame) = 0;
     
+    /**
+     * @brief Convert a captured frame into the encoder's picture format
+     *
+     * First half of encodeFrame(). It may run on a different thread than
+     * encodePreparedFrame(), so converting the next frame can overlap
+     * encoding the current one; calls to each half must stay in order.
+     *
+     * @param frame The frame to convert
+     * @param prepared Receives the picture, or null if the frame was skipped
+     * @return true if successful, false otherwise
+     */
+    virtual bool prepareFrame(const capture::Frame& frame, encoder::PreparedFramePtr& prepared) = 0;
+    
+    /**
+     * @brief Repeat the last picture when capture has gone quiet
+     *
+     * Damage-driven capture engines deliver nothing while the screen is
+     * static, so the caller polls this whenever no frame arrived for a
+     * while. The picture is prepared again once keepAliveMs have passed
+     * since the last one, or as soon as framerate allows if it holds
+     * changes of frames dropped above framerate. Same threading rules as
+     * prepareFrame().
+     *
+     * @param timestamp Current time on the capture clock (steady clock, microseconds)
+     * @param prepared Receives the picture, or null if none is due
+     * @return true if successful, false otherwise
+     */
+    virtual bool prepareKeepAlive(uint64_t timestamp, encoder::PreparedFramePtr& prepared) = 0;
+    
+    /**
+     * @brief When prepareKeepAlive() will send changes of dropped frames
+     *
+     * Lets the caller wait one frame interval rather than its usual poll
+     * period for them. Same threading rules as prepareFrame().
+     *
+     * @return Capture-clock time in microseconds, or 0 if no changes are pending
+     */
+    virtual uint64_t pendingChangesDue() = 0;
+    
+    /**
+     * @brief Encode a picture from prepareFrame()
+     * @param prepared The picture to encode
+     * @return true if successful, false otherwise
+     */
+    virtual bool encodePreparedFrame(const encoder::PreparedFramePtr& prepared) = 0;
+    
+    /**
+     * @brief Ask for an IDR frame, e.g. for a joining client or after picture loss
+     *
+     * Requests coalesce: every request made before the next keyframe is
+     * answered by it, and forced keyframes are spaced at least
+     * keyframeRequestIntervalMs apart. Safe to call from any thread.
+     */
+    virtual void requestKeyframe() = 0;
+    
     /**
      * @brief Check if encoder is initialized
      * @return true if initialized, false otherwise
@@ -53,11 +142,17 @@ public:
     virtual bool isInitialized() const = 0;
     
     /**
-     * @brief Get the next encoded packet
-     * @param packet Output buffer for encoded data
-     * @return true if packet is available, false otherwise
+     * @brief Take the next encoded packet from the output queue
+     *
+     * Packets come out in decode order. Every packet the codec produced is
+     * queued, so call this until it returns false after each encodeFrame().
+     * The packet shares the codec's buffer; hand the pointer to as many
+     * consumers as needed instead of copying the data.
+     *
+     * @param packet Receives the packet
+     * @return true if a packet was available, false otherwise
      */
-    virtual bool getEncodedPacket(std::vector<uint8_t>& packet) = 0;
+    virtual bool getEncodedPacket(encoder::EncodedPacketPtr& packet) = 0;
     
     /**
      * @brief Get encoder statistics
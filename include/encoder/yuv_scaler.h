@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace talos {
+namespace encoder {
+
+/**
+ * @brief Planes of a YUV 4:2:0 planar (I420) picture
+ *
+ * Does not own the memory. Chroma planes are (width + 1) / 2 by
+ * (height + 1) / 2.
+ */
+struct PlanarImage {
+    uint8_t* data[3] = {nullptr, nullptr, nullptr};
+    int linesize[3] = {0, 0, 0};
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * @brief Downscales I420 pictures for lower renditions
+ *
+ * An exact 2:1 reduction uses a 2x2 box filter; any other size uses
+ * bilinear interpolation. Both work on rows with SSE2 or NEON where
+ * available (the baseline instruction sets of x86-64 and AArch64, so no
+ * runtime dispatch is needed) and produce the same output as the scalar
+ * code. Bilinear sampling aliases beyond about 2:1, so a ladder should
+ * scale each rung from the one above rather than from the full picture.
+ */
+class YuvScaler {
+public:
+    YuvScaler() = default;
+
+    /**
+     * @brief Scale src into dst, which must already be allocated at its size
+     * @return false if either picture has no pixels or dst is larger than src
+     */
+    bool scale(const PlanarImage& src, const PlanarImage& dst);
+
+    /**
+     * @brief Name of the row kernels in use ("sse2", "neon" or "scalar")
+     */
+    static const char* kernelName();
+
+private:
+    void scalePlane(const uint8_t* src, int srcStride, int srcWidth, int srcHeight,
+                    uint8_t* dst, int dstStride, int dstWidth, int dstHeight);
+
+    // Reused between calls to avoid per-frame allocation
+    std::vector<int> m_columns;         // Left source column of each output column
+    std::vector<uint8_t> m_columnWeights; // Weight of the right column, 0..255
+    std::vector<uint8_t> m_row;         // Vertically interpolated source row
+};
+
+} // namespace encoder
+} // namespace talos
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "encoder/encoded_packet.h"
+#include "core/wait_event.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace talos {
+namespace network {
+
+/**
+ * @brief Bounds of one client's send queue
+ */
+struct SendQueueConfig {
+    size_t highWatermarkBytes = 4 * 1024 * 1024;  // Above this the client is shed
+    size_t lowWatermarkBytes = 1024 * 1024;       // Shedding stops once the queue drains below this
+    size_t maxPackets = 2048;                     // Counts against the high watermark as well
+};
+
+/**
+ * @brief Counters of one client's send queue
+ */
+struct SendQueueStats {
+    uint64_t packetsQueued = 0;
+    uint64_t packetsSent = 0;          // Taken by the sender
+    uint64_t disposableDropped = 0;    // Non-reference frames discarded while shedding
+    uint64_t gopDropped = 0;           // Packets discarded while skipping to the next keyframe
+    uint64_t keyframeSkips = 0;        // Times the queue was emptied to wait for a keyframe
+    uint64_t keyframeRequests = 0;
+    size_t queuedPackets = 0;
+    size_t queuedBytes = 0;
+    size_t peakBytes = 0;
+};
+
+/**
+ * @brief Bounded queue between a session's packet source and its socket
+ *
+ * A client that cannot keep up must not add latency or memory for anyone
+ * else, so instead of growing, the queue sheds in two steps once it goes
+ * above the high watermark:
+ *  1. queued and incoming non-reference frames (EncodedPacket::disposable)
+ *     are discarded, which no other frame depends on;
+ *  2. if that is not enough, everything queued is dropped and each stream
+ *     resumes at its next keyframe. A keyframe is requested unless the
+ *     packet that overflowed was one, at most once until it arrives.
+ * Disposable frames keep being discarded until the queue drains below the
+ * low watermark. The queue never holds more than the high watermark plus
+ * one packet.
+ *
+ * Fed from a PacketFanout reader, emptied by the session's sender. All
+ * methods are thread-safe.
+ */
+class ClientSendQueue {
+public:
+    explicit ClientSendQueue(const SendQueueConfig& config = SendQueueConfig());
+
+    ClientSendQueue(const ClientSendQueue&) = delete;
+    ClientSendQueue& operator=(const ClientSendQueue&) = delete;
+
+    /**
+     * @brief Set the callback that asks the encoder for a keyframe
+     * @param handler Typically bound to VideoEncoder::requestKeyframe()
+     */
+    void setKeyframeRequestHandler(std::function<void()> handler);
+
+    /**
+     * @brief Queue a packet for sending
+     * @return false if the packet was dropped
+     */
+    bool push(const encoder::EncodedPacketPtr& packet);
+
+    /**
+     * @brief Take queued packets, without blocking
+     * @param packets Receives the packets, appended in order
+     * @param maxPackets Upper bound on packets appended
+     * @return Number of packets appended
+     */
+    size_t take(std::vector<encoder::EncodedPacketPtr>& packets, size_t maxPackets);
+
+    /**
+     * @brief Sleep until there is something to take
+     * @return true if packets are queued, false on timeout or close()
+     */
+    bool waitForPackets(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Wake the sender; waitForPackets() returns false from now on
+     */
+    void close();
+
+    SendQueueStats getStats() const;
+
+private:
+    bool overHigh(size_t incoming) const;
+    void dropDisposable();
+    void dropToKeyframe();
+    void requestKeyframe();
+
+    SendQueueConfig m_config;
+
+    mutable std::mutex m_mutex;
+    std::deque<encoder::EncodedPacketPtr> m_queue;
+    size_t m_bytes;
+    bool m_shedding;                 // Between crossing the high and draining below the low watermark
+    bool m_keyframeRequested;        // Outstanding until a keyframe is queued
+    std::unordered_set<int> m_synced; // Streams queued from a keyframe on
+    bool m_closed;
+    SendQueueStats m_stats;
+
+    std::function<void()> m_keyframeRequestHandler;
+    WaitEvent m_queued;
+};
+
+} // namespace network
+} // namespace talos
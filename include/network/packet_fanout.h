@@ -0,0 +1,159 @@
+#pragma once
+
+#include "encoder/encoded_packet.h"
+#include "core/wait_event.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace talos {
+namespace network {
+
+/**
+ * @brief Per-client delivery counters
+ */
+struct FanoutClientStats {
+    uint64_t packetsRead = 0;
+    uint64_t packetsSkipped = 0;    // Lost to overruns or passed over while waiting for a keyframe
+    uint64_t overruns = 0;          // Times the client fell a whole ring behind
+    uint64_t primedPackets = 0;     // Cached GOP packets that were already published when it joined
+};
+
+/**
+ * @brief Hub counters
+ */
+struct FanoutStats {
+    uint64_t packetsPublished = 0;
+    size_t clients = 0;
+    uint64_t overruns = 0;          // Summed over all clients, including removed ones
+    uint64_t keyframeRequests = 0;  // Raised for joining or resynchronising clients
+    uint64_t primedJoins = 0;       // Clients started from the cached GOP
+};
+
+/**
+ * @brief Where a new client starts
+ */
+enum class JoinMode {
+    Burst,          // At the newest cached keyframe; the rest of the GOP follows at once so the client catches up
+    NextKeyframe    // At the next keyframe, which is requested from the encoder
+};
+
+/**
+ * @brief Feeds one encoded stream to any number of sessions
+ *
+ * The encoder output is published once into a ring of shared packets. Each
+ * client only keeps a cursor into the ring and reads the same
+ * EncodedPacketPtr as everyone else, so a client costs a cursor and its
+ * socket sends, never an encoder or a copy of the data.
+ *
+ * The ring doubles as a GOP cache. A client joining in Burst mode starts
+ * at the newest keyframe in the ring, which carries the parameter sets
+ * in-band, and reads the rest of that GOP in one go. It can show a picture
+ * after one round trip, without the encoder emitting an extra IDR. A client
+ * that falls more than the ring behind is restarted the same way. Only
+ * when the ring holds no keyframe (a GOP longer than the ring) does the
+ * client wait for the next one, and the keyframe request handler is called
+ * so that wait is short. A client never decodes from a broken reference
+ * chain: per stream, delivery starts at a keyframe.
+ *
+ * publish() is meant to be a VideoEncodingPipeline sink. All methods are
+ * thread-safe; each client should be read from one thread at a time.
+ */
+class PacketFanout {
+public:
+    using ClientId = uint64_t;
+
+    static constexpr int kAllStreams = -1;
+
+    /**
+     * @param capacity Packets kept in the ring; should cover a whole GOP
+     *                 (all slices of all streams) for Burst joins to work.
+     *                 They hold their buffers alive.
+     */
+    explicit PacketFanout(size_t capacity = 512);
+
+    PacketFanout(const PacketFanout&) = delete;
+    PacketFanout& operator=(const PacketFanout&) = delete;
+
+    /**
+     * @brief Set the callback that asks the encoder for a keyframe
+     * @param handler Typically bound to VideoEncoder::requestKeyframe()
+     */
+    void setKeyframeRequestHandler(std::function<void()> handler);
+
+    /**
+     * @brief Append a packet for every client
+     */
+    void publish(const encoder::EncodedPacketPtr& packet);
+
+    /**
+     * @brief Register a session
+     * @param streamId Only deliver packets of this EncodedPacket::streamId,
+     *                 or kAllStreams
+     * @param mode Start from the cached GOP or wait for a fresh keyframe
+     * @return Id for the other client calls
+     */
+    ClientId addClient(int streamId = kAllStreams, JoinMode mode = JoinMode::Burst);
+
+    /**
+     * @brief Unregister a session; its cursor no longer holds anything
+     */
+    void removeClient(ClientId client);
+
+    /**
+     * @brief Take the packets the client has not read yet, without blocking
+     * @param client Client to read for
+     * @param packets Receives the packets, appended in order
+     * @param maxPackets Upper bound on packets appended
+     * @return Number of packets appended
+     */
+    size_t read(ClientId client, std::vector<encoder::EncodedPacketPtr>& packets, size_t maxPackets);
+
+    /**
+     * @brief Sleep until the client has something to read
+     * @return true if packets are available, false on timeout, close() or unknown client
+     */
+    bool waitForPackets(ClientId client, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Wake every waiting client; waitForPackets() returns false from now on
+     */
+    void close();
+
+    FanoutStats getStats() const;
+    bool getClientStats(ClientId client, FanoutClientStats& stats) const;
+
+private:
+    struct Client {
+        uint64_t cursor = 0;            // Sequence number of the next packet to read
+        int streamId = kAllStreams;
+        std::unordered_set<int> synced; // Streams delivered from a keyframe on
+        FanoutClientStats stats;
+    };
+
+    bool wants(const Client& client, const encoder::EncodedPacket& packet) const;
+    uint64_t oldestSequence() const;
+    bool primeFromCache(Client& client);
+    void requestKeyframe();
+
+    mutable std::mutex m_mutex;
+    std::vector<encoder::EncodedPacketPtr> m_ring;
+    uint64_t m_head;                    // Sequence number of the next packet published
+    std::unordered_map<int, uint64_t> m_lastKeyframe; // Per stream, sequence number of its newest keyframe
+    bool m_gopOverflowReported;
+    std::unordered_map<ClientId, Client> m_clients;
+    ClientId m_nextClient;
+    bool m_closed;
+    FanoutStats m_stats;
+
+    std::function<void()> m_keyframeRequestHandler;
+    WaitEvent m_published;
+};
+
+} // namespace network
+} // namespace talos
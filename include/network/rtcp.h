@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace talos {
+namespace network {
+
+/**
+ * @brief Keyframe requests for one stream found in an RTCP compound packet
+ */
+struct RtcpKeyframeRequest {
+    bool pictureLoss = false;       // PLI (RFC 4585)
+    bool fullIntraRequest = false;  // FIR (RFC 5104, or the RFC 2032 form)
+    uint32_t senderSsrc = 0;        // Client that sent the feedback
+    uint8_t firSequence = 0;        // Sequence number of the FIR entry for the stream
+
+    bool any() const { return pictureLoss || fullIntraRequest; }
+};
+
+/**
+ * @brief Scan an RTCP compound packet for PLI and FIR feedback on one stream
+ *
+ * Only feedback addressed to mediaSsrc counts: a PLI whose media source
+ * SSRC matches it, or the FIR entry that names it. A FIR may carry entries
+ * for several streams of the session; the others are ignored. Receiver
+ * reports, SDES and other feedback are skipped. A malformed packet stops
+ * the scan; requests found before it are still reported. A FIR repeats its
+ * sequence number when retransmitted (RFC 5104 4.3.1.2), so the caller
+ * should only act on a new firSequence per client.
+ *
+ * @param data RTCP packet
+ * @param size Length in bytes
+ * @param mediaSsrc SSRC of the served stream
+ * @param request Receives what was found
+ * @return true if the packet asks for a keyframe
+ */
+bool parseRtcpKeyframeRequest(const uint8_t* data, size_t size, uint32_t mediaSsrc,
+                              RtcpKeyframeRequest& request);
+
+} // namespace network
+} // namespace talos
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "encoder/encoded_packet.h"
+#include "network/udp_batch_sender.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace talos {
+namespace network {
+
+/**
+ * @brief RTP packetization-mode of the H.264/H.265 payload format
+ */
+enum class RtpPacketization {
+    SingleNal,      // packetization-mode=0: one NAL unit per packet, none may exceed it
+    NonInterleaved  // packetization-mode=1: single NAL, STAP-A/AP and FU-A/FU
+};
+
+/**
+ * @brief Packetizer settings, fixed for the RTP session
+ */
+struct RtpPacketizerConfig {
+    bool hevc = false;              // RFC 7798 instead of RFC 6184
+    uint8_t payloadType = 96;
+    uint32_t ssrc = 0;
+    size_t maxPacketSize = 1400;    // RTP header included; keep below the path MTU
+    RtpPacketization mode = RtpPacketization::NonInterleaved;
+    bool aggregate = true;          // Combine small NAL units (parameter sets, SEI) into STAP-A/AP
+};
+
+/**
+ * @brief Turns encoded access units into RTP packets without copying the payload
+ *
+ * Each RTP packet is a list of UdpBuffer pieces: the RTP header and any
+ * STAP-A/AP or FU-A/FU headers live in a small scratch buffer of the
+ * packetizer, every payload byte is read straight out of the shared
+ * EncodedPacket. packetize() holds a reference to the packet, so the
+ * pieces stay valid until the next packetize() or release(), and can be
+ * handed to UdpBatchSender::queue() for every client of the session.
+ *
+ * NAL units that fit are sent as single NAL unit packets, or aggregated
+ * when several small ones fit together; larger ones are fragmented into
+ * FU-A (H.264) or FU (H.265) packets of maxPacketSize. The marker bit is
+ * set on the last packet of an access unit.
+ *
+ * One packetizer per RTP session: clients sharing a session share its
+ * SSRC and sequence numbers, which is what lets the packetization be done
+ * once. Not thread-safe.
+ */
+class RtpPacketizer {
+public:
+    explicit RtpPacketizer(const RtpPacketizerConfig& config);
+
+    RtpPacketizer(const RtpPacketizer&) = delete;
+    RtpPacketizer& operator=(const RtpPacketizer&) = delete;
+
+    /**
+     * @brief Packetize one access unit or slice
+     * @param packet Encoded packet with parsed nalUnits
+     * @param timestamp RTP timestamp, e.g. from timestamp90kHz()
+     * @return false if the packet cannot be sent in the configured mode;
+     *         no packets are produced then
+     */
+    bool packetize(const encoder::EncodedPacketPtr& packet, uint32_t timestamp);
+
+    /**
+     * @brief Drop the reference to the last packetized packet
+     */
+    void release();
+
+    /**
+     * @brief RTP packets produced by the last packetize()
+     */
+    size_t packetCount() const { return m_packets.size(); }
+
+    /**
+     * @brief Pieces of one RTP packet, to be sent back to back
+     * @param index Packet index below packetCount()
+     * @param count Receives the number of pieces
+     * @return First piece
+     */
+    const UdpBuffer* packetPieces(size_t index, size_t& count) const;
+
+    /**
+     * @brief Size of one RTP packet in bytes, header included
+     */
+    size_t packetSize(size_t index) const { return m_packets[index].size; }
+
+    /**
+     * @brief Sequence number the next packet will get
+     */
+    uint16_t nextSequence() const { return m_sequence; }
+    void setNextSequence(uint16_t sequence) { m_sequence = sequence; }
+
+    const RtpPacketizerConfig& getConfig() const { return m_config; }
+
+    /**
+     * @brief Packet pts converted to the 90 kHz video clock
+     */
+    static uint32_t timestamp90kHz(const encoder::EncodedPacket& packet);
+
+private:
+    // A piece either points into the encoded packet or lies in m_scratch,
+    // which may still grow while the packets are built
+    struct Piece {
+        const uint8_t* data;
+        size_t scratchOffset;
+        size_t size;
+    };
+
+    struct Packet {
+        size_t header;      // Offset of the RTP header in m_scratch
+        size_t firstPiece;
+        size_t pieces;
+        size_t size;
+    };
+
+    void beginPacket(uint32_t timestamp);
+    uint8_t* addScratch(size_t size);
+    void addPayload(const uint8_t* data, size_t size);
+    void emitSingle(const uint8_t* nal, size_t size, uint32_t timestamp);
+    void emitAggregate(const std::vector<encoder::NalUnit>& units, size_t first, size_t count,
+                       const uint8_t* data, uint32_t timestamp);
+    void emitFragments(const uint8_t* nal, size_t size, uint32_t timestamp);
+    void clear();
+
+    RtpPacketizerConfig m_config;
+    uint16_t m_sequence;
+
+    encoder::EncodedPacketPtr m_packet;
+    std::vector<uint8_t> m_scratch;
+    std::vector<Piece> m_layout;
+    std::vector<UdpBuffer> m_pieces;
+    std::vector<Packet> m_packets;
+};
+
+} // namespace network
+} // namespace talos
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 
 namespace talos {
@@ -35,6 +36,17 @@ public:
      * @return Number of active client connections
      */
     virtual int getClientCount() const = 0;
+    
+    /**
+     * @brief Set the callback that asks the encoder for a keyframe
+     *
+     * Called when a client starts playing and when a client reports picture
+     * loss through RTCP PLI or FIR (see parseRtcpKeyframeRequest()). The
+     * encoder coalesces the requests, so the server forwards every one.
+     *
+     * @param handler Typically bound to VideoEncoder::requestKeyframe()
+     */
+    virtual void setKeyframeRequestHandler(std::function<void()> handler) = 0;
 };
 
 } // namespace talos
\ No newline at end of file
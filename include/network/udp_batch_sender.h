@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(PLATFORM_LINUX)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+namespace talos {
+namespace network {
+
+/**
+ * @brief Numeric IPv4 or IPv6 destination, resolved once per client
+ */
+struct UdpAddress {
+    alignas(8) unsigned char storage[28] = {};  // sockaddr_in or sockaddr_in6
+    uint32_t length = 0;
+
+    /**
+     * @brief Parse a numeric address, e.g. "192.168.1.20" or "fe80::1"
+     * @return false if host is not a numeric address
+     */
+    static bool parse(const std::string& host, uint16_t port, UdpAddress& address);
+
+    bool isIpv6() const;
+    bool operator==(const UdpAddress& other) const;
+};
+
+/**
+ * @brief One piece of a datagram; pieces are sent back to back
+ */
+struct UdpBuffer {
+    const void* data = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * @brief Send counters
+ */
+struct UdpSendStats {
+    uint64_t datagramsSent = 0;
+    uint64_t bytesSent = 0;
+    uint64_t datagramsDropped = 0;  // Socket buffer full or send error
+    uint64_t systemCalls = 0;
+    uint64_t gsoMessages = 0;       // Messages the kernel split into several datagrams
+};
+
+/**
+ * @brief Sends many UDP datagrams with few system calls
+ *
+ * Datagrams are queued with queue() and go out on flush(), typically once
+ * per access unit. On Linux a flush is one sendmmsg() per up to maxBatch
+ * messages, and runs of equal-sized datagrams to one destination (the FU-A
+ * fragments of a frame) become a single UDP_SEGMENT message that the
+ * kernel or NIC splits, so a 4K keyframe costs a handful of system calls
+ * instead of one sendto() per packet. GSO is probed at open() and switched
+ * off for good if the route rejects it. Other platforms send the queued
+ * datagrams one call each.
+ *
+ * Datagrams are gathered from UdpBuffer pieces, so an RTP header and a
+ * slice of the encoded packet need not be copied together. The pieces
+ * must stay valid until flush() returns.
+ *
+ * The socket is non-blocking: when its buffer is full the rest of the
+ * batch is dropped and counted, as late RTP is useless anyway. Not
+ * thread-safe; use one sender per network thread.
+ */
+class UdpBatchSender {
+public:
+    /**
+     * @param maxBatch Messages per sendmmsg() call
+     */
+    explicit UdpBatchSender(size_t maxBatch = 64);
+    ~UdpBatchSender();
+
+    UdpBatchSender(const UdpBatchSender&) = delete;
+    UdpBatchSender& operator=(const UdpBatchSender&) = delete;
+
+    /**
+     * @brief Create the socket
+     * @param ipv6 Address family of the destinations
+     * @param localPort Port to bind, 0 for any
+     * @param sendBufferBytes SO_SNDBUF to request, 0 to keep the default
+     * @return true if successful, false otherwise
+     */
+    bool open(bool ipv6 = false, uint16_t localPort = 0, int sendBufferBytes = 4 * 1024 * 1024);
+
+    /**
+     * @brief Close the socket; queued datagrams are discarded
+     */
+    void close();
+
+    bool isOpen() const { return m_socket != kInvalidSocket; }
+
+    /**
+     * @brief Whether runs of datagrams go out as UDP_SEGMENT messages
+     */
+    bool gsoEnabled() const { return m_gso; }
+
+    /**
+     * @brief Send every datagram as its own message from now on, e.g. to
+     *        compare against GSO; open() probes it again
+     */
+    void disableGso() { m_gso = false; }
+
+    /**
+     * @brief Queue one datagram
+     * @param to Destination, of the family the socket was opened with
+     * @param pieces Datagram contents, gathered in order
+     * @param count Number of pieces
+     * @return false if the datagram was rejected (empty, too large or wrong family)
+     */
+    bool queue(const UdpAddress& to, const UdpBuffer* pieces, size_t count);
+
+    /**
+     * @brief Send everything queued
+     * @return Number of datagrams sent
+     */
+    size_t flush();
+
+    size_t pendingDatagrams() const { return m_pending.size(); }
+
+    UdpSendStats getStats() const { return m_stats; }
+
+private:
+#if defined(PLATFORM_WINDOWS)
+    using Socket = uintptr_t;
+    static constexpr Socket kInvalidSocket = ~static_cast<Socket>(0);
+#else
+    using Socket = int;
+    static constexpr Socket kInvalidSocket = -1;
+#endif
+
+    struct Datagram {
+        size_t address;     // Index into m_addresses
+        size_t firstPiece;  // Index into m_pieces
+        size_t pieces;
+        size_t size;
+    };
+
+#if defined(PLATFORM_LINUX)
+    size_t sendBatch(size_t first);
+    size_t gsoRun(size_t first) const;
+#else
+    int sendOne(const Datagram& datagram);
+#endif
+
+    Socket m_socket;
+    bool m_ipv6;
+    bool m_gso;
+    size_t m_maxBatch;
+
+    std::vector<UdpAddress> m_addresses;
+    std::vector<UdpBuffer> m_pieces;
+    std::vector<Datagram> m_pending;
+
+#if defined(PLATFORM_LINUX)
+    // Scratch for sendmmsg(), reused across flushes
+    std::vector<mmsghdr> m_messages;
+    std::vector<size_t> m_messageDatagrams;  // Datagrams each message carries
+    std::vector<iovec> m_iovecs;
+    std::vector<char> m_control;
+#endif
+
+    UdpSendStats m_stats;
+};
+
+} // namespace network
+} // namespace talos
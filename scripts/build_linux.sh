@@ -48,12 +48,12 @@ if ! command -v "$COMPILER" &> /dev/null; then
 fi
 
 # Check for X11 development libraries
-if ! pkg-config --exists x11 2>/dev/null; then
+if ! pkg-config --exists x11 xext xrandr xdamage xfixes 2>/dev/null; then
     echo "Error: X11 development libraries not found"
     echo "Please install X11 development libraries:"
-    echo "  sudo apt-get install libx11-dev libxfixes-dev libxrandr-dev    # Debian/Ubuntu"
-    echo "  sudo dnf install libX11-devel libXfixes-devel libXrandr-devel  # Fedora"
-    echo "  sudo pacman -S libx11 libxfixes libxrandr                      # Arch"
+    echo "  sudo apt-get install libx11-dev libxext-dev libxdamage-dev libxfixes-dev libxrandr-dev          # Debian/Ubuntu"
+    echo "  sudo dnf install libX11-devel libXext-devel libXdamage-devel libXfixes-devel libXrandr-devel  # Fedora"
+    echo "  sudo pacman -S libx11 libxext libxdamage libxfixes libxrandr                               # Arch"
     exit 1
 fi
 
@@ -7,7 +7,7 @@
 #elif defined(PLATFORM_MACOS)
 #include "capture/macos_capture_engine.h"
 #elif defined(PLATFORM_LINUX)
-// TODO: Include Linux capture engine
+#include "capture/linux_x11_capture_engine.h"
 #endif
 
 namespace talos {
@@ -20,8 +20,7 @@ std::unique_ptr<ICaptureEngine> createCaptureEngine() {
 #elif defined(PLATFORM_MACOS)
     return std::make_unique<MacOSCaptureEngine>();
 #elif defined(PLATFORM_LINUX)
-    Logger::getInstance().log(LogLevel::Error, "Linux capture engine not yet implemented");
-    return nullptr;
+    return std::make_unique<LinuxX11CaptureEngine>();
 #else
     Logger::getInstance().log(LogLevel::Error, "Unknown platform");
     return nullptr;
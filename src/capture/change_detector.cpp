@@ -0,0 +1,170 @@
+#include "capture/change_detector.h"
+#include <algorithm>
+#include <cstring>
+
+namespace talos {
+namespace capture {
+
+namespace {
+
+constexpr int kBytesPerPixel = 4;
+
+} // namespace
+
+ChangeDetector::ChangeDetector(int tileSize)
+    : m_tileSize(std::max(tileSize, 8))
+    , m_width(0)
+    , m_height(0)
+    , m_format(PixelFormat::UNKNOWN)
+    , m_valid(false) {
+}
+
+void ChangeDetector::reset() {
+    m_valid = false;
+}
+
+void ChangeDetector::process(Frame& frame) {
+    if (frame.pixelFormat != PixelFormat::BGRA8 && frame.pixelFormat != PixelFormat::RGBA8) {
+        return;
+    }
+
+    const uint8_t* pixels = frame.pixels();
+    int width = frame.width;
+    int height = frame.height;
+    size_t rowBytes = static_cast<size_t>(width) * kBytesPerPixel;
+
+    frame.dirtyTiles.reset(width, height, m_tileSize);
+
+    // Without a usable previous frame everything is new
+    if (!m_valid || width != m_width || height != m_height || frame.pixelFormat != m_format) {
+        m_shadow.resize(rowBytes * height);
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(m_shadow.data() + y * rowBytes, pixels + static_cast<size_t>(y) * frame.stride, rowBytes);
+        }
+        m_width = width;
+        m_height = height;
+        m_format = frame.pixelFormat;
+        m_valid = true;
+
+        frame.dirtyTiles.setAll();
+        frame.dirtyRects.clear();
+        frame.identical = false;
+        return;
+    }
+
+    // Damage reports narrow the search; no reports means any tile may differ
+    m_candidates.reset(width, height, m_tileSize);
+    bool wholeFrame = frame.dirtyRects.empty();
+    if (wholeFrame) {
+        m_candidates.setAll();
+    } else {
+        markDamagedTiles(frame.dirtyRects);
+    }
+
+    frame.dirtyRects.clear();
+    bool anyChanged = false;
+    for (int row = 0; row < frame.dirtyTiles.rows; ++row) {
+        if (compareTileRow(pixels, frame.stride, row, wholeFrame, frame.dirtyTiles)) {
+            anyChanged = true;
+            appendTileRuns(frame.dirtyTiles, row, frame.dirtyRects);
+        }
+    }
+
+    frame.identical = !anyChanged;
+}
+
+bool ChangeDetector::compareTileRow(const uint8_t* pixels, int stride, int row, bool wholeRow,
+                                    DirtyTileMap& tiles) {
+    int top = row * m_tileSize;
+    int bottom = std::min(top + m_tileSize, m_height);
+    size_t rowBytes = static_cast<size_t>(m_width) * kBytesPerPixel;
+    size_t tileBytes = static_cast<size_t>(m_tileSize) * kBytesPerPixel;
+
+    int pending = 0;
+    for (int column = 0; column < tiles.columns; ++column) {
+        pending += m_candidates.test(column, row) ? 1 : 0;
+    }
+
+    // Walk the band row by row so reads stay sequential; a tile drops out
+    // of the comparison as soon as it is known to be dirty
+    bool changed = false;
+    for (int y = top; y < bottom && pending > 0; ++y) {
+        const uint8_t* current = pixels + static_cast<size_t>(y) * stride;
+        const uint8_t* previous = m_shadow.data() + y * rowBytes;
+
+        // Static content: one compare clears the whole row
+        if (wholeRow && !changed && std::memcmp(current, previous, rowBytes) == 0) {
+            continue;
+        }
+
+        for (int column = 0; column < tiles.columns; ++column) {
+            if (!m_candidates.test(column, row) || tiles.test(column, row)) {
+                continue;
+            }
+            size_t offset = column * tileBytes;
+            size_t bytes = std::min(tileBytes, rowBytes - offset);
+            if (std::memcmp(current + offset, previous + offset, bytes) != 0) {
+                tiles.set(column, row);
+                pending--;
+                changed = true;
+            }
+        }
+    }
+
+    if (!changed) {
+        return false;
+    }
+
+    // Bring the shadow up to date for the tiles that changed
+    for (int column = 0; column < tiles.columns; ++column) {
+        if (!tiles.test(column, row)) {
+            continue;
+        }
+        size_t offset = column * tileBytes;
+        size_t bytes = std::min(tileBytes, rowBytes - offset);
+        for (int y = top; y < bottom; ++y) {
+            std::memcpy(m_shadow.data() + y * rowBytes + offset,
+                        pixels + static_cast<size_t>(y) * stride + offset, bytes);
+        }
+    }
+    return true;
+}
+
+void ChangeDetector::appendTileRuns(const DirtyTileMap& tiles, int row, std::vector<Rect>& rects) const {
+    int y = row * m_tileSize;
+    int height = std::min(y + m_tileSize, m_height) - y;
+
+    int column = 0;
+    while (column < tiles.columns) {
+        if (!tiles.test(column, row)) {
+            column++;
+            continue;
+        }
+        int start = column;
+        while (column < tiles.columns && tiles.test(column, row)) {
+            column++;
+        }
+        int x = start * m_tileSize;
+        rects.push_back({x, y, std::min(column * m_tileSize, m_width) - x, height});
+    }
+}
+
+void ChangeDetector::markDamagedTiles(const std::vector<Rect>& rects) {
+    for (const auto& rect : rects) {
+        int left = std::max(rect.x, 0) / m_tileSize;
+        int top = std::max(rect.y, 0) / m_tileSize;
+        int right = std::min(rect.x + rect.width, m_width);
+        int bottom = std::min(rect.y + rect.height, m_height);
+        if (right <= 0 || bottom <= 0) {
+            continue;
+        }
+        for (int row = top; row <= (bottom - 1) / m_tileSize; ++row) {
+            for (int column = left; column <= (right - 1) / m_tileSize; ++column) {
+                m_candidates.set(column, row);
+            }
+        }
+    }
+}
+
+} // namespace capture
+} // namespace talos
@@ -262,7 +262,7 @@ std::unique_ptr<FrameInfo> DesktopDuplicationAPI::captureFrame(uint32_t timeoutM
     frame->pitch = mappedResource.RowPitch;
     frame->data = mappedResource.pData;
     frame->timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()
+        std::chrono::steady_clock::now().time_since_epoch()
     ).count();
     
     // Note: We don't unmap here - caller must call releaseFrame() when done with data
@@ -0,0 +1,762 @@
+#ifdef PLATFORM_LINUX
+
+#include "capture/linux_x11_capture_engine.h"
+#include "core/logger.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace talos {
+namespace capture {
+
+namespace {
+
+// Number of SHM segments the server writes into round-robin; frames borrow
+// them, so this bounds how many frames consumers can hold at once
+constexpr size_t kShmRingSize = 4;
+
+// How long shutdown waits for consumers to release borrowed segments
+constexpr auto kSlotReleaseTimeout = std::chrono::seconds(1);
+
+// A slot with more outstanding damage than this is refreshed in one full read
+constexpr size_t kMaxPendingRects = 256;
+constexpr double kFullRefreshAreaRatio = 0.5;
+
+// Set by the temporary error handler installed around XShmAttach
+bool g_shmAttachFailed = false;
+
+int shmAttachErrorHandler(Display*, XErrorEvent*) {
+    g_shmAttachFailed = true;
+    return 0;
+}
+
+float modeRefreshRate(const XRRModeInfo& mode) {
+    if (mode.hTotal == 0 || mode.vTotal == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(static_cast<double>(mode.dotClock) /
+                              (static_cast<double>(mode.hTotal) * mode.vTotal));
+}
+
+// Look up the refresh rate of the CRTC driving the first output of a monitor
+float monitorRefreshRate(Display* display, XRRScreenResources* resources, const XRRMonitorInfo& monitor) {
+    if (!resources || monitor.noutput <= 0) {
+        return 0.0f;
+    }
+
+    float refreshRate = 0.0f;
+    XRROutputInfo* output = XRRGetOutputInfo(display, resources, monitor.outputs[0]);
+    if (output && output->crtc) {
+        XRRCrtcInfo* crtc = XRRGetCrtcInfo(display, resources, output->crtc);
+        if (crtc) {
+            for (int i = 0; i < resources->nmode; ++i) {
+                if (resources->modes[i].id == crtc->mode) {
+                    refreshRate = modeRefreshRate(resources->modes[i]);
+                    break;
+                }
+            }
+            XRRFreeCrtcInfo(crtc);
+        }
+    }
+    if (output) {
+        XRRFreeOutputInfo(output);
+    }
+    return refreshRate;
+}
+
+std::vector<MonitorInfo> queryMonitors(Display* display) {
+    std::vector<MonitorInfo> monitors;
+    Window root = DefaultRootWindow(display);
+
+    int eventBase = 0;
+    int errorBase = 0;
+    if (XRRQueryExtension(display, &eventBase, &errorBase)) {
+        int count = 0;
+        XRRMonitorInfo* xrrMonitors = XRRGetMonitors(display, root, True, &count);
+        XRRScreenResources* resources = XRRGetScreenResourcesCurrent(display, root);
+
+        for (int i = 0; i < count; ++i) {
+            const XRRMonitorInfo& m = xrrMonitors[i];
+
+            MonitorInfo info;
+            info.id = static_cast<uint32_t>(i);
+            char* atomName = m.name ? XGetAtomName(display, m.name) : nullptr;
+            info.name = atomName ? atomName : "Monitor " + std::to_string(i);
+            if (atomName) {
+                XFree(atomName);
+            }
+            info.width = m.width;
+            info.height = m.height;
+            info.x = m.x;
+            info.y = m.y;
+            info.refreshRate = monitorRefreshRate(display, resources, m);
+            info.isPrimary = m.primary != 0;
+
+            monitors.push_back(info);
+        }
+
+        if (resources) {
+            XRRFreeScreenResources(resources);
+        }
+        if (xrrMonitors) {
+            XRRFreeMonitors(xrrMonitors);
+        }
+    }
+
+    // No XRandR (or no active monitors, e.g. bare Xvfb): expose the root window
+    if (monitors.empty()) {
+        MonitorInfo info;
+        info.id = 0;
+        info.name = DisplayString(display);
+        info.width = DisplayWidth(display, DefaultScreen(display));
+        info.height = DisplayHeight(display, DefaultScreen(display));
+        info.x = 0;
+        info.y = 0;
+        info.refreshRate = 0.0f;
+        info.isPrimary = true;
+        monitors.push_back(info);
+    }
+
+    return monitors;
+}
+
+} // namespace
+
+struct LinuxX11CaptureEngine::ShmSlot {
+    XShmSegmentInfo shmInfo{};
+    XImage* image = nullptr;
+    bool attached = false;
+
+    // Damage this slot has not seen yet, in capture coordinates
+    std::vector<Rect> pendingRects;
+    bool needsFullRefresh = true;
+
+    // Set while a Frame borrows the segment; cleared by the frame's release callback
+    std::atomic<bool> inUse{false};
+};
+
+LinuxX11CaptureEngine::LinuxX11CaptureEngine()
+    : m_display(nullptr)
+    , m_rootWindow(0)
+    , m_pixelFormat(PixelFormat::UNKNOWN)
+    , m_nextSlot(0)
+    , m_damageAvailable(false)
+    , m_damageEventBase(0)
+    , m_damage(0)
+    , m_damageRegion(0)
+    , m_damagePending(false)
+    , m_emitInitialFrame(true)
+    , m_captureX(0)
+    , m_captureY(0)
+    , m_captureWidth(0)
+    , m_captureHeight(0)
+    , m_initialized(false)
+    , m_capturing(false)
+    , m_frameBuffer(4)  // Keep max 4 frames in queue
+    , m_monitorIndex(0)  // Primary monitor by default
+    , m_frameInterval(1000000 / 60)
+{
+}
+
+LinuxX11CaptureEngine::~LinuxX11CaptureEngine() {
+    shutdown();
+}
+
+bool LinuxX11CaptureEngine::initialize() {
+    if (m_initialized) {
+        return true;
+    }
+
+    Logger::instance().info("Initializing Linux X11 capture engine");
+
+    if (!openDisplay()) {
+        return false;
+    }
+
+    if (!selectCaptureArea() || !createShmRing()) {
+        closeDisplay();
+        return false;
+    }
+
+    m_damageAvailable = createDamageTracking();
+    if (!m_damageAvailable) {
+        Logger::instance().warn("XDamage unavailable - falling back to full-frame polling");
+    }
+
+    // Reset statistics
+    m_stats = CaptureStats();
+
+    m_initialized = true;
+    Logger::instance().info("Capture resolution: " + std::to_string(m_captureWidth) + "x" +
+                            std::to_string(m_captureHeight));
+    Logger::instance().info("Linux X11 capture engine initialized successfully");
+    return true;
+}
+
+void LinuxX11CaptureEngine::shutdown() {
+    if (!m_initialized) {
+        return;
+    }
+
+    stopCapture();
+
+    destroyDamageTracking();
+    destroyShmRing();
+    closeDisplay();
+
+    m_initialized = false;
+    Logger::instance().info("Linux X11 capture engine shut down");
+}
+
+bool LinuxX11CaptureEngine::openDisplay() {
+    // getAvailableMonitors() may open its own connection from another thread
+    XInitThreads();
+
+    m_display = XOpenDisplay(nullptr);
+    if (!m_display) {
+        Logger::instance().error("Failed to open X display (is DISPLAY set?)");
+        return false;
+    }
+
+    if (!XShmQueryExtension(m_display)) {
+        Logger::instance().error("X server does not support the MIT-SHM extension");
+        closeDisplay();
+        return false;
+    }
+
+    int screen = DefaultScreen(m_display);
+    m_rootWindow = RootWindow(m_display, screen);
+
+    // Only 32 bpp TrueColor layouts map onto our pixel formats without conversion
+    Visual* visual = DefaultVisual(m_display, screen);
+    if (visual->red_mask == 0xff0000 && visual->green_mask == 0x00ff00 && visual->blue_mask == 0x0000ff) {
+        m_pixelFormat = PixelFormat::BGRA8;
+    } else if (visual->red_mask == 0x0000ff && visual->green_mask == 0x00ff00 && visual->blue_mask == 0xff0000) {
+        m_pixelFormat = PixelFormat::RGBA8;
+    } else {
+        Logger::instance().error("Unsupported X visual layout");
+        closeDisplay();
+        return false;
+    }
+
+    Logger::instance().debug("Connected to X display " + std::string(DisplayString(m_display)));
+    return true;
+}
+
+void LinuxX11CaptureEngine::closeDisplay() {
+    if (m_display) {
+        XCloseDisplay(m_display);
+        m_display = nullptr;
+    }
+}
+
+bool LinuxX11CaptureEngine::selectCaptureArea() {
+    auto monitors = queryMonitors(m_display);
+    if (m_monitorIndex < 0 || m_monitorIndex >= static_cast<int>(monitors.size())) {
+        Logger::instance().error("Invalid monitor index: " + std::to_string(m_monitorIndex));
+        return false;
+    }
+
+    const MonitorInfo& monitor = monitors[m_monitorIndex];
+    m_captureX = monitor.x;
+    m_captureY = monitor.y;
+    m_captureWidth = monitor.width;
+    m_captureHeight = monitor.height;
+
+    if (monitor.refreshRate > 0.0f) {
+        m_frameInterval = std::chrono::microseconds(static_cast<int64_t>(1000000.0f / monitor.refreshRate));
+    }
+
+    Logger::instance().info("Capturing monitor " + monitor.name + " at " +
+                            std::to_string(m_captureX) + "," + std::to_string(m_captureY));
+    return true;
+}
+
+std::unique_ptr<LinuxX11CaptureEngine::ShmSlot> LinuxX11CaptureEngine::createShmSlot() {
+    int screen = DefaultScreen(m_display);
+    Visual* visual = DefaultVisual(m_display, screen);
+    int depth = DefaultDepth(m_display, screen);
+
+    auto slot = std::make_unique<ShmSlot>();
+
+    slot->image = XShmCreateImage(m_display, visual, depth, ZPixmap, nullptr, &slot->shmInfo,
+                                  m_captureWidth, m_captureHeight);
+    if (!slot->image || slot->image->bits_per_pixel != 32) {
+        Logger::instance().error("Failed to create 32 bpp XShm image");
+        destroyShmSlot(*slot);
+        return nullptr;
+    }
+
+    size_t segmentSize = static_cast<size_t>(slot->image->bytes_per_line) * slot->image->height;
+    slot->shmInfo.shmid = shmget(IPC_PRIVATE, segmentSize, IPC_CREAT | 0600);
+    if (slot->shmInfo.shmid < 0) {
+        Logger::instance().error("shmget failed for " + std::to_string(segmentSize) + " bytes");
+        destroyShmSlot(*slot);
+        return nullptr;
+    }
+
+    slot->shmInfo.shmaddr = static_cast<char*>(shmat(slot->shmInfo.shmid, nullptr, 0));
+    if (slot->shmInfo.shmaddr == reinterpret_cast<char*>(-1)) {
+        Logger::instance().error(std::string("shmat failed: ") + strerror(errno));
+        shmctl(slot->shmInfo.shmid, IPC_RMID, nullptr);
+        slot->shmInfo.shmaddr = nullptr;
+        destroyShmSlot(*slot);
+        return nullptr;
+    }
+    slot->image->data = slot->shmInfo.shmaddr;
+    slot->shmInfo.readOnly = False;
+
+    // Remote or sandboxed servers reject the attach asynchronously
+    g_shmAttachFailed = false;
+    auto previousHandler = XSetErrorHandler(shmAttachErrorHandler);
+    XShmAttach(m_display, &slot->shmInfo);
+    XSync(m_display, False);
+    XSetErrorHandler(previousHandler);
+
+    // Mark for removal now; the segment lives until both sides detach
+    shmctl(slot->shmInfo.shmid, IPC_RMID, nullptr);
+
+    if (g_shmAttachFailed) {
+        Logger::instance().error("XShmAttach failed - MIT-SHM is not usable on this display");
+        destroyShmSlot(*slot);
+        return nullptr;
+    }
+
+    slot->attached = true;
+    return slot;
+}
+
+void LinuxX11CaptureEngine::destroyShmSlot(ShmSlot& slot) {
+    if (slot.attached) {
+        XShmDetach(m_display, &slot.shmInfo);
+        slot.attached = false;
+    }
+    if (slot.image) {
+        // Detach the shared memory ourselves; XDestroyImage must not free() it
+        slot.image->data = nullptr;
+        XDestroyImage(slot.image);
+        slot.image = nullptr;
+    }
+    if (slot.shmInfo.shmaddr) {
+        shmdt(slot.shmInfo.shmaddr);
+        slot.shmInfo.shmaddr = nullptr;
+    }
+}
+
+bool LinuxX11CaptureEngine::createShmRing() {
+    for (size_t i = 0; i < kShmRingSize; ++i) {
+        auto slot = createShmSlot();
+        if (!slot) {
+            destroyShmRing();
+            return false;
+        }
+        m_slots.push_back(std::move(slot));
+    }
+
+    // Damaged rectangles are read into the scratch segment, then patched into a slot
+    m_scratch = createShmSlot();
+    if (!m_scratch) {
+        destroyShmRing();
+        return false;
+    }
+
+    m_nextSlot = 0;
+
+    // Queue depth plus the frame being encoded and the one being captured
+    // Frames only borrow the segments, so pooled frames need no pixel storage
+    m_framePool.reserve(kShmRingSize, 0);
+    return true;
+}
+
+void LinuxX11CaptureEngine::destroyShmRing() {
+    auto deadline = std::chrono::steady_clock::now() + kSlotReleaseTimeout;
+    for (auto& slot : m_slots) {
+        while (slot->inUse.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (slot->inUse.load(std::memory_order_acquire)) {
+            // A consumer still reads this segment; leak it rather than unmap under its feet
+            Logger::instance().error("Capture frame still held at shutdown - leaking its SHM segment");
+            slot.release();
+            continue;
+        }
+        destroyShmSlot(*slot);
+    }
+    m_slots.clear();
+
+    if (m_scratch) {
+        destroyShmSlot(*m_scratch);
+        m_scratch.reset();
+    }
+
+    if (m_display) {
+        XSync(m_display, False);
+    }
+}
+
+bool LinuxX11CaptureEngine::createDamageTracking() {
+    int errorBase = 0;
+    int fixesEventBase = 0;
+    if (!XDamageQueryExtension(m_display, &m_damageEventBase, &errorBase) ||
+        !XFixesQueryExtension(m_display, &fixesEventBase, &errorBase)) {
+        return false;
+    }
+
+    // NonEmpty: one notify per empty -> non-empty transition, the region is fetched on demand
+    m_damage = XDamageCreate(m_display, m_rootWindow, XDamageReportNonEmpty);
+    m_damageRegion = XFixesCreateRegion(m_display, nullptr, 0);
+    m_damagePending = false;
+
+    Logger::instance().debug("XDamage change tracking enabled");
+    return m_damage != 0 && m_damageRegion != 0;
+}
+
+void LinuxX11CaptureEngine::destroyDamageTracking() {
+    if (!m_display) {
+        return;
+    }
+    if (m_damage) {
+        XDamageDestroy(m_display, m_damage);
+        m_damage = 0;
+    }
+    if (m_damageRegion) {
+        XFixesDestroyRegion(m_display, m_damageRegion);
+        m_damageRegion = 0;
+    }
+    m_damageAvailable = false;
+}
+
+bool LinuxX11CaptureEngine::collectDamage(std::vector<Rect>& rects) {
+    // Drain notifies without a round trip; no notify means nothing changed
+    while (XPending(m_display) > 0) {
+        XEvent event;
+        XNextEvent(m_display, &event);
+        if (event.type == m_damageEventBase + XDamageNotify) {
+            m_damagePending = true;
+        }
+    }
+
+    if (!m_damagePending) {
+        return false;
+    }
+    m_damagePending = false;
+
+    // Move the accumulated damage into our region and reset it server-side
+    XDamageSubtract(m_display, m_damage, None, m_damageRegion);
+
+    int count = 0;
+    XRectangle* xrects = XFixesFetchRegion(m_display, m_damageRegion, &count);
+    for (int i = 0; i < count; ++i) {
+        // Clip root-window damage to the captured monitor
+        int left = std::max<int>(xrects[i].x, m_captureX);
+        int top = std::max<int>(xrects[i].y, m_captureY);
+        int right = std::min<int>(xrects[i].x + xrects[i].width, m_captureX + m_captureWidth);
+        int bottom = std::min<int>(xrects[i].y + xrects[i].height, m_captureY + m_captureHeight);
+        if (right > left && bottom > top) {
+            rects.push_back({left - m_captureX, top - m_captureY, right - left, bottom - top});
+        }
+    }
+    if (xrects) {
+        XFree(xrects);
+    }
+
+    return !rects.empty();
+}
+
+void LinuxX11CaptureEngine::addPendingDamage(const std::vector<Rect>& rects) {
+    for (auto& slot : m_slots) {
+        if (slot->needsFullRefresh) {
+            continue;
+        }
+        if (slot->pendingRects.size() + rects.size() > kMaxPendingRects) {
+            slot->pendingRects.clear();
+            slot->needsFullRefresh = true;
+            continue;
+        }
+        slot->pendingRects.insert(slot->pendingRects.end(), rects.begin(), rects.end());
+    }
+}
+
+bool LinuxX11CaptureEngine::startCapture() {
+    if (m_capturing) {
+        Logger::instance().warn("Capture already running");
+        return true;
+    }
+
+    if (!m_initialized) {
+        Logger::instance().error("Cannot start capture - engine not initialized");
+        return false;
+    }
+
+    Logger::instance().info("Starting capture");
+
+    // Clear any existing frames
+    m_frameBuffer.clear();
+    m_frameBuffer.open();
+    m_changeDetector.reset();
+
+    // Reset statistics
+    m_stats = CaptureStats();
+    m_captureStartTime = std::chrono::steady_clock::now();
+
+    // Consumers start from a complete picture
+    m_emitInitialFrame = true;
+
+    // Start capture thread
+    m_capturing = true;
+    m_captureThread = std::thread(&LinuxX11CaptureEngine::captureThread, this);
+
+    Logger::instance().info("Capture started successfully");
+    return true;
+}
+
+void LinuxX11CaptureEngine::stopCapture() {
+    if (!m_capturing) {
+        return;
+    }
+
+    Logger::instance().info("Stopping capture");
+
+    // Signal thread to stop
+    m_capturing = false;
+
+    // Wake up any waiting threads
+    m_frameBuffer.close();
+
+    // Wait for thread to finish
+    if (m_captureThread.joinable()) {
+        m_captureThread.join();
+    }
+
+    // Clear frame queue
+    m_frameBuffer.clear();
+
+    Logger::instance().info("Capture stopped");
+}
+
+bool LinuxX11CaptureEngine::isCapturing() const {
+    return m_capturing;
+}
+
+bool LinuxX11CaptureEngine::grabFrame(ShmSlot& slot) {
+    // Single server-side copy of the capture area into the shared segment
+    if (!XShmGetImage(m_display, m_rootWindow, slot.image, m_captureX, m_captureY, AllPlanes)) {
+        Logger::instance().error("XShmGetImage failed");
+        return false;
+    }
+    return true;
+}
+
+bool LinuxX11CaptureEngine::grabRect(ShmSlot& slot, const Rect& rect) {
+    // The server packs the rectangle at the start of the scratch segment
+    XImage* scratch = m_scratch->image;
+    scratch->width = rect.width;
+    scratch->height = rect.height;
+    scratch->bytes_per_line = rect.width * 4;
+
+    if (!XShmGetImage(m_display, m_rootWindow, scratch, m_captureX + rect.x, m_captureY + rect.y, AllPlanes)) {
+        Logger::instance().error("XShmGetImage failed for damaged rectangle");
+        return false;
+    }
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(scratch->data);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(slot.image->data) +
+                   static_cast<size_t>(rect.y) * slot.image->bytes_per_line + static_cast<size_t>(rect.x) * 4;
+    size_t rowBytes = static_cast<size_t>(rect.width) * 4;
+    for (int row = 0; row < rect.height; ++row) {
+        std::memcpy(dst, src, rowBytes);
+        src += rowBytes;
+        dst += slot.image->bytes_per_line;
+    }
+    return true;
+}
+
+bool LinuxX11CaptureEngine::refreshSlot(ShmSlot& slot, size_t& bytesRead) {
+    size_t frameArea = static_cast<size_t>(m_captureWidth) * m_captureHeight;
+    size_t pendingArea = 0;
+    for (const auto& rect : slot.pendingRects) {
+        pendingArea += static_cast<size_t>(rect.width) * rect.height;
+    }
+
+    // Many small reads stop paying off once most of the screen is dirty
+    if (slot.needsFullRefresh || pendingArea > frameArea * kFullRefreshAreaRatio) {
+        if (!grabFrame(slot)) {
+            return false;
+        }
+        bytesRead = frameArea * 4;
+    } else {
+        for (const auto& rect : slot.pendingRects) {
+            if (!grabRect(slot, rect)) {
+                slot.needsFullRefresh = true;
+                slot.pendingRects.clear();
+                return false;
+            }
+        }
+        bytesRead = pendingArea * 4;
+    }
+
+    slot.pendingRects.clear();
+    slot.needsFullRefresh = false;
+    return true;
+}
+
+LinuxX11CaptureEngine::ShmSlot* LinuxX11CaptureEngine::acquireFreeSlot() {
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        ShmSlot* slot = m_slots[(m_nextSlot + i) % m_slots.size()].get();
+        if (!slot->inUse.load(std::memory_order_acquire)) {
+            m_nextSlot = (m_nextSlot + i + 1) % m_slots.size();
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+void LinuxX11CaptureEngine::captureThread() {
+    Logger::instance().debug("Capture thread started");
+
+    auto nextCapture = std::chrono::steady_clock::now();
+    m_damageRects.clear();
+
+    while (m_capturing) {
+        m_newDamage.clear();
+
+        // Without XDamage every tick is treated as a full-frame change
+        bool changed = !m_damageAvailable || collectDamage(m_newDamage);
+        if (changed) {
+            addPendingDamage(m_newDamage);
+            m_damageRects.insert(m_damageRects.end(), m_newDamage.begin(), m_newDamage.end());
+        }
+
+        // Damage keeps accumulating while consumers hold every segment
+        ShmSlot* slot = (changed || m_emitInitialFrame) ? acquireFreeSlot() : nullptr;
+        if (slot) {
+            if (!m_damageAvailable) {
+                slot->needsFullRefresh = true;
+            }
+
+            size_t bytesRead = 0;
+            if (refreshSlot(*slot, bytesRead)) {
+                auto frame = m_framePool.acquire(0);
+                frame->width = m_captureWidth;
+                frame->height = m_captureHeight;
+                frame->stride = slot->image->bytes_per_line;
+                frame->pixelFormat = m_pixelFormat;
+                frame->timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                if (!m_emitInitialFrame) {
+                    frame->dirtyRects.swap(m_damageRects);
+                }
+                m_damageRects.clear();
+                m_emitInitialFrame = false;
+
+                // Hand out the segment itself; it returns to the ring when the frame is released
+                slot->inUse.store(true, std::memory_order_release);
+                frame->borrow(reinterpret_cast<const uint8_t*>(slot->image->data), [slot]() {
+                    slot->inUse.store(false, std::memory_order_release);
+                });
+
+                // Update statistics
+                {
+                    std::lock_guard<std::mutex> lock(m_statsMutex);
+                    m_stats.framesCapture++;
+                    m_stats.bytesCapture += bytesRead;
+
+                    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::steady_clock::now() - m_captureStartTime).count();
+                    if (elapsed > 0) {
+                        m_stats.averageFps = static_cast<float>(m_stats.framesCapture) / elapsed;
+                    }
+                }
+
+                // Damage is coarse (whole windows, cursor blinks that restore
+                // pixels); keep only the tiles that actually differ
+                m_changeDetector.process(*frame);
+
+                // Drops the oldest queued frame if the consumer lags
+                m_frameBuffer.push(std::move(frame));
+            }
+        }
+
+        // Pace to the monitor refresh rate; resync if we fell behind
+        nextCapture += m_frameInterval;
+        auto now = std::chrono::steady_clock::now();
+        if (nextCapture < now) {
+            nextCapture = now;
+        }
+        std::this_thread::sleep_until(nextCapture);
+    }
+
+    Logger::instance().debug("Capture thread ended");
+}
+
+std::shared_ptr<Frame> LinuxX11CaptureEngine::getNextFrame(uint32_t timeoutMs) {
+    return m_frameBuffer.pop(timeoutMs);
+}
+
+CaptureStats LinuxX11CaptureEngine::getStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    CaptureStats stats = m_stats;
+    stats.framesDropped = m_frameBuffer.droppedCount();
+
+    FramePoolStats poolStats = m_framePool.getStats();
+    stats.poolHits = poolStats.hits;
+    stats.poolMisses = poolStats.misses;
+    stats.poolHighWater = poolStats.highWater;
+
+    return stats;
+}
+
+bool LinuxX11CaptureEngine::setMonitor(int monitorIndex) {
+    if (m_capturing) {
+        Logger::instance().error("Cannot change monitor while capturing");
+        return false;
+    }
+
+    m_monitorIndex = monitorIndex;
+
+    // Rebuild the SHM ring for the new monitor size if already initialized
+    if (m_initialized) {
+        destroyShmRing();
+        if (!selectCaptureArea() || !createShmRing()) {
+            Logger::instance().error("Failed to switch to monitor " + std::to_string(monitorIndex));
+            destroyDamageTracking();
+            closeDisplay();
+            m_initialized = false;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<MonitorInfo> LinuxX11CaptureEngine::getAvailableMonitors() const {
+    return getMonitors();
+}
+
+std::vector<MonitorInfo> LinuxX11CaptureEngine::getMonitors() {
+    // Use a private connection so this is safe while the capture thread runs
+    Display* display = XOpenDisplay(nullptr);
+    if (!display) {
+        Logger::instance().error("Failed to open X display for monitor enumeration");
+        return {};
+    }
+
+    auto monitors = queryMonitors(display);
+    XCloseDisplay(display);
+    return monitors;
+}
+
+} // namespace capture
+} // namespace talos
+
+#endif // PLATFORM_LINUX
@@ -41,6 +41,7 @@ MacOSCaptureEngine::MacOSCaptureEngine()
     , m_screenInput(nil)
     , m_videoOutput(nil)
     , m_delegate(nil)
+    , m_frameBuffer(MAX_QUEUE_SIZE)
     , m_initialized(false)
     , m_isCapturing(false)
     , m_displayId(CGMainDisplayID())
@@ -103,6 +104,10 @@ bool MacOSCaptureEngine::startCapture() {
     }
     
     @autoreleasepool {
+        m_frameBuffer.clear();
+        m_frameBuffer.open();
+        m_changeDetector.reset();
+        
         [m_captureSession startRunning];
         
         if (![m_captureSession isRunning]) {
@@ -127,34 +132,16 @@ void MacOSCaptureEngine::stopCapture() {
         [m_captureSession stopRunning];
         m_isCapturing = false;
         
-        // Clear frame queue
-        {
-            std::lock_guard<std::mutex> lock(m_queueMutex);
-            while (!m_frameQueue.empty()) {
-                m_frameQueue.pop();
-            }
-        }
+        // Wake any waiting consumer and clear frame queue
+        m_frameBuffer.close();
+        m_frameBuffer.clear();
         
         Logger::getInstance().log(LogLevel::Info, "Stopped capturing");
     }
 }
 
 std::shared_ptr<Frame> MacOSCaptureEngine::getNextFrame(uint32_t timeoutMs) {
-    std::unique_lock<std::mutex> lock(m_queueMutex);
-    
-    auto timeout = std::chrono::milliseconds(timeoutMs);
-    bool hasFrame = m_queueCondition.wait_for(lock, timeout, [this] {
-        return !m_frameQueue.empty();
-    });
-    
-    if (!hasFrame || m_frameQueue.empty()) {
-        return nullptr;
-    }
-    
-    auto frame = m_frameQueue.front();
-    m_frameQueue.pop();
-    
-    return frame;
+    return m_frameBuffer.pop(timeoutMs);
 }
 
 CaptureStats MacOSCaptureEngine::getStats() const {
@@ -162,12 +149,18 @@ CaptureStats MacOSCaptureEngine::getStats() const {
     
     // Return copy of stats with updated FPS
     CaptureStats stats = m_stats;
+    stats.framesDropped = m_frameBuffer.droppedCount();
     auto now = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - m_startTime).count();
     if (duration > 0) {
         stats.currentFps = static_cast<float>(stats.framesCapture) / duration;
     }
     
+    FramePoolStats poolStats = m_framePool.getStats();
+    stats.poolHits = poolStats.hits;
+    stats.poolMisses = poolStats.misses;
+    stats.poolHighWater = poolStats.highWater;
+    
     return stats;
 }
 
@@ -280,8 +273,9 @@ void MacOSCaptureEngine::onFrameCaptured(void* sampleBuffer) {
                 return;
         }
         
-        // Create frame
-        auto frame = std::make_shared<Frame>();
+        // Borrow the pixel buffer rather than copying it; it stays locked and
+        // retained until the last reference to the frame drops
+        auto frame = m_framePool.acquire(0);
         frame->width = static_cast<int>(width);
         frame->height = static_cast<int>(height);
         frame->stride = static_cast<int>(bytesPerRow);
@@ -291,27 +285,17 @@ void MacOSCaptureEngine::onFrameCaptured(void* sampleBuffer) {
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch());
         frame->timestamp = duration.count();
         
-        // Copy pixel data
-        size_t dataSize = height * bytesPerRow;
-        frame->data.resize(dataSize);
-        std::memcpy(frame->data.data(), baseAddress, dataSize);
+        CVPixelBufferRetain(imageBuffer);
+        frame->borrow(static_cast<const uint8_t*>(baseAddress), [imageBuffer]() {
+            CVPixelBufferUnlockBaseAddress(imageBuffer, kCVPixelBufferLock_ReadOnly);
+            CVPixelBufferRelease(imageBuffer);
+        });
         
-        // Unlock pixel buffer
-        CVPixelBufferUnlockBaseAddress(imageBuffer, kCVPixelBufferLock_ReadOnly);
+        // Mark changed tiles so downstream stages can skip static content
+        m_changeDetector.process(*frame);
         
-        // Add to queue
-        {
-            std::lock_guard<std::mutex> lock(m_queueMutex);
-            
-            // Drop oldest frame if queue is full
-            if (m_frameQueue.size() >= MAX_QUEUE_SIZE) {
-                m_frameQueue.pop();
-                m_stats.framesDropped++;
-            }
-            
-            m_frameQueue.push(frame);
-        }
-        m_queueCondition.notify_one();
+        // Add to queue, dropping the oldest frame if the consumer lags
+        m_frameBuffer.push(std::move(frame));
         
         // Update stats
         updateStats();
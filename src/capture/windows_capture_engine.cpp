@@ -11,7 +11,7 @@ namespace capture {
 WindowsCaptureEngine::WindowsCaptureEngine()
     : m_capturing(false)
     , m_threadRunning(false)
-    , m_maxQueueSize(3)  // Keep max 3 frames in queue
+    , m_frameBuffer(4)  // Keep max 4 frames in queue
     , m_monitorIndex(0)  // Primary monitor by default
 {
     m_duplicationAPI = std::make_unique<DesktopDuplicationAPI>();
@@ -69,7 +69,9 @@ bool WindowsCaptureEngine::startCapture() {
     Logger::instance().info("Starting capture");
     
     // Clear any existing frames
-    clearFrameQueue();
+    m_frameBuffer.clear();
+    m_frameBuffer.open();
+    m_changeDetector.reset();
     
     // Reset statistics
     m_stats = CaptureStats();
@@ -95,7 +97,7 @@ void WindowsCaptureEngine::stopCapture() {
     m_capturing = false;
     
     // Wake up any waiting threads
-    m_queueCondition.notify_all();
+    m_frameBuffer.close();
     
     // Wait for thread to finish
     if (m_captureThread.joinable()) {
@@ -103,7 +105,7 @@ void WindowsCaptureEngine::stopCapture() {
     }
     
     // Clear frame queue
-    clearFrameQueue();
+    m_frameBuffer.clear();
     
     Logger::instance().info("Capture stopped");
 }
@@ -124,18 +126,17 @@ void WindowsCaptureEngine::captureThread() {
             auto frameInfo = m_duplicationAPI->captureFrame(16);
             
             if (frameInfo) {
-                // Create Frame object
-                auto frame = std::make_shared<Frame>();
+                // Calculate data size
+                size_t dataSize = frameInfo->height * frameInfo->pitch;
+                
+                // Get a recycled Frame object
+                auto frame = m_framePool.acquire(dataSize);
                 frame->width = frameInfo->width;
                 frame->height = frameInfo->height;
                 frame->stride = frameInfo->pitch;
                 frame->pixelFormat = PixelFormat::BGRA8;
                 frame->timestamp = frameInfo->timestamp;
                 
-                // Calculate data size
-                size_t dataSize = frameInfo->height * frameInfo->pitch;
-                frame->data.resize(dataSize);
-                
                 // Copy frame data
                 std::memcpy(frame->data.data(), frameInfo->data, dataSize);
                 
@@ -154,8 +155,11 @@ void WindowsCaptureEngine::captureThread() {
                     }
                 }
                 
-                // Add to queue
-                pushFrame(frame);
+                // Mark changed tiles so downstream stages can skip static content
+                m_changeDetector.process(*frame);
+                
+                // Add to queue, dropping the oldest frame if the consumer lags
+                m_frameBuffer.push(std::move(frame));
                 
                 // Release the frame in Desktop Duplication API
                 // This happens automatically in destructor of frameInfo
@@ -172,58 +176,20 @@ void WindowsCaptureEngine::captureThread() {
 }
 
 std::shared_ptr<Frame> WindowsCaptureEngine::getNextFrame(uint32_t timeoutMs) {
-    return popFrame(timeoutMs);
-}
-
-void WindowsCaptureEngine::pushFrame(std::shared_ptr<Frame> frame) {
-    std::unique_lock<std::mutex> lock(m_queueMutex);
-    
-    // Drop oldest frame if queue is full
-    if (m_frameQueue.size() >= m_maxQueueSize) {
-        m_frameQueue.pop();
-        
-        std::lock_guard<std::mutex> statsLock(m_statsMutex);
-        m_stats.framesDropped++;
-    }
-    
-    m_frameQueue.push(frame);
-    lock.unlock();
-    
-    // Notify waiting threads
-    m_queueCondition.notify_one();
-}
-
-std::shared_ptr<Frame> WindowsCaptureEngine::popFrame(uint32_t timeoutMs) {
-    std::unique_lock<std::mutex> lock(m_queueMutex);
-    
-    // Wait for frame or timeout
-    auto waitUntil = std::chrono::steady_clock::now() + 
-                     std::chrono::milliseconds(timeoutMs);
-    
-    m_queueCondition.wait_until(lock, waitUntil, [this] {
-        return !m_frameQueue.empty() || !m_capturing;
-    });
-    
-    if (m_frameQueue.empty()) {
-        return nullptr;
-    }
-    
-    auto frame = m_frameQueue.front();
-    m_frameQueue.pop();
-    
-    return frame;
-}
-
-void WindowsCaptureEngine::clearFrameQueue() {
-    std::lock_guard<std::mutex> lock(m_queueMutex);
-    while (!m_frameQueue.empty()) {
-        m_frameQueue.pop();
-    }
+    return m_frameBuffer.pop(timeoutMs);
 }
 
 CaptureStats WindowsCaptureEngine::getStats() const {
     std::lock_guard<std::mutex> lock(m_statsMutex);
-    return m_stats;
+    CaptureStats stats = m_stats;
+    stats.framesDropped = m_frameBuffer.droppedCount();
+    
+    FramePoolStats poolStats = m_framePool.getStats();
+    stats.poolHits = poolStats.hits;
+    stats.poolMisses = poolStats.misses;
+    stats.poolHighWater = poolStats.highWater;
+    
+    return stats;
 }
 
 bool WindowsCaptureEngine::setMonitor(int monitorIndex) {
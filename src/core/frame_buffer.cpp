@@ -0,0 +1,76 @@
+#include "core/frame_buffer.h"
+
+namespace talos {
+
+FrameBuffer::FrameBuffer(size_t capacity)
+    : m_ring(capacity)
+    , m_closed(false)
+    , m_dropped(0) {
+}
+
+bool FrameBuffer::push(std::shared_ptr<capture::Frame> frame) {
+    size_t dropped = m_ring.pushOverwrite(std::move(frame));
+    if (dropped > 0) {
+        m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+    }
+
+    m_frameAvailable.notify();
+    return dropped > 0;
+}
+
+std::shared_ptr<capture::Frame> FrameBuffer::pop(uint32_t timeoutMs) {
+    std::shared_ptr<capture::Frame> frame;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    for (;;) {
+        if (m_ring.tryPop(frame)) {
+            return frame;
+        }
+        if (m_closed.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        // Re-check after registering so a push in between cannot be missed
+        uint32_t epoch = m_frameAvailable.prepareWait();
+        if (m_ring.tryPop(frame)) {
+            m_frameAvailable.cancelWait();
+            return frame;
+        }
+        if (m_closed.load(std::memory_order_acquire)) {
+            m_frameAvailable.cancelWait();
+            return nullptr;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            m_frameAvailable.cancelWait();
+            m_ring.tryPop(frame);
+            return frame;
+        }
+        if (!m_frameAvailable.wait(epoch, remaining)) {
+            // One last look: a frame may have landed right at the deadline
+            m_ring.tryPop(frame);
+            return frame;
+        }
+    }
+}
+
+void FrameBuffer::open() {
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_closed.store(false, std::memory_order_release);
+}
+
+void FrameBuffer::close() {
+    m_closed.store(true, std::memory_order_release);
+    m_frameAvailable.notify();
+}
+
+void FrameBuffer::clear() {
+    std::shared_ptr<capture::Frame> frame;
+    while (m_ring.tryPop(frame)) {
+        frame.reset();
+    }
+}
+
+} // namespace talos
@@ -0,0 +1,113 @@
+#include "core/frame_pool.h"
+#include <algorithm>
+
+namespace talos {
+
+struct FramePool::State {
+    explicit State(size_t maxPooled)
+        : maxPooledFrames(maxPooled)
+        , controlBlocks(std::make_shared<BlockCache>(maxPooled * 4)) {
+        freeFrames.reserve(maxPooled);
+    }
+
+    ~State() {
+        for (capture::Frame* frame : freeFrames) {
+            delete frame;
+        }
+    }
+
+    void release(capture::Frame* frame) {
+        // Hand borrowed memory back to its source before the frame is reused
+        frame->release();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.outstanding--;
+            if (freeFrames.size() < maxPooledFrames) {
+                freeFrames.push_back(frame);
+                return;
+            }
+        }
+        delete frame;
+    }
+
+    mutable std::mutex mutex;
+    size_t maxPooledFrames;
+    std::vector<capture::Frame*> freeFrames;
+    FramePoolStats stats;
+    uint64_t nextSequence = 0;
+
+    // Recycles the shared_ptr control blocks of handed-out frames
+    std::shared_ptr<BlockCache> controlBlocks;
+};
+
+void FramePool::Recycler::operator()(capture::Frame* frame) const {
+    state->release(frame);
+}
+
+FramePool::FramePool(size_t maxPooledFrames)
+    : m_state(std::make_shared<State>(std::max<size_t>(maxPooledFrames, 1))) {
+}
+
+FramePool::~FramePool() = default;
+
+void FramePool::reserve(size_t count, size_t dataSize) {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    count = std::min(count, m_state->maxPooledFrames);
+
+    for (auto* frame : m_state->freeFrames) {
+        frame->data.reserve(dataSize);
+    }
+    while (m_state->freeFrames.size() < count) {
+        auto* frame = new capture::Frame();
+        frame->data.reserve(dataSize);
+        m_state->freeFrames.push_back(frame);
+    }
+}
+
+std::shared_ptr<capture::Frame> FramePool::acquire(size_t dataSize) {
+    capture::Frame* frame = nullptr;
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        auto& stats = m_state->stats;
+
+        if (!m_state->freeFrames.empty()) {
+            // Prefer the most recently released frame: its buffer is cache-warm
+            frame = m_state->freeFrames.back();
+            m_state->freeFrames.pop_back();
+        }
+
+        if (frame && frame->data.capacity() >= dataSize) {
+            stats.hits++;
+        } else {
+            stats.misses++;
+        }
+
+        stats.outstanding++;
+        stats.highWater = std::max(stats.highWater, stats.outstanding);
+        sequence = ++m_state->nextSequence;
+    }
+
+    if (!frame) {
+        frame = new capture::Frame();
+    }
+
+    // Default-initializing allocator: growing the size does not touch the bytes
+    frame->data.resize(dataSize);
+    frame->dirtyRects.clear();
+    frame->dirtyTiles.clear();
+    frame->identical = false;
+    frame->sequence = sequence;
+
+    return std::shared_ptr<capture::Frame>(frame, Recycler{m_state},
+                                           CachedAllocator<capture::Frame>(m_state->controlBlocks));
+}
+
+FramePoolStats FramePool::getStats() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    FramePoolStats stats = m_state->stats;
+    stats.pooled = m_state->freeFrames.size();
+    return stats;
+}
+
+} // namespace talos
@@ -0,0 +1,43 @@
+#include "core/memory_pool.h"
+
+namespace talos {
+
+BlockCache::BlockCache(std::size_t maxCachedBlocks)
+    : m_blockSize(0)
+    , m_maxCachedBlocks(maxCachedBlocks) {
+    m_freeBlocks.reserve(maxCachedBlocks);
+}
+
+BlockCache::~BlockCache() {
+    for (void* block : m_freeBlocks) {
+        ::operator delete(block);
+    }
+}
+
+void* BlockCache::allocate(std::size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_blockSize == 0) {
+            m_blockSize = bytes;
+        }
+        if (bytes == m_blockSize && !m_freeBlocks.empty()) {
+            void* block = m_freeBlocks.back();
+            m_freeBlocks.pop_back();
+            return block;
+        }
+    }
+    return ::operator new(bytes);
+}
+
+void BlockCache::deallocate(void* block, std::size_t bytes) noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (bytes == m_blockSize && m_freeBlocks.size() < m_maxCachedBlocks) {
+            m_freeBlocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+} // namespace talos
@@ -0,0 +1,360 @@
+#include "core/quality_controller.h"
+#include "core/logger.h"
+#include "core/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace talos {
+
+namespace {
+
+uint64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string describe(const QualityLevel& level) {
+    return std::to_string(level.bitrate / 1000) + "kbps " + std::to_string(level.framerate) + "fps " +
+           std::to_string(level.width) + "x" + std::to_string(level.height);
+}
+
+} // namespace
+
+QualityController::QualityController(const QualityControllerConfig& config, const QualityLevel& ceiling)
+    : m_config(config)
+    , m_ceiling(ceiling)
+    , m_level(ceiling)
+    , m_resolutionStep(0)
+    , m_pressuredRun(0)
+    , m_cleanRun(0)
+    , m_cooldown(0) {
+    if (m_config.resolutionScales.empty()) {
+        m_config.resolutionScales.push_back(1.0f);
+    }
+    m_stats.current = m_level;
+}
+
+void QualityController::setListener(Listener listener) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_listener = std::move(listener);
+}
+
+bool QualityController::update(const QualitySignals& signals) {
+    QualityEvent event;
+    Listener listener;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.intervals++;
+
+        QualityReason reason = QualityReason::Recovered;
+        bool pressured = detectPressure(signals, reason);
+        if (pressured) {
+            m_stats.pressuredIntervals++;
+        }
+
+        // Let the previous change show up in the signals before judging again
+        if (m_cooldown > 0) {
+            m_cooldown--;
+            return false;
+        }
+
+        QualityLevel from = m_level;
+        QualityAction action = QualityAction::BitrateDown;
+        bool changed = false;
+
+        if (pressured) {
+            m_cleanRun = 0;
+            if (++m_pressuredRun >= m_config.degradeAfter) {
+                changed = stepDown(reason, action);
+            }
+        } else if (isClean(signals)) {
+            m_pressuredRun = 0;
+            if (++m_cleanRun >= m_config.recoverAfter) {
+                changed = stepUp(action);
+                reason = QualityReason::Recovered;
+            }
+        } else {
+            // Neither pressured nor clean: hold, and restart both runs
+            m_pressuredRun = 0;
+            m_cleanRun = 0;
+        }
+
+        if (!changed) {
+            return false;
+        }
+
+        m_pressuredRun = 0;
+        m_cleanRun = 0;
+        m_cooldown = m_config.cooldown;
+        record(action, reason, from, signals);
+        event = m_history.back();
+        listener = m_listener;
+    }
+
+    if (listener) {
+        listener(event);
+    }
+    return true;
+}
+
+QualityLevel QualityController::getLevel() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_level;
+}
+
+QualityControllerStats QualityController::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::vector<QualityEvent> QualityController::getHistory() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::vector<QualityEvent>(m_history.begin(), m_history.end());
+}
+
+bool QualityController::detectPressure(const QualitySignals& signals, QualityReason& reason) const {
+    // Most specific cause first: congestion is the only one bitrate fixes
+    if (signals.sendQueueGrowth > m_config.sendQueueGrowthHigh || signals.packetsDropped > 0) {
+        reason = QualityReason::NetworkCongestion;
+        return true;
+    }
+    if ((signals.frameBudgetMs > 0.0f && signals.encodeMs > m_config.encodeBudgetHigh * signals.frameBudgetMs) ||
+        signals.queueFill > m_config.queueFillHigh) {
+        reason = QualityReason::EncoderOverload;
+        return true;
+    }
+    if (signals.cpuUsage > m_config.cpuHigh) {
+        reason = QualityReason::CpuOverload;
+        return true;
+    }
+    if (signals.captureDropRate > m_config.captureDropHigh) {
+        reason = QualityReason::CaptureDrops;
+        return true;
+    }
+    return false;
+}
+
+bool QualityController::isClean(const QualitySignals& signals) const {
+    bool encodeClean = signals.frameBudgetMs <= 0.0f ||
+                       signals.encodeMs <= m_config.encodeBudgetLow * signals.frameBudgetMs;
+    return encodeClean &&
+           signals.sendQueueGrowth <= m_config.sendQueueGrowthLow &&
+           signals.packetsDropped == 0 &&
+           signals.queueFill <= m_config.queueFillLow &&
+           signals.cpuUsage <= m_config.cpuLow &&
+           signals.captureDropRate <= m_config.captureDropLow;
+}
+
+bool QualityController::stepDown(QualityReason reason, QualityAction& action) {
+    int minBitrate = std::min(m_config.minBitrate, m_ceiling.bitrate);
+    int minFramerate = std::min(m_config.minFramerate, m_ceiling.framerate);
+    bool network = reason == QualityReason::NetworkCongestion;
+
+    if (network && m_level.bitrate > minBitrate) {
+        m_level.bitrate = std::max(minBitrate, static_cast<int>(m_level.bitrate * m_config.bitrateDownFactor));
+        action = QualityAction::BitrateDown;
+        m_stats.bitrateChanges++;
+        return true;
+    }
+    if (m_level.framerate > minFramerate) {
+        m_level.framerate = std::max(minFramerate, m_level.framerate - m_config.framerateStep);
+        action = QualityAction::FramerateDown;
+        m_stats.framerateChanges++;
+        return true;
+    }
+    if (m_resolutionStep + 1 < m_config.resolutionScales.size()) {
+        m_resolutionStep++;
+        applyResolution();
+        action = QualityAction::ResolutionDown;
+        m_stats.resolutionChanges++;
+        return true;
+    }
+    // Out of frame rate and resolution steps: a smaller bitrate is all that is left
+    if (!network && m_level.bitrate > minBitrate) {
+        m_level.bitrate = std::max(minBitrate, static_cast<int>(m_level.bitrate * m_config.bitrateDownFactor));
+        action = QualityAction::BitrateDown;
+        m_stats.bitrateChanges++;
+        return true;
+    }
+    return false;
+}
+
+bool QualityController::stepUp(QualityAction& action) {
+    // The ladder in reverse: resolution was given up last, so it returns first
+    if (m_resolutionStep > 0) {
+        m_resolutionStep--;
+        applyResolution();
+        action = QualityAction::ResolutionUp;
+        m_stats.resolutionChanges++;
+        return true;
+    }
+    if (m_level.framerate < m_ceiling.framerate) {
+        m_level.framerate = std::min(m_ceiling.framerate, m_level.framerate + m_config.framerateStep);
+        action = QualityAction::FramerateUp;
+        m_stats.framerateChanges++;
+        return true;
+    }
+    if (m_level.bitrate < m_ceiling.bitrate) {
+        m_level.bitrate = std::min(m_ceiling.bitrate, static_cast<int>(m_level.bitrate * m_config.bitrateUpFactor));
+        action = QualityAction::BitrateUp;
+        m_stats.bitrateChanges++;
+        return true;
+    }
+    return false;
+}
+
+void QualityController::applyResolution() {
+    // Even dimensions keep 4:2:0 chroma whole
+    float scale = m_config.resolutionScales[m_resolutionStep];
+    m_level.width = std::max(2, static_cast<int>(std::lround(m_ceiling.width * scale)) & ~1);
+    m_level.height = std::max(2, static_cast<int>(std::lround(m_ceiling.height * scale)) & ~1);
+}
+
+void QualityController::record(QualityAction action, QualityReason reason, const QualityLevel& from,
+                               const QualitySignals& signals) {
+    QualityEvent event;
+    event.timestamp = nowMicros();
+    event.action = action;
+    event.reason = reason;
+    event.from = from;
+    event.to = m_level;
+    event.signals = signals;
+
+    m_history.push_back(event);
+    while (m_history.size() > std::max<size_t>(m_config.historySize, 1)) {
+        m_history.pop_front();
+    }
+    m_stats.current = m_level;
+
+    Logger::instance().info(std::string("Quality ") + actionName(action) + " (" + reasonName(reason) + "): " +
+                            describe(from) + " -> " + describe(m_level));
+}
+
+QualityLevel QualityController::levelOf(const encoder::EncoderConfig& config) {
+    QualityLevel level;
+    level.bitrate = config.bitrate;
+    level.framerate = config.framerate;
+    level.width = config.width;
+    level.height = config.height;
+    return level;
+}
+
+encoder::EncoderConfig QualityController::configFor(const encoder::EncoderConfig& base, const QualityLevel& level) {
+    encoder::EncoderConfig config = base;
+    config.width = level.width;
+    config.height = level.height;
+    config.framerate = level.framerate;
+    config.bitrate = level.bitrate;
+
+    // A bitrate target, capped by the VBV at the same rate
+    config.crf = -1;
+    return config;
+}
+
+const char* QualityController::actionName(QualityAction action) {
+    switch (action) {
+        case QualityAction::BitrateDown: return "bitrate-down";
+        case QualityAction::FramerateDown: return "framerate-down";
+        case QualityAction::ResolutionDown: return "resolution-down";
+        case QualityAction::BitrateUp: return "bitrate-up";
+        case QualityAction::FramerateUp: return "framerate-up";
+        case QualityAction::ResolutionUp: return "resolution-up";
+    }
+    return "unknown";
+}
+
+const char* QualityController::reasonName(QualityReason reason) {
+    switch (reason) {
+        case QualityReason::NetworkCongestion: return "network-congestion";
+        case QualityReason::EncoderOverload: return "encoder-overload";
+        case QualityReason::CpuOverload: return "cpu-overload";
+        case QualityReason::CaptureDrops: return "capture-drops";
+        case QualityReason::Recovered: return "recovered";
+    }
+    return "unknown";
+}
+
+QualitySampler::QualitySampler()
+    : m_primed(false)
+    , m_lastCpuSeconds(0.0)
+    , m_lastCaptured(0)
+    , m_lastCaptureDropped(0)
+    , m_lastPipelineDropped(0)
+    , m_lastPacketsDropped(0) {
+}
+
+QualitySignals QualitySampler::sample(const capture::CaptureStats& capture, const PipelineStats& pipeline,
+                                      const encoder::EncoderStats& encoder, int framerate,
+                                      float sendQueueGrowth) {
+    auto now = std::chrono::steady_clock::now();
+    double cpuSeconds = processCpuSeconds();
+    uint64_t pipelineDropped = pipeline.framesDropped + pipeline.preparedDropped;
+
+    QualitySignals signals;
+    signals.queueFill = pipeline.maxQueueFill;
+    // Conversion and encoding run on their own pipeline threads, so the
+    // slower of the two sets the frame rate that can be sustained
+    signals.encodeMs = std::max(encoder.conversionMs, encoder.encodeMs);
+    signals.frameBudgetMs = framerate > 0 ? 1000.0f / framerate : 0.0f;
+    signals.sendQueueGrowth = sendQueueGrowth;
+
+    // Counters reset when the pipeline restarts; treat that as a fresh start
+    if (m_primed && capture.framesCapture >= m_lastCaptured && pipelineDropped >= m_lastPipelineDropped &&
+        pipeline.packetsDropped >= m_lastPacketsDropped) {
+        double wallSeconds = std::chrono::duration<double>(now - m_lastTime).count();
+        if (wallSeconds > 0.0) {
+            double cores = static_cast<double>(ThreadPool::hardwareConcurrency());
+            signals.cpuUsage = static_cast<float>((cpuSeconds - m_lastCpuSeconds) / (wallSeconds * cores));
+        }
+
+        uint64_t captured = capture.framesCapture - m_lastCaptured;
+        uint64_t dropped = (capture.framesDropped - std::min(capture.framesDropped, m_lastCaptureDropped)) +
+                           (pipelineDropped - m_lastPipelineDropped);
+        if (captured > 0) {
+            signals.captureDropRate = std::min(1.0f, static_cast<float>(dropped) / captured);
+        }
+        signals.packetsDropped = pipeline.packetsDropped - m_lastPacketsDropped;
+    }
+
+    m_primed = true;
+    m_lastTime = now;
+    m_lastCpuSeconds = cpuSeconds;
+    m_lastCaptured = capture.framesCapture;
+    m_lastCaptureDropped = capture.framesDropped;
+    m_lastPipelineDropped = pipelineDropped;
+    m_lastPacketsDropped = pipeline.packetsDropped;
+    return signals;
+}
+
+double QualitySampler::processCpuSeconds() {
+#ifdef PLATFORM_WINDOWS
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    auto toSeconds = [](const FILETIME& time) {
+        ULARGE_INTEGER value;
+        value.LowPart = time.dwLowDateTime;
+        value.HighPart = time.dwHighDateTime;
+        return static_cast<double>(value.QuadPart) / 1e7;  // 100 ns units
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    auto toSeconds = [](const struct timeval& time) {
+        return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+    };
+    return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+#endif
+}
+
+} // namespace talos
@@ -0,0 +1,105 @@
+#include "core/thread_pool.h"
+#include <algorithm>
+
+namespace talos {
+
+ThreadPool::ThreadPool(size_t workerCount)
+    : m_task(nullptr)
+    , m_count(0)
+    , m_nextItem(0)
+    , m_generation(0)
+    , m_busyWorkers(0)
+    , m_stopping(false) {
+    m_workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t ThreadPool::hardwareConcurrency() {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (m_workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> job(m_jobMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_nextItem.store(0, std::memory_order_relaxed);
+        m_busyWorkers = m_workers.size();
+        m_generation++;
+    }
+    m_jobAvailable.notify_all();
+
+    runItems();
+
+    // Every worker checks in once per job, so none can still hold the task
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobFinished.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::runItems() {
+    for (;;) {
+        size_t item = m_nextItem.fetch_add(1, std::memory_order_relaxed);
+        if (item >= m_count) {
+            return;
+        }
+        (*m_task)(item);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seenGeneration = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this, seenGeneration] {
+                return m_stopping || m_generation != seenGeneration;
+            });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+
+        runItems();
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            last = --m_busyWorkers == 0;
+        }
+        if (last) {
+            m_jobFinished.notify_one();
+        }
+    }
+}
+
+} // namespace talos
@@ -0,0 +1,230 @@
+#include "core/video_encoding_pipeline.h"
+#include "core/logger.h"
+#include <algorithm>
+#include <chrono>
+
+namespace talos {
+
+namespace {
+
+uint64_t captureClockMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+VideoEncodingPipeline::VideoEncodingPipeline(ICaptureEngine& captureEngine, VideoEncoder& encoder,
+                                             const PipelineConfig& config)
+    : m_captureEngine(captureEngine)
+    , m_encoder(encoder)
+    , m_config(config)
+    , m_frameQueue(config.frames.capacity, config.frames.policy)
+    , m_preparedQueue(config.prepared.capacity, config.prepared.policy)
+    , m_packetQueue(config.packets.capacity, config.packets.policy,
+                    [](const encoder::EncodedPacketPtr& packet) { return packet && packet->keyframe; })
+    , m_running(false)
+    , m_startedCapture(false)
+    , m_framesCaptured(0)
+    , m_framesPrepared(0)
+    , m_framesEncoded(0)
+    , m_packetsPublished(0)
+    , m_errors(0) {
+}
+
+VideoEncodingPipeline::~VideoEncodingPipeline() {
+    stop();
+}
+
+void VideoEncodingPipeline::addSink(PacketSink sink) {
+    if (m_running) {
+        Logger::instance().warn("Cannot add a packet sink while the pipeline is running");
+        return;
+    }
+    m_sinks.push_back(std::move(sink));
+}
+
+bool VideoEncodingPipeline::start() {
+    if (m_running) {
+        return true;
+    }
+
+    if (!m_encoder.isInitialized()) {
+        Logger::instance().error("Cannot start pipeline: encoder not initialized");
+        return false;
+    }
+
+    m_startedCapture = false;
+    if (!m_captureEngine.isCapturing()) {
+        if (!m_captureEngine.startCapture()) {
+            Logger::instance().error("Cannot start pipeline: capture failed to start");
+            return false;
+        }
+        m_startedCapture = true;
+    }
+
+    m_frameQueue.open();
+    m_preparedQueue.open();
+    m_packetQueue.open();
+    m_framesCaptured = 0;
+    m_framesPrepared = 0;
+    m_framesEncoded = 0;
+    m_packetsPublished = 0;
+    m_errors = 0;
+
+    m_running = true;
+    m_publishThread = std::thread(&VideoEncodingPipeline::publishLoop, this);
+    m_encodeThread = std::thread(&VideoEncodingPipeline::encodeLoop, this);
+    m_convertThread = std::thread(&VideoEncodingPipeline::convertLoop, this);
+    m_captureThread = std::thread(&VideoEncodingPipeline::captureLoop, this);
+
+    Logger::instance().info("Video encoding pipeline started");
+    return true;
+}
+
+void VideoEncodingPipeline::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    // Closing wakes every stage blocked on a queue
+    m_frameQueue.close();
+    m_preparedQueue.close();
+    m_packetQueue.close();
+
+    for (std::thread* thread : {&m_captureThread, &m_convertThread, &m_encodeThread, &m_publishThread}) {
+        if (thread->joinable()) {
+            thread->join();
+        }
+    }
+
+    m_frameQueue.clear();
+    m_preparedQueue.clear();
+    m_packetQueue.clear();
+
+    if (m_startedCapture) {
+        m_captureEngine.stopCapture();
+        m_startedCapture = false;
+    }
+
+    Logger::instance().info("Video encoding pipeline stopped");
+}
+
+PipelineStats VideoEncodingPipeline::getStats() const {
+    PipelineStats stats;
+    stats.framesCaptured = m_framesCaptured.load(std::memory_order_relaxed);
+    stats.framesPrepared = m_framesPrepared.load(std::memory_order_relaxed);
+    stats.framesEncoded = m_framesEncoded.load(std::memory_order_relaxed);
+    stats.packetsPublished = m_packetsPublished.load(std::memory_order_relaxed);
+    stats.framesDropped = m_frameQueue.droppedCount();
+    stats.preparedDropped = m_preparedQueue.droppedCount();
+    stats.packetsDropped = m_packetQueue.droppedCount();
+    stats.errors = m_errors.load(std::memory_order_relaxed);
+
+    stats.framesQueued = m_frameQueue.size();
+    stats.preparedQueued = m_preparedQueue.size();
+    stats.packetsQueued = m_packetQueue.size();
+    stats.maxQueueFill = std::max({
+        static_cast<float>(stats.framesQueued) / m_frameQueue.capacity(),
+        static_cast<float>(stats.preparedQueued) / m_preparedQueue.capacity(),
+        static_cast<float>(stats.packetsQueued) / m_packetQueue.capacity()});
+    return stats;
+}
+
+void VideoEncodingPipeline::captureLoop() {
+    while (m_running) {
+        auto frame = m_captureEngine.getNextFrame(m_config.stageTimeoutMs);
+        if (!frame) {
+            continue;
+        }
+        m_framesCaptured.fetch_add(1, std::memory_order_relaxed);
+        m_frameQueue.push(std::move(frame));
+    }
+}
+
+void VideoEncodingPipeline::convertLoop() {
+    std::shared_ptr<capture::Frame> frame;
+    while (m_running) {
+        encoder::PreparedFramePtr prepared;
+
+        // Changes of a dropped frame must not wait a whole poll period
+        uint32_t timeoutMs = m_config.stageTimeoutMs;
+        uint64_t due = m_encoder.pendingChangesDue();
+        if (due != 0) {
+            uint64_t now = captureClockMicros();
+            uint64_t waitMs = due > now ? (due - now + 999) / 1000 : 0;
+            timeoutMs = static_cast<uint32_t>(std::min<uint64_t>(waitMs, timeoutMs));
+        }
+
+        bool ok;
+        if (m_frameQueue.pop(frame, timeoutMs)) {
+            ok = m_encoder.prepareFrame(*frame, prepared);
+
+            // Return the capture buffer before waiting on the next stage
+            frame.reset();
+        } else if (m_running) {
+            // Capture went quiet, e.g. a static screen on a damage-driven
+            // engine; the encoder repeats its picture when one is due
+            ok = m_encoder.prepareKeepAlive(captureClockMicros(), prepared);
+        } else {
+            break;
+        }
+
+        if (!ok) {
+            m_errors.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (prepared) {
+            m_framesPrepared.fetch_add(1, std::memory_order_relaxed);
+            m_preparedQueue.push(std::move(prepared));
+        }
+    }
+}
+
+void VideoEncodingPipeline::encodeLoop() {
+    encoder::PreparedFramePtr prepared;
+    encoder::EncodedPacketPtr packet;
+    uint64_t packetsDropped = 0;
+    while (m_running) {
+        if (!m_preparedQueue.pop(prepared, m_config.stageTimeoutMs)) {
+            continue;
+        }
+
+        bool ok = m_encoder.encodePreparedFrame(prepared);
+        prepared.reset();
+        if (ok) {
+            m_framesEncoded.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            m_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Packets can appear even after a failed send, so always drain
+        while (m_encoder.getEncodedPacket(packet)) {
+            m_packetQueue.push(std::move(packet));
+        }
+
+        // Consumers cannot decode past dropped packets until the next keyframe
+        uint64_t dropped = m_packetQueue.droppedCount();
+        if (dropped != packetsDropped) {
+            packetsDropped = dropped;
+            m_encoder.requestKeyframe();
+        }
+    }
+}
+
+void VideoEncodingPipeline::publishLoop() {
+    encoder::EncodedPacketPtr packet;
+    while (m_running) {
+        if (!m_packetQueue.pop(packet, m_config.stageTimeoutMs)) {
+            continue;
+        }
+
+        for (const auto& sink : m_sinks) {
+            sink(packet);
+        }
+        packet.reset();
+        m_packetsPublished.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace talos
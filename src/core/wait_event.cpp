@@ -0,0 +1,90 @@
+#include "core/wait_event.h"
+
+#if defined(PLATFORM_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#elif defined(PLATFORM_WINDOWS)
+#include <windows.h>
+#endif
+
+namespace talos {
+
+#if defined(PLATFORM_LINUX)
+namespace {
+
+long futexWait(std::atomic<uint32_t>* address, uint32_t expected, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAIT_PRIVATE,
+                   expected, timeout, nullptr, 0);
+}
+
+long futexWakeAll(std::atomic<uint32_t>* address) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE_PRIVATE,
+                   INT32_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace
+#endif
+
+uint32_t WaitEvent::prepareWait() {
+    // seq_cst pairs with notify(): either it sees us waiting or we see its new epoch
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    return m_epoch.load(std::memory_order_seq_cst);
+}
+
+void WaitEvent::cancelWait() {
+    m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+bool WaitEvent::wait(uint32_t epoch, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool notified = true;
+
+    while (m_epoch.load(std::memory_order_acquire) == epoch) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            notified = false;
+            break;
+        }
+
+#if defined(PLATFORM_LINUX)
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(remaining.count() / 1000);
+        ts.tv_nsec = static_cast<long>((remaining.count() % 1000) * 1000000);
+        futexWait(&m_epoch, epoch, &ts);
+#elif defined(PLATFORM_WINDOWS)
+        WaitOnAddress(&m_epoch, &epoch, sizeof(epoch), static_cast<DWORD>(remaining.count()));
+#else
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait_for(lock, remaining, [this, epoch] {
+            return m_epoch.load(std::memory_order_acquire) != epoch;
+        });
+#endif
+    }
+
+    m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    return notified;
+}
+
+void WaitEvent::notify() {
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_seq_cst) == 0) {
+        return;
+    }
+
+#if defined(PLATFORM_LINUX)
+    futexWakeAll(&m_epoch);
+#elif defined(PLATFORM_WINDOWS)
+    WakeByAddressAll(&m_epoch);
+#else
+    {
+        // Empty critical section orders the epoch bump against a waiter's predicate check
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_condition.notify_all();
+#endif
+}
+
+} // namespace talos
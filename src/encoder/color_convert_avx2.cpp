@@ -0,0 +1,104 @@
+#include "encoder/color_converter.h"
+
+#if defined(TALOS_COLOR_CONVERT_X86)
+
+#include <immintrin.h>
+
+namespace talos {
+namespace encoder {
+namespace kernels {
+
+namespace {
+
+// Weighted sums of eight pixels in order, already shifted down
+inline __m256i weighPixels8(__m256i pixels, __m256i weights, __m256i bias) {
+    __m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(pixels));
+    __m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(pixels, 1));
+    // hadd works per 128-bit lane and yields pixels 0,1,4,5,2,3,6,7
+    __m256i sums = _mm256_hadd_epi32(_mm256_madd_epi16(lo, weights), _mm256_madd_epi16(hi, weights));
+    sums = _mm256_permutevar8x32_epi32(sums, _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+    return _mm256_srai_epi32(_mm256_add_epi32(sums, bias), 15);
+}
+
+// Per-channel sums of four 2x2 blocks, as lanes [0, 2 | 1, 3]
+inline __m256i sumBlocks4(__m256i row0, __m256i row1) {
+    __m256i lo = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(row0)),
+                                  _mm256_cvtepu8_epi16(_mm256_castsi256_si128(row1)));
+    __m256i hi = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(row0, 1)),
+                                  _mm256_cvtepu8_epi16(_mm256_extracti128_si256(row1, 1)));
+    lo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+    hi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+    return _mm256_unpacklo_epi64(lo, hi);
+}
+
+// Weighted sums of eight blocks in order, already shifted down
+inline __m256i weighBlocks8(__m256i blocksA, __m256i blocksB, __m256i weights, __m256i bias) {
+    __m256i sums = _mm256_hadd_epi32(_mm256_madd_epi16(blocksA, weights), _mm256_madd_epi16(blocksB, weights));
+    sums = _mm256_permutevar8x32_epi32(sums, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    return _mm256_srai_epi32(_mm256_add_epi32(sums, bias), 17);
+}
+
+inline __m128i narrowToWords(__m256i values) {
+    return _mm_packs_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+}
+
+inline void storeLuma16(uint8_t* dst, __m256i pixelsA, __m256i pixelsB, __m256i weights, __m256i bias) {
+    __m128i wordsA = narrowToWords(weighPixels8(pixelsA, weights, bias));
+    __m128i wordsB = narrowToWords(weighPixels8(pixelsB, weights, bias));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(wordsA, wordsB));
+}
+
+inline __m256i broadcastWeights(const int16_t* w) {
+    return _mm256_setr_epi16(w[0], w[1], w[2], 0, w[0], w[1], w[2], 0,
+                             w[0], w[1], w[2], 0, w[0], w[1], w[2], 0);
+}
+
+} // namespace
+
+void convertRowPairAvx2(const ConversionCoefficients& coeffs,
+                        const uint8_t* src0, const uint8_t* src1,
+                        uint8_t* y0, uint8_t* y1,
+                        uint8_t* u, uint8_t* v, int width) {
+    const __m256i yWeights = broadcastWeights(coeffs.y);
+    const __m256i uWeights = broadcastWeights(coeffs.u);
+    const __m256i vWeights = broadcastWeights(coeffs.v);
+    const __m256i yBias = _mm256_set1_epi32(coeffs.yBias);
+    const __m256i uvBias = _mm256_set1_epi32(coeffs.uvBias);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 4));
+        __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 4 + 32));
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 4));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 4 + 32));
+
+        storeLuma16(y0 + x, a0, a1, yWeights, yBias);
+        storeLuma16(y1 + x, b0, b1, yWeights, yBias);
+
+        __m256i blocksA = sumBlocks4(a0, b0);
+        __m256i blocksB = sumBlocks4(a1, b1);
+        __m128i cb = narrowToWords(weighBlocks8(blocksA, blocksB, uWeights, uvBias));
+        __m128i cr = narrowToWords(weighBlocks8(blocksA, blocksB, vWeights, uvBias));
+
+        // Bytes 0-7 hold U, bytes 8-15 hold V
+        __m128i bytes = _mm_packus_epi16(cb, cr);
+        if (v) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2), bytes);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2), _mm_srli_si128(bytes, 8));
+        } else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x),
+                             _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 8)));
+        }
+    }
+
+    if (x < width) {
+        convertRowPairScalar(coeffs, src0 + x * 4, src1 + x * 4, y0 + x, y1 + x,
+                             v ? u + x / 2 : u + x, v ? v + x / 2 : nullptr, width - x);
+    }
+}
+
+} // namespace kernels
+} // namespace encoder
+} // namespace talos
+
+#endif // TALOS_COLOR_CONVERT_X86
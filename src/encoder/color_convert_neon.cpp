@@ -0,0 +1,88 @@
+#include "encoder/color_converter.h"
+
+#if defined(TALOS_COLOR_CONVERT_NEON)
+
+#include <arm_neon.h>
+
+namespace talos {
+namespace encoder {
+namespace kernels {
+
+namespace {
+
+// Weighted sums of eight channel triples, shifted down and saturated to bytes
+template <int Shift>
+inline uint8x8_t weigh8(int16x8_t c0, int16x8_t c1, int16x8_t c2, const int16_t* w, int32x4_t bias) {
+    int32x4_t lo = vmlal_n_s16(bias, vget_low_s16(c0), w[0]);
+    lo = vmlal_n_s16(lo, vget_low_s16(c1), w[1]);
+    lo = vmlal_n_s16(lo, vget_low_s16(c2), w[2]);
+    int32x4_t hi = vmlal_n_s16(bias, vget_high_s16(c0), w[0]);
+    hi = vmlal_n_s16(hi, vget_high_s16(c1), w[1]);
+    hi = vmlal_n_s16(hi, vget_high_s16(c2), w[2]);
+    int16x8_t words = vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, Shift)), vqmovn_s32(vshrq_n_s32(hi, Shift)));
+    return vqmovun_s16(words);
+}
+
+inline int16x8_t widenLow(uint8x16_t bytes) {
+    return vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(bytes)));
+}
+
+inline int16x8_t widenHigh(uint8x16_t bytes) {
+    return vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(bytes)));
+}
+
+inline uint8x16_t luma16(const uint8x16x4_t& px, const int16_t* w, int32x4_t bias) {
+    uint8x8_t lo = weigh8<15>(widenLow(px.val[0]), widenLow(px.val[1]), widenLow(px.val[2]), w, bias);
+    uint8x8_t hi = weigh8<15>(widenHigh(px.val[0]), widenHigh(px.val[1]), widenHigh(px.val[2]), w, bias);
+    return vcombine_u8(lo, hi);
+}
+
+// Per-block channel sums of a 16x2 strip
+inline int16x8_t sumBlocks(uint8x16_t row0, uint8x16_t row1) {
+    return vreinterpretq_s16_u16(vaddq_u16(vpaddlq_u8(row0), vpaddlq_u8(row1)));
+}
+
+} // namespace
+
+void convertRowPairNeon(const ConversionCoefficients& coeffs,
+                        const uint8_t* src0, const uint8_t* src1,
+                        uint8_t* y0, uint8_t* y1,
+                        uint8_t* u, uint8_t* v, int width) {
+    const int32x4_t yBias = vdupq_n_s32(coeffs.yBias);
+    const int32x4_t uvBias = vdupq_n_s32(coeffs.uvBias);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        // De-interleaves into one register per byte position
+        uint8x16x4_t a = vld4q_u8(src0 + x * 4);
+        uint8x16x4_t b = vld4q_u8(src1 + x * 4);
+
+        vst1q_u8(y0 + x, luma16(a, coeffs.y, yBias));
+        vst1q_u8(y1 + x, luma16(b, coeffs.y, yBias));
+
+        int16x8_t s0 = sumBlocks(a.val[0], b.val[0]);
+        int16x8_t s1 = sumBlocks(a.val[1], b.val[1]);
+        int16x8_t s2 = sumBlocks(a.val[2], b.val[2]);
+        uint8x8_t cb = weigh8<17>(s0, s1, s2, coeffs.u, uvBias);
+        uint8x8_t cr = weigh8<17>(s0, s1, s2, coeffs.v, uvBias);
+
+        if (v) {
+            vst1_u8(u + x / 2, cb);
+            vst1_u8(v + x / 2, cr);
+        } else {
+            uint8x8x2_t interleaved = {{cb, cr}};
+            vst2_u8(u + x, interleaved);
+        }
+    }
+
+    if (x < width) {
+        convertRowPairScalar(coeffs, src0 + x * 4, src1 + x * 4, y0 + x, y1 + x,
+                             v ? u + x / 2 : u + x, v ? v + x / 2 : nullptr, width - x);
+    }
+}
+
+} // namespace kernels
+} // namespace encoder
+} // namespace talos
+
+#endif // TALOS_COLOR_CONVERT_NEON
@@ -0,0 +1,94 @@
+#include "encoder/color_converter.h"
+
+#if defined(TALOS_COLOR_CONVERT_X86)
+
+#include <smmintrin.h>
+#include <cstring>
+
+namespace talos {
+namespace encoder {
+namespace kernels {
+
+namespace {
+
+// Weighted sums of four pixels, already shifted down
+inline __m128i weighPixels4(__m128i pixels, __m128i weights, __m128i bias) {
+    __m128i lo = _mm_cvtepu8_epi16(pixels);
+    __m128i hi = _mm_cvtepu8_epi16(_mm_srli_si128(pixels, 8));
+    __m128i sums = _mm_hadd_epi32(_mm_madd_epi16(lo, weights), _mm_madd_epi16(hi, weights));
+    return _mm_srai_epi32(_mm_add_epi32(sums, bias), 15);
+}
+
+// Per-channel sums of two 2x2 blocks (four columns of two rows)
+inline __m128i sumBlocks2(__m128i row0, __m128i row1) {
+    __m128i lo = _mm_add_epi16(_mm_cvtepu8_epi16(row0), _mm_cvtepu8_epi16(row1));
+    __m128i hi = _mm_add_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(row0, 8)),
+                               _mm_cvtepu8_epi16(_mm_srli_si128(row1, 8)));
+    return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+}
+
+inline __m128i weighBlocks4(__m128i blocksA, __m128i blocksB, __m128i weights, __m128i bias) {
+    __m128i sums = _mm_hadd_epi32(_mm_madd_epi16(blocksA, weights), _mm_madd_epi16(blocksB, weights));
+    return _mm_srai_epi32(_mm_add_epi32(sums, bias), 17);
+}
+
+inline void storeLuma8(uint8_t* dst, __m128i pixelsA, __m128i pixelsB, __m128i weights, __m128i bias) {
+    __m128i words = _mm_packs_epi32(weighPixels4(pixelsA, weights, bias), weighPixels4(pixelsB, weights, bias));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(words, words));
+}
+
+} // namespace
+
+void convertRowPairSse41(const ConversionCoefficients& coeffs,
+                         const uint8_t* src0, const uint8_t* src1,
+                         uint8_t* y0, uint8_t* y1,
+                         uint8_t* u, uint8_t* v, int width) {
+    const __m128i yWeights = _mm_setr_epi16(coeffs.y[0], coeffs.y[1], coeffs.y[2], 0,
+                                            coeffs.y[0], coeffs.y[1], coeffs.y[2], 0);
+    const __m128i uWeights = _mm_setr_epi16(coeffs.u[0], coeffs.u[1], coeffs.u[2], 0,
+                                            coeffs.u[0], coeffs.u[1], coeffs.u[2], 0);
+    const __m128i vWeights = _mm_setr_epi16(coeffs.v[0], coeffs.v[1], coeffs.v[2], 0,
+                                            coeffs.v[0], coeffs.v[1], coeffs.v[2], 0);
+    const __m128i yBias = _mm_set1_epi32(coeffs.yBias);
+    const __m128i uvBias = _mm_set1_epi32(coeffs.uvBias);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 4));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 4 + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 4));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 4 + 16));
+
+        storeLuma8(y0 + x, a0, a1, yWeights, yBias);
+        storeLuma8(y1 + x, b0, b1, yWeights, yBias);
+
+        __m128i blocksA = sumBlocks2(a0, b0);
+        __m128i blocksB = sumBlocks2(a1, b1);
+        __m128i cb = weighBlocks4(blocksA, blocksB, uWeights, uvBias);
+        __m128i cr = weighBlocks4(blocksA, blocksB, vWeights, uvBias);
+
+        // Bytes 0-3 hold U, bytes 4-7 hold V
+        __m128i words = _mm_packs_epi32(cb, cr);
+        __m128i bytes = _mm_packus_epi16(words, words);
+        if (v) {
+            int32_t uBytes = _mm_cvtsi128_si32(bytes);
+            int32_t vBytes = _mm_extract_epi32(bytes, 1);
+            std::memcpy(u + x / 2, &uBytes, sizeof(uBytes));
+            std::memcpy(v + x / 2, &vBytes, sizeof(vBytes));
+        } else {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x),
+                             _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 4)));
+        }
+    }
+
+    if (x < width) {
+        convertRowPairScalar(coeffs, src0 + x * 4, src1 + x * 4, y0 + x, y1 + x,
+                             v ? u + x / 2 : u + x, v ? v + x / 2 : nullptr, width - x);
+    }
+}
+
+} // namespace kernels
+} // namespace encoder
+} // namespace talos
+
+#endif // TALOS_COLOR_CONVERT_X86
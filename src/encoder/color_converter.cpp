@@ -0,0 +1,283 @@
+#include "encoder/color_converter.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(TALOS_COLOR_CONVERT_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace talos {
+namespace encoder {
+
+namespace {
+
+struct MatrixWeights {
+    double kr;
+    double kb;
+};
+
+MatrixWeights weightsFor(ColorMatrix matrix) {
+    switch (matrix) {
+        case ColorMatrix::BT601:
+            return {0.299, 0.114};
+        case ColorMatrix::BT709:
+        default:
+            return {0.2126, 0.0722};
+    }
+}
+
+int16_t toQ15(double value) {
+    return static_cast<int16_t>(std::lround(value * 32768.0));
+}
+
+ConversionCoefficients buildCoefficients(capture::PixelFormat srcFormat, ColorMatrix matrix, bool fullRange) {
+    MatrixWeights w = weightsFor(matrix);
+    double lumaScale = fullRange ? 1.0 : 219.0 / 255.0;
+    double chromaScale = fullRange ? 1.0 : 224.0 / 255.0;
+
+    // Derive the last weight of each row from the others so white maps to
+    // exactly 235 (255) and every grey to exactly 128 chroma
+    int16_t yr = toQ15(w.kr * lumaScale);
+    int16_t yb = toQ15(w.kb * lumaScale);
+    int16_t yg = static_cast<int16_t>(toQ15(lumaScale) - yr - yb);
+
+    int16_t ub = toQ15(0.5 * chromaScale);
+    int16_t ur = toQ15(-w.kr / (2.0 * (1.0 - w.kb)) * chromaScale);
+    int16_t ug = static_cast<int16_t>(-ub - ur);
+
+    int16_t vr = toQ15(0.5 * chromaScale);
+    int16_t vb = toQ15(-w.kb / (2.0 * (1.0 - w.kr)) * chromaScale);
+    int16_t vg = static_cast<int16_t>(-vr - vb);
+
+    bool bgr = srcFormat == capture::PixelFormat::BGRA8;
+    ConversionCoefficients coeffs = {
+        {bgr ? yb : yr, yg, bgr ? yr : yb, 0},
+        {bgr ? ub : ur, ug, bgr ? ur : ub, 0},
+        {bgr ? vb : vr, vg, bgr ? vr : vb, 0},
+        ((fullRange ? 0 : 16) << 15) + (1 << 14),
+        (128 << 17) + (1 << 16)
+    };
+    return coeffs;
+}
+
+#if defined(TALOS_COLOR_CONVERT_X86)
+bool cpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // The OS must save YMM state across context switches
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool cpuSupportsSse41() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+#endif
+
+struct KernelEntry {
+    const char* name;
+    RowPairKernel kernel;
+};
+
+// Widest first, so the first entry is the one to use by default
+std::vector<KernelEntry> availableKernels() {
+    std::vector<KernelEntry> entries;
+#if defined(TALOS_COLOR_CONVERT_X86)
+    if (cpuSupportsAvx2()) {
+        entries.push_back({"avx2", kernels::convertRowPairAvx2});
+    }
+    if (cpuSupportsSse41()) {
+        entries.push_back({"sse4.1", kernels::convertRowPairSse41});
+    }
+#elif defined(TALOS_COLOR_CONVERT_NEON)
+    // Advanced SIMD is mandatory on AArch64
+    entries.push_back({"neon", kernels::convertRowPairNeon});
+#endif
+    entries.push_back({"scalar", kernels::convertRowPairScalar});
+    return entries;
+}
+
+inline uint8_t clampToByte(int32_t value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+} // namespace
+
+namespace kernels {
+
+void convertRowPairScalar(const ConversionCoefficients& coeffs,
+                          const uint8_t* src0, const uint8_t* src1,
+                          uint8_t* y0, uint8_t* y1,
+                          uint8_t* u, uint8_t* v, int width) {
+    auto luma = [&coeffs](const uint8_t* p) {
+        int32_t sum = coeffs.y[0] * p[0] + coeffs.y[1] * p[1] + coeffs.y[2] * p[2] + coeffs.yBias;
+        return clampToByte(sum >> 15);
+    };
+
+    for (int x = 0; x < width; x += 2) {
+        const uint8_t* a = src0 + x * 4;
+        const uint8_t* c = src1 + x * 4;
+        // An odd last column pairs with itself
+        const uint8_t* b = (x + 1 < width) ? a + 4 : a;
+        const uint8_t* d = (x + 1 < width) ? c + 4 : c;
+
+        y0[x] = luma(a);
+        y1[x] = luma(c);
+        if (x + 1 < width) {
+            y0[x + 1] = luma(b);
+            y1[x + 1] = luma(d);
+        }
+
+        int32_t s0 = a[0] + b[0] + c[0] + d[0];
+        int32_t s1 = a[1] + b[1] + c[1] + d[1];
+        int32_t s2 = a[2] + b[2] + c[2] + d[2];
+        uint8_t cb = clampToByte((coeffs.u[0] * s0 + coeffs.u[1] * s1 + coeffs.u[2] * s2 + coeffs.uvBias) >> 17);
+        uint8_t cr = clampToByte((coeffs.v[0] * s0 + coeffs.v[1] * s1 + coeffs.v[2] * s2 + coeffs.uvBias) >> 17);
+
+        if (v) {
+            u[x / 2] = cb;
+            v[x / 2] = cr;
+        } else {
+            u[x] = cb;
+            u[x + 1] = cr;
+        }
+    }
+}
+
+} // namespace kernels
+
+ColorConverter::ColorConverter()
+    : m_kernel(kernels::convertRowPairScalar)
+    , m_kernelName("scalar")
+    , m_coeffs()
+    , m_configured(false)
+    , m_srcFormat(capture::PixelFormat::UNKNOWN)
+    , m_dstFormat(capture::PixelFormat::UNKNOWN)
+    , m_matrix(ColorMatrix::BT709)
+    , m_fullRange(false) {
+    KernelEntry widest = availableKernels().front();
+    m_kernel = widest.kernel;
+    m_kernelName = widest.name;
+}
+
+std::vector<std::string> ColorConverter::supportedKernels() {
+    std::vector<std::string> names;
+    for (const KernelEntry& entry : availableKernels()) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
+bool ColorConverter::selectKernel(const std::string& name) {
+    for (const KernelEntry& entry : availableKernels()) {
+        if (name == entry.name) {
+            m_kernel = entry.kernel;
+            m_kernelName = entry.name;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ColorConverter::configure(capture::PixelFormat srcFormat, capture::PixelFormat dstFormat,
+                               ColorMatrix matrix, bool fullRange) {
+    if (m_configured && srcFormat == m_srcFormat && dstFormat == m_dstFormat &&
+        matrix == m_matrix && fullRange == m_fullRange) {
+        return true;
+    }
+
+    bool srcSupported = srcFormat == capture::PixelFormat::BGRA8 || srcFormat == capture::PixelFormat::RGBA8;
+    bool dstSupported = dstFormat == capture::PixelFormat::YUV420P || dstFormat == capture::PixelFormat::NV12;
+    if (!srcSupported || !dstSupported) {
+        m_configured = false;
+        return false;
+    }
+
+    m_coeffs = buildCoefficients(srcFormat, matrix, fullRange);
+    m_srcFormat = srcFormat;
+    m_dstFormat = dstFormat;
+    m_matrix = matrix;
+    m_fullRange = fullRange;
+    m_configured = true;
+    return true;
+}
+
+void ColorConverter::convert(const uint8_t* src, int srcStride, int width, int height,
+                             uint8_t* const* dst, const int* dstStride) const {
+    convertRows(src, srcStride, width, height, 0, height, dst, dstStride);
+}
+
+void ColorConverter::convertRows(const uint8_t* src, int srcStride, int width, int height,
+                                 int rowBegin, int rowEnd,
+                                 uint8_t* const* dst, const int* dstStride) const {
+    convertRegion(src, srcStride, height, 0, width, rowBegin, std::min(rowEnd, height), dst, dstStride);
+}
+
+void ColorConverter::convertRect(const uint8_t* src, int srcStride, int width, int height,
+                                 const capture::Rect& rect,
+                                 uint8_t* const* dst, const int* dstStride) const {
+    // Round outwards to whole 2x2 blocks
+    int left = std::max(rect.x, 0) & ~1;
+    int top = std::max(rect.y, 0) & ~1;
+    int right = std::min((rect.x + rect.width + 1) & ~1, width);
+    int bottom = std::min((rect.y + rect.height + 1) & ~1, height);
+    if (left >= right || top >= bottom) {
+        return;
+    }
+
+    convertRegion(src, srcStride, height, left, right - left, top, bottom, dst, dstStride);
+}
+
+void ColorConverter::convertRegion(const uint8_t* src, int srcStride, int height,
+                                   int x, int regionWidth, int rowBegin, int rowEnd,
+                                   uint8_t* const* dst, const int* dstStride) const {
+    bool planar = m_dstFormat == capture::PixelFormat::YUV420P;
+    // x is even: NV12 chroma pairs start at x, planar chroma at x / 2
+    int chromaOffset = planar ? x / 2 : x;
+
+    for (int row = rowBegin; row < rowEnd; row += 2) {
+        // An odd last row pairs with itself
+        int nextRow = (row + 1 < height) ? row + 1 : row;
+        int chromaRow = row / 2;
+
+        m_kernel(m_coeffs,
+                 src + static_cast<ptrdiff_t>(row) * srcStride + x * 4,
+                 src + static_cast<ptrdiff_t>(nextRow) * srcStride + x * 4,
+                 dst[0] + static_cast<ptrdiff_t>(row) * dstStride[0] + x,
+                 dst[0] + static_cast<ptrdiff_t>(nextRow) * dstStride[0] + x,
+                 dst[1] + static_cast<ptrdiff_t>(chromaRow) * dstStride[1] + chromaOffset,
+                 planar ? dst[2] + static_cast<ptrdiff_t>(chromaRow) * dstStride[2] + chromaOffset : nullptr,
+                 regionWidth);
+    }
+}
+
+ColorMatrix parseColorMatrix(const std::string& name) {
+    if (name == "bt601") {
+        return ColorMatrix::BT601;
+    }
+    return ColorMatrix::BT709;
+}
+
+} // namespace encoder
+} // namespace talos
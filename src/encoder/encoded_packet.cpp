@@ -0,0 +1,123 @@
+#include "encoder/encoded_packet.h"
+
+namespace talos {
+namespace encoder {
+
+namespace {
+
+// Offset of the next 00 00 01 at or after pos, or size if there is none
+size_t findStartCode(const uint8_t* data, size_t size, size_t pos) {
+    while (pos + 3 <= size) {
+        if (data[pos + 2] > 1) {
+            pos += 3;
+        } else if (data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1) {
+            return pos;
+        } else {
+            pos++;
+        }
+    }
+    return size;
+}
+
+bool isSlice(uint8_t type, bool hevc) {
+    // Coded slice types: 1-5 in H.264, 0-31 in H.265
+    return hevc ? type < 32 : (type >= 1 && type <= 5);
+}
+
+} // namespace
+
+void parseAnnexB(const uint8_t* data, size_t size, bool hevc, std::vector<NalUnit>& units) {
+    units.clear();
+
+    size_t start = findStartCode(data, size, 0);
+    while (start < size) {
+        size_t payload = start + 3;
+        size_t next = findStartCode(data, size, payload);
+
+        // Zero bytes before a start code (four-byte form, trailing_zero_8bits)
+        // are not part of the unit; a NAL unit never ends in 0x00
+        size_t end = next;
+        while (end > payload && data[end - 1] == 0) {
+            end--;
+        }
+
+        if (end > payload) {
+            uint8_t header = data[payload];
+            uint8_t type = hevc ? static_cast<uint8_t>((header >> 1) & 0x3F)
+                                : static_cast<uint8_t>(header & 0x1F);
+            units.push_back({payload, end - payload, type});
+        }
+        start = next;
+    }
+}
+
+bool isNonReference(const EncodedPacket& packet, bool hevc) {
+    bool anySlice = false;
+    for (const auto& unit : packet.nalUnits) {
+        if (!isSlice(unit.type, hevc)) {
+            continue;
+        }
+        // Even VCL types below 16 are the sub-layer non-reference ones
+        bool reference = hevc ? (unit.type >= 16 || (unit.type & 1) != 0)
+                              : (packet.data[unit.offset] & 0x60) != 0;
+        if (reference) {
+            return false;
+        }
+        anySlice = true;
+    }
+    return anySlice;
+}
+
+void splitSlices(const EncodedPacketPtr& packet, bool hevc, std::vector<EncodedPacketPtr>& slices) {
+    slices.clear();
+
+    size_t sliceCount = 0;
+    for (const auto& unit : packet->nalUnits) {
+        sliceCount += isSlice(unit.type, hevc) ? 1 : 0;
+    }
+    if (sliceCount <= 1) {
+        slices.push_back(packet);
+        return;
+    }
+
+    const auto& units = packet->nalUnits;
+    size_t first = 0;
+    for (size_t i = 0; i < units.size(); ++i) {
+        // A slice closes its group, except that trailing non-VCL units
+        // after the last slice stay with it
+        bool last = i + 1 == units.size();
+        if (!isSlice(units[i].type, hevc) && !last) {
+            continue;
+        }
+        if (isSlice(units[i].type, hevc) && !last && slices.size() + 1 == sliceCount) {
+            continue;
+        }
+
+        // Start at the three-byte start code in front of the first unit
+        size_t begin = units[first].offset - 3;
+        size_t end = units[i].offset + units[i].size;
+
+        auto slice = std::make_shared<EncodedPacket>();
+        slice->data = packet->data + begin;
+        slice->size = end - begin;
+        slice->pts = packet->pts;
+        slice->dts = packet->dts;
+        slice->timeBaseNum = packet->timeBaseNum;
+        slice->timeBaseDen = packet->timeBaseDen;
+        slice->keyframe = packet->keyframe && slices.empty();
+        slice->disposable = packet->disposable;
+        slice->endOfFrame = packet->endOfFrame && last;
+        slice->captureTimestamp = packet->captureTimestamp;
+        slice->streamId = packet->streamId;
+        slice->avPacket = packet->avPacket;
+        for (size_t j = first; j <= i; ++j) {
+            slice->nalUnits.push_back({units[j].offset - begin, units[j].size, units[j].type});
+        }
+
+        slices.push_back(std::move(slice));
+        first = i + 1;
+    }
+}
+
+} // namespace encoder
+} // namespace talos
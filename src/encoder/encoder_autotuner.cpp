@@ -0,0 +1,307 @@
+#include "encoder/encoder_autotuner.h"
+#include "encoder/ffmpeg_encoder.h"
+#include "encoder/synthetic_clip.h"
+#include "capture/capture_engine.h"
+#include "core/logger.h"
+#include "core/quality_controller.h"
+#include "core/thread_pool.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace talos {
+namespace encoder {
+
+namespace {
+
+constexpr int kCacheVersion = 2;
+
+// Default quality target when the configuration uses a bitrate
+constexpr int kDefaultCrf = 23;
+
+} // namespace
+
+EncoderAutotuner::EncoderAutotuner(const AutotuneOptions& options)
+    : m_options(options) {
+}
+
+bool EncoderAutotuner::tune(EncoderConfig& config, bool force) {
+    AutotuneResult best;
+    if (!force && loadCache(config, best)) {
+        Logger::getInstance().log(LogLevel::Info,
+            "Using cached encoder tuning: " + best.encoderName + " preset " + best.preset +
+            " threads " + std::to_string(best.threadCount));
+    } else {
+        std::vector<AutotuneResult> results;
+        if (!benchmark(config, results) || !selectBest(results, best)) {
+            Logger::getInstance().log(LogLevel::Error, "Encoder autotuning found no usable encoder");
+            return false;
+        }
+        saveCache(config, best);
+    }
+
+    config.encoderName = best.encoderName;
+    config.preset = best.preset;
+    config.threadCount = best.threadCount;
+    return true;
+}
+
+bool EncoderAutotuner::benchmark(const EncoderConfig& config, std::vector<AutotuneResult>& results) {
+    results.clear();
+
+    EncoderConfig base = config;
+    base.useHardwareAccel = false;   // Only the named encoder, no silent fallback
+    base.variableFrameRate = false;  // Measure throughput, not skipping
+    if (base.crf < 0) {
+        base.crf = kDefaultCrf;
+    }
+
+    float targetFps = config.framerate * m_options.fpsHeadroom;
+    Logger::getInstance().log(LogLevel::Info,
+        "Benchmarking encoders at " + std::to_string(config.width) + "x" + std::to_string(config.height) +
+        ", target " + std::to_string(static_cast<int>(targetFps)) + " fps");
+
+    // Hardware encoders have their own presets; measure them as configured
+    if (m_options.includeHardware) {
+        for (const auto& name : FFmpegEncoder::candidateEncoders(config.codec, true)) {
+            EncoderConfig candidate = base;
+            candidate.encoderName = name;
+            candidate.threadCount = 0;
+
+            AutotuneResult result;
+            if (measure(candidate, result)) {
+                result.hardware = true;
+                results.push_back(result);
+            }
+        }
+    }
+
+    for (const auto& name : FFmpegEncoder::candidateEncoders(config.codec, false)) {
+        for (int threads : threadCounts()) {
+            for (const auto& preset : m_options.presets) {
+                EncoderConfig candidate = base;
+                candidate.encoderName = name;
+                candidate.preset = preset;
+                candidate.threadCount = threads;
+
+                AutotuneResult result;
+                if (!measure(candidate, result)) {
+                    break;
+                }
+                results.push_back(result);
+
+                // Presets are ordered fastest first: slower ones will miss too
+                if (!result.meetsTarget) {
+                    break;
+                }
+            }
+        }
+    }
+
+    return !results.empty();
+}
+
+bool EncoderAutotuner::selectBest(const std::vector<AutotuneResult>& results, AutotuneResult& best) const {
+    if (results.empty()) {
+        return false;
+    }
+
+    const AutotuneResult* software = selectInClass(results, false);
+    const AutotuneResult* hardware = selectInClass(results, true);
+
+    if (!software && !hardware) {
+        best = *std::max_element(results.begin(), results.end(),
+            [](const AutotuneResult& a, const AutotuneResult& b) { return a.fps < b.fps; });
+        Logger::getInstance().log(LogLevel::Warning,
+            "No encoder reaches the frame rate target; using the fastest (" + best.encoderName + " " +
+            best.preset + ", " + std::to_string(static_cast<int>(best.fps)) + " fps)");
+        return true;
+    }
+
+    // Bitrates of the two classes are not comparable; CPU is
+    if (software && hardware) {
+        best = hardware->cpuPercent <= software->cpuPercent ? *hardware : *software;
+    } else {
+        best = software ? *software : *hardware;
+    }
+
+    Logger::getInstance().log(LogLevel::Info,
+        "Selected encoder " + best.encoderName + " preset " + best.preset + " threads " +
+        std::to_string(best.threadCount) + ": " + std::to_string(static_cast<int>(best.fps)) + " fps, " +
+        std::to_string(static_cast<int>(best.cpuPercent)) + "% CPU, " +
+        std::to_string(static_cast<int>(best.bitrate / 1000)) + " kbps");
+    return true;
+}
+
+const AutotuneResult* EncoderAutotuner::selectInClass(const std::vector<AutotuneResult>& results,
+                                                     bool hardware) const {
+    float smallestBitrate = -1.0f;
+    for (const auto& result : results) {
+        if (result.hardware == hardware && result.meetsTarget &&
+            (smallestBitrate < 0.0f || result.bitrate < smallestBitrate)) {
+            smallestBitrate = result.bitrate;
+        }
+    }
+
+    // Equally efficient within the tolerance: the cheapest on CPU wins
+    const AutotuneResult* chosen = nullptr;
+    for (const auto& result : results) {
+        if (result.hardware != hardware || !result.meetsTarget ||
+            result.bitrate > smallestBitrate * (1.0f + m_options.bitrateTolerance)) {
+            continue;
+        }
+        if (!chosen || result.cpuPercent < chosen->cpuPercent) {
+            chosen = &result;
+        }
+    }
+    return chosen;
+}
+
+bool EncoderAutotuner::measure(const EncoderConfig& config, AutotuneResult& result) {
+    FFmpegEncoder encoder;
+    if (!encoder.initialize(config)) {
+        return false;
+    }
+    if (encoder.getStats().encoderName != config.encoderName) {
+        encoder.shutdown();
+        return false;
+    }
+
+    SyntheticClip clip(config.width, config.height, config.framerate);
+    capture::Frame frame;
+    EncodedPacketPtr packet;
+    uint64_t bytes = 0;
+    int frames = std::max(m_options.clipFrames, 1);
+
+    double cpuStart = QualitySampler::processCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+
+    bool ok = true;
+    for (int i = 0; i < frames && ok; ++i) {
+        clip.render(i, frame);
+        ok = encoder.encodeFrame(frame);
+        while (encoder.getEncodedPacket(packet)) {
+            bytes += packet->size;
+        }
+    }
+
+    // Frames held for lookahead count towards the run
+    encoder.shutdown();
+    while (encoder.getEncodedPacket(packet)) {
+        bytes += packet->size;
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpuSeconds = QualitySampler::processCpuSeconds() - cpuStart;
+    if (!ok || wallSeconds <= 0.0) {
+        return false;
+    }
+
+    result.encoderName = config.encoderName;
+    result.preset = config.preset;
+    result.threadCount = config.threadCount;
+    result.fps = static_cast<float>(frames / wallSeconds);
+    result.cpuPercent = static_cast<float>(
+        100.0 * cpuSeconds / (wallSeconds * static_cast<double>(ThreadPool::hardwareConcurrency())));
+    result.bitrate = static_cast<float>(bytes * 8) * config.framerate / frames;
+    result.meetsTarget = result.fps >= config.framerate * m_options.fpsHeadroom;
+
+    Logger::getInstance().log(LogLevel::Info,
+        "  " + result.encoderName + " " + result.preset + " threads " + std::to_string(result.threadCount) +
+        ": " + std::to_string(static_cast<int>(result.fps)) + " fps, " +
+        std::to_string(static_cast<int>(result.cpuPercent)) + "% CPU, " +
+        std::to_string(static_cast<int>(result.bitrate / 1000)) + " kbps");
+    return true;
+}
+
+std::string EncoderAutotuner::cacheKey(const EncoderConfig& config) const {
+    // A different machine or workload gets its own entry
+    return config.codec + "/" + std::to_string(config.width) + "x" + std::to_string(config.height) +
+           "@" + std::to_string(config.framerate) + "/crf" + std::to_string(config.crf < 0 ? kDefaultCrf : config.crf) +
+           "/cores" + std::to_string(ThreadPool::hardwareConcurrency()) +
+           (m_options.includeHardware ? "/hw" : "/sw");
+}
+
+bool EncoderAutotuner::loadCache(const EncoderConfig& config, AutotuneResult& result) const {
+    std::ifstream file(m_options.cachePath);
+    if (!file) {
+        return false;
+    }
+
+    try {
+        nlohmann::json cache = nlohmann::json::parse(file);
+        if (cache.value("version", 0) != kCacheVersion) {
+            return false;
+        }
+
+        const auto& entries = cache.at("entries");
+        auto entry = entries.find(cacheKey(config));
+        if (entry == entries.end()) {
+            return false;
+        }
+
+        result.encoderName = entry->at("encoder").get<std::string>();
+        result.preset = entry->at("preset").get<std::string>();
+        result.threadCount = entry->at("threadCount").get<int>();
+        result.fps = entry->value("fps", 0.0f);
+        result.cpuPercent = entry->value("cpuPercent", 0.0f);
+        result.bitrate = entry->value("bitrate", 0.0f);
+        result.meetsTarget = entry->value("meetsTarget", false);
+        result.hardware = entry->value("hardware", false);
+        return true;
+    } catch (const nlohmann::json::exception& e) {
+        Logger::getInstance().log(LogLevel::Warning,
+            "Ignoring unreadable encoder tuning cache " + m_options.cachePath + ": " + e.what());
+        return false;
+    }
+}
+
+void EncoderAutotuner::saveCache(const EncoderConfig& config, const AutotuneResult& result) const {
+    // Keep the entries for other configurations
+    nlohmann::json cache;
+    {
+        std::ifstream file(m_options.cachePath);
+        if (file) {
+            cache = nlohmann::json::parse(file, nullptr, false);
+        }
+    }
+    if (cache.is_discarded() || !cache.is_object() || cache.value("version", 0) != kCacheVersion) {
+        cache = nlohmann::json::object();
+    }
+    cache["version"] = kCacheVersion;
+
+    cache["entries"][cacheKey(config)] = {
+        {"encoder", result.encoderName},
+        {"preset", result.preset},
+        {"threadCount", result.threadCount},
+        {"fps", result.fps},
+        {"cpuPercent", result.cpuPercent},
+        {"bitrate", result.bitrate},
+        {"meetsTarget", result.meetsTarget},
+        {"hardware", result.hardware}
+    };
+
+    std::ofstream file(m_options.cachePath);
+    if (!file) {
+        Logger::getInstance().log(LogLevel::Warning, "Cannot write encoder tuning cache " + m_options.cachePath);
+        return;
+    }
+    file << cache.dump(2) << "\n";
+}
+
+std::vector<int> EncoderAutotuner::threadCounts() const {
+    if (!m_options.threadCounts.empty()) {
+        return m_options.threadCounts;
+    }
+
+    int cores = static_cast<int>(ThreadPool::hardwareConcurrency());
+    std::vector<int> counts = {1, cores / 2, cores};
+    counts.erase(std::remove_if(counts.begin(), counts.end(), [](int n) { return n < 1; }), counts.end());
+    std::sort(counts.begin(), counts.end());
+    counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+    return counts;
+}
+
+} // namespace encoder
+} // namespace talos
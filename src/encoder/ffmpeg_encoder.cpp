@@ -11,23 +11,87 @@ extern "C" {
 #include <libavutil/imgutils.h>
 #include <libswscale/swscale.h>
 #include <libavutil/pixfmt.h>
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
 }
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <sstream>
 
 namespace talos {
 namespace encoder {
 
+namespace {
+
+// Smaller bands cost more in wake-ups than they gain in parallelism
+constexpr int kMinBandRows = 64;
+
+// Weight of the newest sample in the smoothed conversion timings
+constexpr float kTimingSmoothing = 0.1f;
+
+// Frames a codec can plausibly hold back (lookahead, B-frames, threads)
+constexpr size_t kMaxPendingTimestamps = 256;
+
+// Row alignment of pooled pictures, enough for any SIMD path in the codecs
+constexpr int kPictureAlign = 64;
+
+// Changed areas sent as individual regions; beyond this their bounding box is used
+constexpr size_t kMaxChangedRegions = 32;
+
+// Changed areas of dropped frames remembered for the next frame's regions of
+// interest; beyond this the whole frame counts as changed
+constexpr size_t kMaxSkippedRects = 64;
+
+float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Reference to a converted picture, shared with the codec
+ */
+struct FFmpegPreparedFrame : PreparedFrame {
+    ~FFmpegPreparedFrame() override {
+        av_frame_free(&frame);
+    }
+    
+    AVFrame* frame = nullptr;
+    uint64_t generation = 0;    // Codec instance it was prepared for
+};
+
+} // namespace
+
 FFmpegEncoder::FFmpegEncoder()
     : m_codecContext(nullptr)
     , m_codec(nullptr)
     , m_swsContext(nullptr)
+    , m_scalerSrcWidth(0)
+    , m_scalerSrcHeight(0)
+    , m_scalerSrcFormat(-1)
+    , m_conversionBands(1)
+    , m_yuvValid(false)
+    , m_yuvSourceFormat(capture::PixelFormat::UNKNOWN)
+    , m_yuvSequence(0)
     , m_frame(nullptr)
+    , m_picturePool(nullptr)
     , m_packet(nullptr)
+    , m_codecGeneration(0)
+    , m_keyframeInterval(0)
+    , m_framesSinceKeyframe(0)
+    , m_keyframeRequested(false)
     , m_initialized(false)
+    , m_rateWindowBytes(0)
     , m_frameNumber(0)
-    , m_pts(0) {
+    , m_pts(0)
+    , m_hasEncoded(false)
+    , m_firstTimestamp(0)
+    , m_lastEncodedTimestamp(0)
+    , m_nextDueTimestamp(0)
+    , m_skippedChanges(false)
+    , m_hasPicture(false)
+    , m_lastSequence(0) {
 }
 
 FFmpegEncoder::~FFmpegEncoder() {
@@ -41,6 +105,12 @@ bool FFmpegEncoder::initialize(const EncoderConfig& config) {
     }
     
     m_config = config;
+    m_pts = 0;
+    m_hasEncoded = false;
+    m_skippedChanges = false;
+    m_skippedRects.clear();
+    m_rateWindowStart = std::chrono::steady_clock::now();
+    m_rateWindowBytes = 0;
     
     // Initialize FFmpeg
 #if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 9, 100)
@@ -55,19 +125,7 @@ bool FFmpegEncoder::initialize(const EncoderConfig& config) {
     }
     
     // Allocate frame and packet
-    m_frame = av_frame_alloc();
-    if (!m_frame) {
-        Logger::getInstance().log(LogLevel::Error, "Failed to allocate frame");
-        cleanupFFmpeg();
-        return false;
-    }
-    
-    m_frame->format = m_codecContext->pix_fmt;
-    m_frame->width = m_codecContext->width;
-    m_frame->height = m_codecContext->height;
-    
-    int ret = av_frame_get_buffer(m_frame, 0);
-    if (ret < 0) {
+    if (!initializePicture()) {
         Logger::getInstance().log(LogLevel::Error, "Failed to allocate frame buffer");
         cleanupFFmpeg();
         return false;
@@ -80,13 +138,19 @@ bool FFmpegEncoder::initialize(const EncoderConfig& config) {
         return false;
     }
     
+    initializeConversion(config);
+    
     // Initialize scaler for BGRA to YUV420P conversion
     if (!initializeScaler(config.width, config.height, AV_PIX_FMT_BGRA)) {
         Logger::getInstance().log(LogLevel::Error, "Failed to initialize scaler");
         cleanupFFmpeg();
         return false;
     }
+    Logger::getInstance().log(LogLevel::Info,
+        "Color conversion kernel: " + std::string(m_colorConverter.kernelName()));
     
+    m_keyframeInterval = 0;
+    m_framesSinceKeyframe = 0;
     m_initialized = true;
     Logger::getInstance().log(LogLevel::Info, "FFmpeg encoder initialized successfully");
     
@@ -102,29 +166,20 @@ bool FFmpegEncoder::initializeCodec(const EncoderConfig& config) {
         codecId = AV_CODEC_ID_AV1;
     }
     
-    // Try hardware accelerated encoder first if requested
-    if (config.useHardwareAccel) {
-        std::vector<std::string> hwEncoders;
-        
-        if (codecId == AV_CODEC_ID_H264) {
-            #ifdef _WIN32
-            hwEncoders = {"h264_nvenc", "h264_qsv", "h264_amf"};
-            #elif defined(__APPLE__)
-            hwEncoders = {"h264_videotoolbox"};
-            #else
-            hwEncoders = {"h264_nvenc", "h264_vaapi"};
-            #endif
-        } else if (codecId == AV_CODEC_ID_H265) {
-            #ifdef _WIN32
-            hwEncoders = {"hevc_nvenc", "hevc_qsv", "hevc_amf"};
-            #elif defined(__APPLE__)
-            hwEncoders = {"hevc_videotoolbox"};
-            #else
-            hwEncoders = {"hevc_nvenc", "hevc_vaapi"};
-            #endif
+    // An explicitly configured encoder (e.g. from the autotuner) comes first
+    m_codec = nullptr;
+    if (!config.encoderName.empty()) {
+        m_codec = avcodec_find_encoder_by_name(config.encoderName.c_str());
+        if (m_codec) {
+            Logger::getInstance().log(LogLevel::Info, "Using configured encoder: " + config.encoderName);
+        } else {
+            Logger::getInstance().log(LogLevel::Warning, "Encoder not available: " + config.encoderName);
         }
-        
-        for (const auto& encoderName : hwEncoders) {
+    }
+    
+    // Try hardware accelerated encoder first if requested
+    if (!m_codec && config.useHardwareAccel) {
+        for (const auto& encoderName : candidateEncoders(config.codec, true)) {
             m_codec = avcodec_find_encoder_by_name(encoderName.c_str());
             if (m_codec) {
                 Logger::getInstance().log(LogLevel::Info, "Using hardware encoder: " + encoderName);
@@ -143,6 +198,11 @@ bool FFmpegEncoder::initializeCodec(const EncoderConfig& config) {
         Logger::getInstance().log(LogLevel::Info, "Using software encoder: " + std::string(m_codec->name));
     }
     
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.encoderName = m_codec->name;
+    }
+    
     // Allocate codec context
     m_codecContext = avcodec_alloc_context3(m_codec);
     if (!m_codecContext) {
@@ -153,22 +213,42 @@ bool FFmpegEncoder::initializeCodec(const EncoderConfig& config) {
     // Set codec parameters
     m_codecContext->width = config.width;
     m_codecContext->height = config.height;
-    m_codecContext->time_base = {1, config.framerate};
+    // VFR timestamps are capture times in microseconds
+    m_codecContext->time_base = config.variableFrameRate
+        ? AVRational{1, 1000000} : AVRational{1, config.framerate};
     m_codecContext->framerate = {config.framerate, 1};
     m_codecContext->gop_size = config.gopSize;
-    m_codecContext->max_b_frames = 2;
+    m_codecContext->max_b_frames = config.lowLatency ? 0 : 2;
     m_codecContext->pix_fmt = AV_PIX_FMT_YUV420P;
     
-    // Set bitrate or CRF
-    if (config.crf >= 0) {
-        av_opt_set_int(m_codecContext->priv_data, "crf", config.crf, 0);
+    // Signal the colorimetry the converter produces
+    if (parseColorMatrix(config.colorMatrix) == ColorMatrix::BT601) {
+        m_codecContext->colorspace = AVCOL_SPC_SMPTE170M;
+        m_codecContext->color_primaries = AVCOL_PRI_SMPTE170M;
+        m_codecContext->color_trc = AVCOL_TRC_SMPTE170M;
     } else {
-        m_codecContext->bit_rate = config.bitrate;
+        m_codecContext->colorspace = AVCOL_SPC_BT709;
+        m_codecContext->color_primaries = AVCOL_PRI_BT709;
+        m_codecContext->color_trc = AVCOL_TRC_BT709;
     }
+    m_codecContext->color_range = config.fullRange ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+    
+    // Set bitrate or CRF
+    applyRateControl(config);
+    
+    // Forced keyframes (reconfigure, keyframe requests) must be IDR frames
+    av_opt_set_int(m_codecContext->priv_data, "forced-idr", 1, 0);
     
     // Set preset
     av_opt_set(m_codecContext->priv_data, "preset", config.preset.c_str(), 0);
     
+    if (!config.sceneCut) {
+        // Option names differ per encoder; unknown ones are ignored
+        av_opt_set_int(m_codecContext->priv_data, "sc_threshold", 0, 0);     // libx264
+        av_opt_set_int(m_codecContext->priv_data, "no-scenecut", 1, 0);      // NVENC
+        av_opt_set(m_codecContext->priv_data, "x265-params", "scenecut=0", 0); // libx265
+    }
+    
     // Set profile
     if (config.profile == "baseline") {
         m_codecContext->profile = FF_PROFILE_H264_BASELINE;
@@ -183,6 +263,10 @@ bool FFmpegEncoder::initializeCodec(const EncoderConfig& config) {
         m_codecContext->thread_count = config.threadCount;
     }
     
+    if (config.lowLatency) {
+        applyLowLatency(config);
+    }
+    
     // Open codec
     int ret = avcodec_open2(m_codecContext, m_codec, nullptr);
     if (ret < 0) {
@@ -195,8 +279,165 @@ bool FFmpegEncoder::initializeCodec(const EncoderConfig& config) {
     return true;
 }
 
+std::vector<std::string> FFmpegEncoder::candidateEncoders(const std::string& codec, bool hardware) {
+    if (!hardware) {
+        if (codec == "h265") {
+            return {"libx265"};
+        } else if (codec == "av1") {
+            return {"libsvtav1", "libaom-av1"};
+        }
+        return {"libx264"};
+    }
+    
+    if (codec == "h265") {
+        #ifdef _WIN32
+        return {"hevc_nvenc", "hevc_qsv", "hevc_amf"};
+        #elif defined(__APPLE__)
+        return {"hevc_videotoolbox"};
+        #else
+        return {"hevc_nvenc", "hevc_vaapi"};
+        #endif
+    } else if (codec == "h264") {
+        #ifdef _WIN32
+        return {"h264_nvenc", "h264_qsv", "h264_amf"};
+        #elif defined(__APPLE__)
+        return {"h264_videotoolbox"};
+        #else
+        return {"h264_nvenc", "h264_vaapi"};
+        #endif
+    }
+    return {};
+}
+
+void FFmpegEncoder::applyRateControl(const EncoderConfig& config) {
+    if (config.crf >= 0) {
+        // Hardware encoders have no CRF; their constant-quality modes take
+        // the value as a QP, or on a 0-100 scale for VideoToolbox
+        std::string name = m_codec->name;
+        void* options = m_codecContext->priv_data;
+        if (name.find("nvenc") != std::string::npos) {
+            av_opt_set(options, "rc", "vbr", 0);
+            av_opt_set_int(options, "cq", config.crf, 0);
+            m_codecContext->bit_rate = 0;
+        } else if (name.find("vaapi") != std::string::npos) {
+            av_opt_set(options, "rc_mode", "CQP", 0);
+            m_codecContext->global_quality = config.crf;
+        } else if (name.find("qsv") != std::string::npos) {
+            m_codecContext->global_quality = config.crf;  // ICQ
+        } else if (name.find("amf") != std::string::npos) {
+            av_opt_set(options, "rc", "cqp", 0);
+            av_opt_set_int(options, "qp_i", config.crf, 0);
+            av_opt_set_int(options, "qp_p", config.crf, 0);
+            av_opt_set_int(options, "qp_b", config.crf, 0);
+        } else if (name.find("videotoolbox") != std::string::npos) {
+            m_codecContext->flags |= AV_CODEC_FLAG_QSCALE;
+            m_codecContext->global_quality = FF_QP2LAMBDA * std::max(1, 100 - config.crf * 100 / 51);
+        } else {
+            av_opt_set_int(options, "crf", config.crf, 0);
+        }
+    } else {
+        m_codecContext->bit_rate = config.bitrate;
+    }
+    
+    // libx264 and NVENC can only change the bitrate of a running encoder
+    // when VBV is on. Low-latency mode uses one frame of buffer, so every
+    // frame, keyframes included, stays near the average size.
+    if (config.crf < 0 || config.lowLatency) {
+        m_codecContext->rc_max_rate = config.bitrate;
+        m_codecContext->rc_buffer_size = config.lowLatency
+            ? config.bitrate / std::max(config.framerate, 1) : config.bitrate;
+    }
+}
+
+void FFmpegEncoder::applyLowLatency(const EncoderConfig& config) {
+    // Frame threading delays output by one frame per thread; slices do not
+    m_codecContext->thread_type = FF_THREAD_SLICE;
+    m_codecContext->slices = std::max(config.sliceCount, 1);
+    
+    // Private options differ per encoder; unknown ones are ignored
+    std::string name = m_codec->name;
+    void* options = m_codecContext->priv_data;
+    if (name == "libx264" || name == "libx265") {
+        av_opt_set(options, "tune", "zerolatency", 0);
+        if (config.intraRefresh && name == "libx264") {
+            // Refresh frames carry a recovery point and still count as keyframes
+            av_opt_set_int(options, "intra-refresh", 1, 0);
+        }
+    } else if (name.find("nvenc") != std::string::npos) {
+        av_opt_set(options, "tune", "ull", 0);
+        av_opt_set_int(options, "zerolatency", 1, 0);
+        av_opt_set_int(options, "delay", 0, 0);
+        av_opt_set_int(options, "intra-refresh", config.intraRefresh ? 1 : 0, 0);
+    } else if (name.find("qsv") != std::string::npos) {
+        av_opt_set_int(options, "low_delay_brc", 1, 0);
+        av_opt_set_int(options, "async_depth", 1, 0);
+    } else if (name.find("videotoolbox") != std::string::npos) {
+        av_opt_set_int(options, "realtime", 1, 0);
+    }
+    
+    Logger::getInstance().log(LogLevel::Info,
+        "Low-latency mode: " + std::to_string(m_codecContext->slices) + " slices, intra refresh " +
+        (config.intraRefresh ? "on" : "off"));
+}
+
+bool FFmpegEncoder::initializePicture() {
+    m_frame = av_frame_alloc();
+    if (!m_frame) {
+        return false;
+    }
+    
+    m_frame->format = m_codecContext->pix_fmt;
+    m_frame->width = m_codecContext->width;
+    m_frame->height = m_codecContext->height;
+    
+    // Pictures are recycled from a pool: the codec may still reference the
+    // previous one when the next frame is converted
+    int pictureSize = av_image_get_buffer_size(m_codecContext->pix_fmt, m_frame->width,
+                                               m_frame->height, kPictureAlign);
+    if (pictureSize > 0) {
+        m_picturePool = av_buffer_pool_init(pictureSize + AV_INPUT_BUFFER_PADDING_SIZE, nullptr);
+    }
+    return m_picturePool && allocatePicture(m_frame);
+}
+
+void FFmpegEncoder::releasePicture() {
+    m_yuvValid = false;
+    m_hasPicture = false;
+    
+    if (m_frame) {
+        av_frame_free(&m_frame);
+        m_frame = nullptr;
+    }
+    
+    // Buffers still referenced elsewhere keep the pool alive until released
+    if (m_picturePool) {
+        av_buffer_pool_uninit(&m_picturePool);
+    }
+}
+
+void FFmpegEncoder::initializeConversion(const EncoderConfig& config) {
+    // Split same-size conversion into bands of at least kMinBandRows rows
+    size_t bands = config.conversionBands > 0
+        ? static_cast<size_t>(config.conversionBands) : ThreadPool::hardwareConcurrency();
+    bands = std::max<size_t>(1, std::min<size_t>(bands, config.height / kMinBandRows));
+    if (m_conversionPool && bands == m_conversionBands) {
+        return;
+    }
+    
+    m_conversionPool.reset();
+    m_conversionBands = bands;
+    m_bandMs.assign(bands, 0.0f);
+    if (bands > 1) {
+        m_conversionPool = std::make_unique<ThreadPool>(bands - 1);
+    }
+    Logger::getInstance().log(LogLevel::Info,
+        "Color conversion bands: " + std::to_string(bands));
+}
+
 bool FFmpegEncoder::initializeScaler(int srcWidth, int srcHeight, int srcFormat) {
-    m_swsContext = sws_getContext(
+    // Reuses the context when nothing changed
+    m_swsContext = sws_getCachedContext(
+        m_swsContext,
         srcWidth, srcHeight, static_cast<AVPixelFormat>(srcFormat),
         m_codecContext->width, m_codecContext->height, m_codecContext->pix_fmt,
         SWS_BILINEAR, nullptr, nullptr, nullptr
@@ -206,15 +447,180 @@ bool FFmpegEncoder::initializeScaler(int srcWidth, int srcHeight, int srcFormat)
         Logger::getInstance().log(LogLevel::Error, "Failed to create scaler context");
         return false;
     }
+    m_scalerSrcWidth = srcWidth;
+    m_scalerSrcHeight = srcHeight;
+    m_scalerSrcFormat = srcFormat;
+    
+    // Match the colorimetry of the SIMD converter so both paths agree
+    int colorspace = parseColorMatrix(m_config.colorMatrix) == ColorMatrix::BT601 ? SWS_CS_ITU601 : SWS_CS_ITU709;
+    sws_setColorspaceDetails(m_swsContext,
+                             sws_getCoefficients(colorspace), 1,
+                             sws_getCoefficients(colorspace), m_config.fullRange ? 1 : 0,
+                             0, 1 << 16, 1 << 16);
     
     return true;
 }
 
+ReconfigureResult FFmpegEncoder::reconfigure(const EncoderConfig& config) {
+    ReconfigureResult result;
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return result;
+    }
+    
+    // These change what consumers negotiated, not just the picture
+    if (config.codec != m_config.codec || config.variableFrameRate != m_config.variableFrameRate) {
+        Logger::getInstance().log(LogLevel::Error,
+            "Codec and frame rate mode cannot change on a running encoder; reinitialize instead");
+        return result;
+    }
+    
+    // Run between frames: both halves of the encoder are paused
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+    
+    EncoderConfig previous = m_config;
+    bool sizeChanged = config.width != previous.width || config.height != previous.height;
+    bool colorChanged = config.colorMatrix != previous.colorMatrix || config.fullRange != previous.fullRange;
+    
+    if (needsCodecRebuild(config)) {
+        // Carry the last PTS over to the new time base so timestamps keep
+        // increasing, but only once the new codec is actually in place
+        int64_t pts = m_pts;
+        if (!config.variableFrameRate && config.framerate != previous.framerate) {
+            pts = (m_pts * config.framerate + previous.framerate - 1) / previous.framerate;
+        }
+        
+        if (!rebuildCodec(config)) {
+            Logger::getInstance().log(LogLevel::Error, "Reconfiguration failed, restoring previous settings");
+            if (!rebuildCodec(previous)) {
+                Logger::getInstance().log(LogLevel::Error, "Failed to restore encoder");
+                m_initialized = false;
+            }
+            return result;
+        }
+        m_pts = pts;
+        result.codecRebuilt = true;
+        result.keyframeForced = true;
+        m_codecGeneration++;
+        m_keyframeInterval = 0;
+        m_framesSinceKeyframe = 0;
+        
+        // The new codec starts with an IDR, which answers pending requests
+        m_keyframeRequested.store(false, std::memory_order_relaxed);
+        m_lastRequestedKeyframe = std::chrono::steady_clock::now();
+    } else {
+        if (config.bitrate != previous.bitrate || config.crf != previous.crf) {
+            // Picked up by the codec wrapper with the next frame
+            applyRateControl(config);
+        }
+        
+        // The codec cannot shorten its own GOP, so force the extra keyframes
+        m_keyframeInterval = config.gopSize < m_codecContext->gop_size ? config.gopSize : 0;
+    }
+    
+    m_config = config;
+    
+    if (sizeChanged) {
+        releasePicture();
+        if (!initializePicture()) {
+            Logger::getInstance().log(LogLevel::Error, "Failed to allocate frame buffer");
+            m_initialized = false;
+            return result;
+        }
+    }
+    
+    // Rebuilt for the next frame that needs it, with the new output and colorimetry
+    if (sizeChanged || colorChanged) {
+        if (m_swsContext) {
+            sws_freeContext(m_swsContext);
+            m_swsContext = nullptr;
+        }
+        m_yuvValid = false;
+    }
+    
+    if (sizeChanged || config.conversionBands != previous.conversionBands) {
+        initializeConversion(config);
+    }
+    
+    result.success = true;
+    Logger::getInstance().log(LogLevel::Info,
+        std::string("Encoder reconfigured: ") + std::to_string(config.width) + "x" + std::to_string(config.height) +
+        " " + std::to_string(config.framerate) + "fps " + std::to_string(config.bitrate / 1000) + "kbps gop " +
+        std::to_string(config.gopSize) + (result.codecRebuilt ? " (codec rebuilt)" : " (in place)"));
+    return result;
+}
+
+bool FFmpegEncoder::needsCodecRebuild(const EncoderConfig& config) const {
+    const EncoderConfig& current = m_config;
+    
+    // Fixed in the parameter sets or when the codec is opened
+    if (config.width != current.width || config.height != current.height ||
+        (!config.variableFrameRate && config.framerate != current.framerate) ||
+        config.encoderName != current.encoderName ||
+        config.preset != current.preset || config.profile != current.profile ||
+        config.useHardwareAccel != current.useHardwareAccel || config.threadCount != current.threadCount ||
+        config.lowLatency != current.lowLatency || config.sliceCount != current.sliceCount ||
+        config.intraRefresh != current.intraRefresh || config.sceneCut != current.sceneCut ||
+        config.colorMatrix != current.colorMatrix || config.fullRange != current.fullRange) {
+        return true;
+    }
+    
+    // Switching between CRF and bitrate targets changes the rate control method
+    if ((config.crf >= 0) != (current.crf >= 0)) {
+        return true;
+    }
+    bool rateChanged = config.bitrate != current.bitrate || config.crf != current.crf;
+    if (rateChanged && !supportsRateReconfig(config)) {
+        return true;
+    }
+    
+    // Extra keyframes can shorten the GOP but not lengthen it, and they
+    // would cut an intra refresh sweep short
+    if (config.gopSize != current.gopSize &&
+        (config.gopSize > m_codecContext->gop_size || (config.lowLatency && config.intraRefresh))) {
+        return true;
+    }
+    return false;
+}
+
+bool FFmpegEncoder::supportsRateReconfig(const EncoderConfig& config) const {
+    // libavcodec passes rate changes on to these wrappers at the next frame
+    std::string name = m_codec->name;
+    if (name == "libx264") {
+        return true;
+    }
+    if (name.find("nvenc") != std::string::npos) {
+        return config.crf < 0 && config.crf == m_config.crf;
+    }
+    return false;
+}
+
+bool FFmpegEncoder::rebuildCodec(const EncoderConfig& config) {
+    // Drain the frames the old codec still holds into the packet queue
+    if (m_codecContext) {
+        encodeAVFrame(nullptr);
+        avcodec_free_context(&m_codecContext);
+    }
+    m_pendingTimestamps.clear();
+    
+    if (!initializeCodec(config)) {
+        if (m_codecContext) {
+            avcodec_free_context(&m_codecContext);
+        }
+        return false;
+    }
+    return true;
+}
+
 void FFmpegEncoder::shutdown() {
     if (!m_initialized) {
         return;
     }
     
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+    
     // Flush encoder
     if (m_codecContext) {
         encodeAVFrame(nullptr);
@@ -232,10 +638,9 @@ void FFmpegEncoder::cleanupFFmpeg() {
         m_swsContext = nullptr;
     }
     
-    if (m_frame) {
-        av_frame_free(&m_frame);
-        m_frame = nullptr;
-    }
+    m_conversionPool.reset();
+    m_pendingTimestamps.clear();
+    releasePicture();
     
     if (m_packet) {
         av_packet_free(&m_packet);
@@ -249,14 +654,98 @@ void FFmpegEncoder::cleanupFFmpeg() {
 }
 
 bool FFmpegEncoder::encodeFrame(const capture::Frame& frame) {
+    PreparedFramePtr prepared;
+    if (!prepareFrame(frame, prepared)) {
+        return false;
+    }
+    return !prepared || encodePreparedFrame(prepared);
+}
+
+bool FFmpegEncoder::prepareFrame(const capture::Frame& frame, PreparedFramePtr& prepared) {
+    prepared.reset();
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    
     if (!m_initialized) {
         Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
         return false;
     }
     
-    // Make frame writable
-    int ret = av_frame_make_writable(m_frame);
-    if (ret < 0) {
+    // Dirty regions only describe this frame if the previous capture was seen
+    bool contiguous = frame.sequence == m_lastSequence + 1;
+    
+    if (shouldSkipFrame(frame)) {
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.framesSkipped++;
+        }
+        
+        // Dropped above framerate, but its changes must still reach the
+        // picture: the next frame or prepareKeepAlive() sends them
+        if (contiguous && frame.identical) {
+            return true;
+        }
+        return convertPicture(frame);
+    }
+    
+    if (!convertPicture(frame)) {
+        return false;
+    }
+    return finishPrepare(frame, contiguous, prepared);
+}
+
+bool FFmpegEncoder::prepareKeepAlive(uint64_t timestamp, PreparedFramePtr& prepared) {
+    prepared.reset();
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+    if (!m_hasEncoded || !m_hasPicture) {
+        return true;
+    }
+    
+    // Changes of dropped frames go out as soon as the frame interval allows,
+    // an unchanged picture once keepAliveMs have passed
+    uint64_t intervalUs = m_config.framerate > 0 ? 1000000 / static_cast<uint64_t>(m_config.framerate) : 0;
+    uint64_t keepAliveUs = static_cast<uint64_t>(std::max(m_config.keepAliveMs, 0)) * 1000;
+    bool due = m_skippedChanges ? timestamp + intervalUs / 4 >= m_nextDueTimestamp
+                                : timestamp >= m_lastEncodedTimestamp + keepAliveUs;
+    if (!due) {
+        return true;
+    }
+    
+    // Stands in for a static capture: no pixels, and no regions of interest
+    // without a capture size to map them from
+    capture::Frame repeat;
+    repeat.width = 0;
+    repeat.height = 0;
+    repeat.timestamp = timestamp;
+    repeat.identical = true;
+    if (!finishPrepare(repeat, true, prepared)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.keepAliveFrames++;
+    return true;
+}
+
+uint64_t FFmpegEncoder::pendingChangesDue() {
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    
+    if (!m_initialized || !m_hasEncoded || !m_hasPicture || !m_skippedChanges) {
+        return 0;
+    }
+    
+    // prepareKeepAlive() accepts them a quarter interval early
+    uint64_t intervalUs = m_config.framerate > 0 ? 1000000 / static_cast<uint64_t>(m_config.framerate) : 0;
+    return std::max<uint64_t>(m_nextDueTimestamp - std::min(m_nextDueTimestamp, intervalUs / 4), 1);
+}
+
+bool FFmpegEncoder::convertPicture(const capture::Frame& frame) {
+    // Make frame writable; an incremental update needs the previous picture
+    if (!makePictureWritable(canConvertIncrementally(frame))) {
         Logger::getInstance().log(LogLevel::Error, "Failed to make frame writable");
         return false;
     }
@@ -267,28 +756,338 @@ bool FFmpegEncoder::encodeFrame(const capture::Frame& frame) {
         return false;
     }
     
+    m_hasPicture = true;
+    return true;
+}
+
+bool FFmpegEncoder::prepareScaled(const PlanarImage& source, const capture::Frame& frame, PreparedFramePtr& prepared) {
+    prepared.reset();
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+    
+    bool contiguous = frame.sequence == m_lastSequence + 1;
+    
+    if (shouldSkipFrame(frame)) {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.framesSkipped++;
+        return true;
+    }
+    
+    // Every pixel is rewritten, so the old content need not be kept
+    if (!makePictureWritable(false)) {
+        Logger::getInstance().log(LogLevel::Error, "Failed to make frame writable");
+        return false;
+    }
+    
+    PlanarImage picture;
+    for (int plane = 0; plane < 3; ++plane) {
+        picture.data[plane] = m_frame->data[plane];
+        picture.linesize[plane] = m_frame->linesize[plane];
+    }
+    picture.width = m_frame->width;
+    picture.height = m_frame->height;
+    
+    auto start = std::chrono::steady_clock::now();
+    if (!m_yuvScaler.scale(source, picture)) {
+        Logger::getInstance().log(LogLevel::Error, "Failed to scale picture");
+        return false;
+    }
+    
+    // Not a converted capture: dirty-region updates need a full conversion first
+    m_yuvValid = false;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.fullConversions++;
+        float totalMs = elapsedMs(start);
+        m_stats.conversionMs += kTimingSmoothing * (totalMs - m_stats.conversionMs);
+    }
+    
+    return finishPrepare(frame, contiguous, prepared);
+}
+
+bool FFmpegEncoder::getPicture(const PreparedFramePtr& prepared, PlanarImage& picture) {
+    auto* source = dynamic_cast<FFmpegPreparedFrame*>(prepared.get());
+    if (!source || !source->frame || source->frame->format != AV_PIX_FMT_YUV420P) {
+        return false;
+    }
+    
+    for (int plane = 0; plane < 3; ++plane) {
+        picture.data[plane] = source->frame->data[plane];
+        picture.linesize[plane] = source->frame->linesize[plane];
+    }
+    picture.width = source->frame->width;
+    picture.height = source->frame->height;
+    return true;
+}
+
+bool FFmpegEncoder::finishPrepare(const capture::Frame& frame, bool contiguous, PreparedFramePtr& prepared) {
     // Set PTS
-    m_frame->pts = m_pts++;
+    m_frame->pts = nextPts(frame);
+    
+    // Hand out a reference; the next prepareFrame() moves m_frame to a new
+    // buffer if this one is still in use
+    auto result = std::make_shared<FFmpegPreparedFrame>();
+    result->frame = av_frame_alloc();
+    if (!result->frame || av_frame_ref(result->frame, m_frame) < 0) {
+        Logger::getInstance().log(LogLevel::Error, "Failed to reference frame");
+        return false;
+    }
+    attachRegionsOfInterest(frame, contiguous, result->frame);
+    result->pts = m_frame->pts;
+    result->captureTimestamp = frame.timestamp;
+    result->generation = m_codecGeneration;
+    
+    // Phase-locked to the frame interval, so capture jitter does not lower
+    // the rate; after a pause the schedule restarts instead of catching up
+    uint64_t intervalUs = m_config.framerate > 0 ? 1000000 / static_cast<uint64_t>(m_config.framerate) : 0;
+    if (!m_hasEncoded || frame.timestamp > m_nextDueTimestamp + intervalUs / 2) {
+        m_nextDueTimestamp = frame.timestamp + intervalUs;
+    } else {
+        m_nextDueTimestamp += intervalUs;
+    }
+    
+    m_hasEncoded = true;
+    m_hasPicture = true;
+    m_lastEncodedTimestamp = frame.timestamp;
+    m_skippedChanges = false;
+    m_skippedRects.clear();
+    prepared = std::move(result);
+    return true;
+}
+
+bool FFmpegEncoder::encodePreparedFrame(const PreparedFramePtr& prepared) {
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+    
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+    
+    auto* picture = dynamic_cast<FFmpegPreparedFrame*>(prepared.get());
+    if (!picture) {
+        Logger::getInstance().log(LogLevel::Error, "Prepared frame does not belong to this encoder");
+        return false;
+    }
+    
+    // Prepared for a codec instance reconfigure() has since replaced: its
+    // size or PTS would not fit the new one
+    if (picture->generation != m_codecGeneration) {
+        return true;
+    }
+    
+    // Bound the map in case the codec swallows frames without output
+    if (m_pendingTimestamps.size() >= kMaxPendingTimestamps) {
+        m_pendingTimestamps.pop_front();
+    }
+    m_pendingTimestamps.emplace_back(picture->pts, picture->captureTimestamp);
+    
+    bool forceKeyframe = m_keyframeInterval > 0 && m_framesSinceKeyframe >= m_keyframeInterval;
+    if (m_keyframeRequested.load(std::memory_order_acquire)) {
+        // One keyframe answers every request made so far; requests inside
+        // the interval stay pending until it has passed
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::chrono::milliseconds(std::max(m_config.keyframeRequestIntervalMs, 0));
+        if (forceKeyframe || now - m_lastRequestedKeyframe >= interval) {
+            m_keyframeRequested.store(false, std::memory_order_relaxed);
+            m_lastRequestedKeyframe = now;
+            if (!forceKeyframe) {
+                std::lock_guard<std::mutex> lock(m_statsMutex);
+                m_stats.requestedKeyframes++;
+            }
+            forceKeyframe = true;
+        }
+    }
+    picture->frame->pict_type = forceKeyframe ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+    m_framesSinceKeyframe = forceKeyframe ? 1 : m_framesSinceKeyframe + 1;
     
     // Encode frame
-    if (!encodeAVFrame(m_frame)) {
+    auto start = std::chrono::steady_clock::now();
+    if (!encodeAVFrame(picture->frame)) {
         Logger::getInstance().log(LogLevel::Error, "Failed to encode frame");
         return false;
     }
+    float encodeMs = elapsedMs(start);
     
     // Update stats
     {
         std::lock_guard<std::mutex> lock(m_statsMutex);
+        if (m_stats.framesEncoded == 0) {
+            m_firstFrameTime = start;
+            m_stats.encodeMs = encodeMs;
+        }
         m_stats.framesEncoded++;
+        m_stats.encodeMs += kTimingSmoothing * (encodeMs - m_stats.encodeMs);
+    }
+    
+    return true;
+}
+
+void FFmpegEncoder::requestKeyframe() {
+    m_keyframeRequested.store(true, std::memory_order_release);
+    
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.keyframeRequests++;
+}
+
+bool FFmpegEncoder::allocatePicture(AVFrame* frame) {
+    AVBufferRef* buffer = av_buffer_pool_get(m_picturePool);
+    if (!buffer) {
+        return false;
+    }
+    
+    int ret = av_image_fill_arrays(frame->data, frame->linesize, buffer->data,
+                                   static_cast<AVPixelFormat>(frame->format),
+                                   frame->width, frame->height, kPictureAlign);
+    if (ret < 0) {
+        av_buffer_unref(&buffer);
+        return false;
+    }
+    frame->buf[0] = buffer;
+    frame->extended_data = frame->data;
+    return true;
+}
+
+bool FFmpegEncoder::makePictureWritable(bool preserveContent) {
+    if (av_frame_is_writable(m_frame)) {
+        return true;
+    }
+    
+    // Still referenced by a prepared frame or the codec: switch to a pooled
+    // buffer, copying only when the conversion updates dirty regions
+    AVFrame* fresh = av_frame_alloc();
+    if (!fresh) {
+        return false;
+    }
+    fresh->format = m_frame->format;
+    fresh->width = m_frame->width;
+    fresh->height = m_frame->height;
+    
+    if (!allocatePicture(fresh) ||
+        (preserveContent && av_frame_copy(fresh, m_frame) < 0) ||
+        av_frame_copy_props(fresh, m_frame) < 0) {
+        av_frame_free(&fresh);
+        return false;
+    }
+    
+    av_frame_unref(m_frame);
+    av_frame_move_ref(m_frame, fresh);
+    av_frame_free(&fresh);
+    return true;
+}
+
+bool FFmpegEncoder::shouldSkipFrame(const capture::Frame& frame) {
+    // "Identical" compares with the previous capture, which is only the
+    // last frame we saw if none was dropped in between
+    bool contiguous = frame.sequence == m_lastSequence + 1;
+    m_lastSequence = frame.sequence;
+    
+    if (!m_hasEncoded) {
+        return false;
+    }
+    
+    // framerate is an upper bound in both modes: frames arriving faster are
+    // dropped, with a quarter interval of slack for capture jitter
+    uint64_t intervalUs = m_config.framerate > 0 ? 1000000 / static_cast<uint64_t>(m_config.framerate) : 0;
+    if (frame.timestamp + intervalUs / 4 < m_nextDueTimestamp) {
+        skipFrame(frame, contiguous);
+        return true;
+    }
+    
+    // Unchanged since the last encoded picture, unless a dropped frame
+    // changed something in between
+    if (!m_config.variableFrameRate || !frame.identical || !contiguous || m_skippedChanges) {
+        return false;
+    }
+    
+    uint64_t keepAliveUs = static_cast<uint64_t>(std::max(m_config.keepAliveMs, 0)) * 1000;
+    if (frame.timestamp - m_lastEncodedTimestamp >= keepAliveUs) {
+        return false;
     }
     
+    skipFrame(frame, contiguous);
     return true;
 }
 
+void FFmpegEncoder::skipFrame(const capture::Frame& frame, bool contiguous) {
+    if (contiguous && frame.identical) {
+        // The converted picture still matches this frame
+        if (m_yuvValid && frame.sequence == m_yuvSequence + 1) {
+            m_yuvSequence = frame.sequence;
+        }
+        return;
+    }
+    
+    // Sent with a later frame, whose regions of interest must cover it too
+    m_skippedChanges = true;
+    bool wholeFrame = !contiguous || frame.dirtyRects.empty();
+    if (wholeFrame || m_skippedRects.size() + frame.dirtyRects.size() > kMaxSkippedRects) {
+        m_skippedRects.assign(1, capture::Rect{0, 0, frame.width, frame.height});
+    } else {
+        m_skippedRects.insert(m_skippedRects.end(), frame.dirtyRects.begin(), frame.dirtyRects.end());
+    }
+}
+
+int64_t FFmpegEncoder::nextPts(const capture::Frame& frame) {
+    if (!m_hasEncoded) {
+        m_firstTimestamp = frame.timestamp;
+        m_pts = 0;
+        return m_pts;
+    }
+    
+    // Both modes follow the capture clock, so time the screen sat still or
+    // frames were dropped is kept; CFR rounds to the nearest frame interval
+    int64_t pts = static_cast<int64_t>(frame.timestamp - m_firstTimestamp);
+    if (!m_config.variableFrameRate) {
+        pts = (pts * m_config.framerate + 500000) / 1000000;
+    }
+    
+    // Keep PTS strictly increasing even if capture timestamps collide
+    m_pts = std::max(pts, m_pts + 1);
+    return m_pts;
+}
+
 bool FFmpegEncoder::convertFrame(const capture::Frame& frame, AVFrame* avFrame) {
+    // No scaling needed: use the dedicated converter
+    capture::PixelFormat dstFormat = avFrame->format == AV_PIX_FMT_NV12
+        ? capture::PixelFormat::NV12 : capture::PixelFormat::YUV420P;
+    if (frame.width == avFrame->width && frame.height == avFrame->height &&
+        (avFrame->format == AV_PIX_FMT_YUV420P || avFrame->format == AV_PIX_FMT_NV12) &&
+        m_colorConverter.configure(frame.pixelFormat, dstFormat,
+                                   parseColorMatrix(m_config.colorMatrix), m_config.fullRange)) {
+        auto start = std::chrono::steady_clock::now();
+        bool fullFrame = !canConvertIncrementally(frame);
+        if (fullFrame) {
+            convertBands(frame, avFrame);
+        } else {
+            convertDirtyRects(frame, avFrame);
+        }
+        recordConversionTime(elapsedMs(start), fullFrame);
+        
+        m_yuvValid = true;
+        m_yuvSourceFormat = frame.pixelFormat;
+        m_yuvSequence = frame.sequence;
+        return true;
+    }
+    
+    // The scaled picture is not a base for dirty-region updates
+    m_yuvValid = false;
+    
+    // Built lazily for whatever the capture delivers
+    int srcFormat = frame.pixelFormat == capture::PixelFormat::RGBA8 ? AV_PIX_FMT_RGBA : AV_PIX_FMT_BGRA;
+    if (!m_swsContext || frame.width != m_scalerSrcWidth || frame.height != m_scalerSrcHeight ||
+        srcFormat != m_scalerSrcFormat) {
+        if (!initializeScaler(frame.width, frame.height, srcFormat)) {
+            return false;
+        }
+    }
+    
     // Setup source data
-    const uint8_t* srcData[4] = {frame.data.data(), nullptr, nullptr, nullptr};
-    int srcLinesize[4] = {static_cast<int>(frame.width * 4), 0, 0, 0}; // BGRA = 4 bytes per pixel
+    const uint8_t* srcData[4] = {frame.pixels(), nullptr, nullptr, nullptr};
+    int srcLinesize[4] = {frame.stride, 0, 0, 0}; // Rows may be padded beyond width * 4
     
     // Convert
     int ret = sws_scale(
@@ -305,6 +1104,176 @@ bool FFmpegEncoder::convertFrame(const capture::Frame& frame, AVFrame* avFrame)
     return true;
 }
 
+void FFmpegEncoder::convertBands(const capture::Frame& frame, AVFrame* avFrame) {
+    // Even band heights keep every 2x2 chroma block inside one band
+    int rowsPerBand = static_cast<int>((frame.height + m_conversionBands - 1) / m_conversionBands);
+    rowsPerBand = (rowsPerBand + 1) & ~1;
+    
+    auto convertBand = [&](size_t band) {
+        auto start = std::chrono::steady_clock::now();
+        int rowBegin = static_cast<int>(band) * rowsPerBand;
+        m_colorConverter.convertRows(frame.pixels(), frame.stride, frame.width, frame.height,
+                                     rowBegin, rowBegin + rowsPerBand,
+                                     avFrame->data, avFrame->linesize);
+        m_bandMs[band] = elapsedMs(start);
+    };
+    
+    if (m_conversionPool) {
+        m_conversionPool->parallelFor(m_conversionBands, convertBand);
+    } else {
+        convertBand(0);
+    }
+}
+
+bool FFmpegEncoder::canConvertIncrementally(const capture::Frame& frame) const {
+    // Dirty regions are relative to the previous capture, so any dropped
+    // frame in between (a sequence gap) invalidates them
+    bool wholeFrame = frame.dirtyRects.empty() && !frame.identical;
+    if (!m_config.incrementalConversion || !m_yuvValid || wholeFrame ||
+        frame.pixelFormat != m_yuvSourceFormat || frame.sequence != m_yuvSequence + 1) {
+        return false;
+    }
+    
+    // Overlaps count twice, which only errs towards a full conversion
+    int64_t dirtyArea = 0;
+    for (const auto& rect : frame.dirtyRects) {
+        dirtyArea += static_cast<int64_t>(rect.width) * rect.height;
+    }
+    int64_t frameArea = static_cast<int64_t>(frame.width) * frame.height;
+    return dirtyArea <= static_cast<int64_t>(m_config.fullConversionThreshold * frameArea);
+}
+
+void FFmpegEncoder::convertDirtyRects(const capture::Frame& frame, AVFrame* avFrame) {
+    // Identical frames leave the previous picture as it is
+    if (frame.dirtyRects.empty()) {
+        return;
+    }
+    
+    int rowsPerBand = static_cast<int>((frame.height + m_conversionBands - 1) / m_conversionBands);
+    rowsPerBand = (rowsPerBand + 1) & ~1;
+    
+    // Each band clips every rectangle to its own rows, so overlapping
+    // rectangles never have two threads writing the same bytes
+    auto convertBand = [&](size_t band) {
+        int bandTop = static_cast<int>(band) * rowsPerBand;
+        int bandBottom = bandTop + rowsPerBand;
+        for (const auto& rect : frame.dirtyRects) {
+            int top = std::max(rect.y, bandTop);
+            int bottom = std::min(rect.y + rect.height, bandBottom);
+            if (top < bottom) {
+                capture::Rect clipped = {rect.x, top, rect.width, bottom - top};
+                m_colorConverter.convertRect(frame.pixels(), frame.stride, frame.width, frame.height,
+                                             clipped, avFrame->data, avFrame->linesize);
+            }
+        }
+    };
+    
+    if (m_conversionPool) {
+        m_conversionPool->parallelFor(m_conversionBands, convertBand);
+    } else {
+        convertBand(0);
+    }
+}
+
+void FFmpegEncoder::recordConversionTime(float totalMs, bool fullFrame) {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    
+    if (!fullFrame) {
+        m_stats.partialConversions++;
+        m_stats.conversionMs += kTimingSmoothing * (totalMs - m_stats.conversionMs);
+        return;
+    }
+    
+    m_stats.fullConversions++;
+    if (m_stats.conversionBandMs.size() != m_bandMs.size()) {
+        m_stats.conversionBandMs = m_bandMs;
+        m_stats.conversionMs = totalMs;
+        return;
+    }
+    
+    m_stats.conversionMs += kTimingSmoothing * (totalMs - m_stats.conversionMs);
+    for (size_t i = 0; i < m_bandMs.size(); ++i) {
+        m_stats.conversionBandMs[i] += kTimingSmoothing * (m_bandMs[i] - m_stats.conversionBandMs[i]);
+    }
+}
+
+void FFmpegEncoder::attachRegionsOfInterest(const capture::Frame& frame, bool contiguous, AVFrame* avFrame) {
+    if (!m_config.regionOfInterest || frame.width <= 0 || frame.height <= 0) {
+        return;
+    }
+    
+    // Capture coordinates to picture coordinates, rounded outwards
+    double scaleX = static_cast<double>(avFrame->width) / frame.width;
+    double scaleY = static_cast<double>(avFrame->height) / frame.height;
+    std::vector<AVRegionOfInterest> regions;
+    auto addRegion = [&](const capture::Rect& rect, float offset) {
+        int left = std::max(static_cast<int>(std::floor(rect.x * scaleX)), 0);
+        int top = std::max(static_cast<int>(std::floor(rect.y * scaleY)), 0);
+        int right = std::min(static_cast<int>(std::ceil((rect.x + rect.width) * scaleX)), avFrame->width);
+        int bottom = std::min(static_cast<int>(std::ceil((rect.y + rect.height) * scaleY)), avFrame->height);
+        if (left >= right || top >= bottom) {
+            return;
+        }
+        
+        AVRegionOfInterest region = {};
+        region.self_size = sizeof(AVRegionOfInterest);
+        region.top = top;
+        region.bottom = bottom;
+        region.left = left;
+        region.right = right;
+        region.qoffset = av_make_q(static_cast<int>(std::lround(std::clamp(offset, -1.0f, 1.0f) * 100)), 100);
+        regions.push_back(region);
+    };
+    
+    // Encoders apply the first region covering a block, so the most
+    // important come first
+    for (const auto& focus : m_config.focusRegions) {
+        addRegion({focus.x, focus.y, focus.width, focus.height}, focus.qualityOffset);
+    }
+    
+    // Changes of dropped frames count as well; finishPrepare() clears them
+    if (!m_skippedRects.empty()) {
+        m_skippedRects.insert(m_skippedRects.end(), frame.dirtyRects.begin(), frame.dirtyRects.end());
+    }
+    const std::vector<capture::Rect>& dirtyRects = m_skippedRects.empty() ? frame.dirtyRects : m_skippedRects;
+    
+    // Without usable dirty regions the whole frame counts as changed and
+    // nothing is static
+    bool wholeFrame = !contiguous || (frame.dirtyRects.empty() && !frame.identical);
+    if (!wholeFrame) {
+        if (m_config.roiChangedOffset != 0.0f && dirtyRects.size() <= kMaxChangedRegions) {
+            for (const auto& rect : dirtyRects) {
+                addRegion(rect, m_config.roiChangedOffset);
+            }
+        } else if (m_config.roiChangedOffset != 0.0f) {
+            int left = frame.width, top = frame.height, right = 0, bottom = 0;
+            for (const auto& rect : dirtyRects) {
+                left = std::min(left, rect.x);
+                top = std::min(top, rect.y);
+                right = std::max(right, rect.x + rect.width);
+                bottom = std::max(bottom, rect.y + rect.height);
+            }
+            addRegion({left, top, right - left, bottom - top}, m_config.roiChangedOffset);
+        }
+        
+        if (m_config.roiStaticOffset != 0.0f) {
+            addRegion({0, 0, frame.width, frame.height}, m_config.roiStaticOffset);
+        }
+    }
+    
+    if (regions.empty()) {
+        return;
+    }
+    
+    size_t bytes = regions.size() * sizeof(AVRegionOfInterest);
+    AVFrameSideData* sideData = av_frame_new_side_data(avFrame, AV_FRAME_DATA_REGIONS_OF_INTEREST, bytes);
+    if (!sideData) {
+        Logger::getInstance().log(LogLevel::Warning, "Failed to attach region-of-interest data");
+        return;
+    }
+    std::memcpy(sideData->data, regions.data(), bytes);
+}
+
 bool FFmpegEncoder::encodeAVFrame(AVFrame* frame) {
     // Send frame to encoder
     int ret = avcodec_send_frame(m_codecContext, frame);
@@ -315,8 +1284,8 @@ bool FFmpegEncoder::encodeAVFrame(AVFrame* frame) {
         return false;
     }
     
-    // Receive packets from encoder
-    while (ret >= 0) {
+    // Drain every packet this send produced
+    for (;;) {
         ret = avcodec_receive_packet(m_codecContext, m_packet);
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
             break;
@@ -327,50 +1296,128 @@ bool FFmpegEncoder::encodeAVFrame(AVFrame* frame) {
             return false;
         }
         
+        EncodedPacketPtr packet = wrapPacket(m_packet);
+        if (!packet) {
+            av_packet_unref(m_packet);
+            return false;
+        }
+        
         // Update stats
         {
             std::lock_guard<std::mutex> lock(m_statsMutex);
             m_stats.packetsGenerated++;
-            m_stats.bytesEncoded += m_packet->size;
+            m_stats.bytesEncoded += packet->size;
+            
+            // Bitrate over whole one-second windows
+            auto now = std::chrono::steady_clock::now();
+            m_rateWindowBytes += packet->size;
+            float windowSeconds = std::chrono::duration<float>(now - m_rateWindowStart).count();
+            if (windowSeconds >= 1.0f) {
+                m_stats.currentBitrate = static_cast<float>(m_rateWindowBytes * 8) / windowSeconds;
+                m_rateWindowStart = now;
+                m_rateWindowBytes = 0;
+            }
             
-            if (m_packet->flags & AV_PKT_FLAG_KEY) {
+            if (packet->keyframe) {
                 m_stats.keyFrames++;
             }
         }
+        recordLatency(*packet);
         
-        // Packet will be retrieved via getEncodedPacket()
-        break;
+        // libavcodec returns whole frames, so slices are split afterwards
+        if (m_config.lowLatency) {
+            splitSlices(packet, m_codecContext->codec_id == AV_CODEC_ID_HEVC, m_slices);
+        } else {
+            m_slices.assign(1, std::move(packet));
+        }
+        
+        std::lock_guard<std::mutex> lock(m_packetMutex);
+        for (auto& slice : m_slices) {
+            m_packetQueue.push_back(std::move(slice));
+        }
+        m_slices.clear();
     }
     
     return true;
 }
 
-bool FFmpegEncoder::getEncodedPacket(std::vector<uint8_t>& packet) {
-    if (!m_initialized || !m_packet->data) {
-        return false;
+EncodedPacketPtr FFmpegEncoder::wrapPacket(AVPacket* source) {
+    // Move the reference out so m_packet can be reused; the buffer itself is not copied
+    AVPacket* owned = av_packet_alloc();
+    if (!owned) {
+        Logger::getInstance().log(LogLevel::Error, "Failed to allocate packet");
+        return nullptr;
+    }
+    av_packet_move_ref(owned, source);
+    
+    auto packet = std::make_shared<EncodedPacket>();
+    packet->avPacket = std::shared_ptr<AVPacket>(owned, [](AVPacket* p) { av_packet_free(&p); });
+    packet->data = owned->data;
+    packet->size = static_cast<size_t>(owned->size);
+    packet->pts = owned->pts;
+    packet->dts = owned->dts;
+    packet->timeBaseNum = m_codecContext->time_base.num;
+    packet->timeBaseDen = m_codecContext->time_base.den;
+    packet->keyframe = (owned->flags & AV_PKT_FLAG_KEY) != 0;
+    packet->captureTimestamp = takeCaptureTimestamp(owned->pts);
+    packet->streamId = m_config.streamId;
+    parseAnnexB(packet->data, packet->size, m_codecContext->codec_id == AV_CODEC_ID_HEVC, packet->nalUnits);
+    packet->disposable = isNonReference(*packet, m_codecContext->codec_id == AV_CODEC_ID_HEVC);
+    
+    return packet;
+}
+
+void FFmpegEncoder::recordLatency(const EncodedPacket& packet) {
+    if (packet.captureTimestamp == 0) {
+        return;
     }
     
-    // Copy packet data
-    packet.resize(m_packet->size);
-    std::memcpy(packet.data(), m_packet->data, m_packet->size);
+    // Capture timestamps are steady_clock microseconds on every platform
+    uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    float latencyMs = now > packet.captureTimestamp
+        ? static_cast<float>(now - packet.captureTimestamp) / 1000.0f : 0.0f;
     
-    // Free packet data
-    av_packet_unref(m_packet);
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.latencyMs = m_stats.latencyMs == 0.0f
+        ? latencyMs : m_stats.latencyMs + kTimingSmoothing * (latencyMs - m_stats.latencyMs);
+    m_stats.maxLatencyMs = std::max(m_stats.maxLatencyMs, latencyMs);
+}
+
+uint64_t FFmpegEncoder::takeCaptureTimestamp(int64_t pts) {
+    // Packets leave in decode order, so the match is not always at the front
+    for (auto it = m_pendingTimestamps.begin(); it != m_pendingTimestamps.end(); ++it) {
+        if (it->first == pts) {
+            uint64_t timestamp = it->second;
+            m_pendingTimestamps.erase(it);
+            return timestamp;
+        }
+    }
+    return 0;
+}
+
+bool FFmpegEncoder::getEncodedPacket(EncodedPacketPtr& packet) {
+    std::lock_guard<std::mutex> lock(m_packetMutex);
+    if (m_packetQueue.empty()) {
+        return false;
+    }
     
+    packet = std::move(m_packetQueue.front());
+    m_packetQueue.pop_front();
     return true;
 }
 
 EncoderStats FFmpegEncoder::getStats() const {
     std::lock_guard<std::mutex> lock(m_statsMutex);
     
-    // Calculate FPS and bitrate
+    // Measured from the first encoded frame, not taken from the configuration
     EncoderStats stats = m_stats;
     
-    if (stats.framesEncoded > 0) {
-        // This is a simplified calculation - in production you'd use actual time measurements
-        stats.averageFps = static_cast<float>(m_config.framerate);
-        stats.currentBitrate = static_cast<float>(stats.bytesEncoded * 8) / 
-                              (static_cast<float>(stats.framesEncoded) / m_config.framerate);
+    if (stats.framesEncoded > 1) {
+        float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_firstFrameTime).count();
+        if (seconds > 0.0f) {
+            stats.averageFps = static_cast<float>(stats.framesEncoded - 1) / seconds;
+        }
     }
     
     return stats;
@@ -388,11 +1435,31 @@ FFmpegEncoder::FFmpegEncoder()
     : m_codecContext(nullptr)
     , m_codec(nullptr)
     , m_swsContext(nullptr)
+    , m_scalerSrcWidth(0)
+    , m_scalerSrcHeight(0)
+    , m_scalerSrcFormat(-1)
+    , m_conversionBands(1)
+    , m_yuvValid(false)
+    , m_yuvSourceFormat(capture::PixelFormat::UNKNOWN)
+    , m_yuvSequence(0)
     , m_frame(nullptr)
+    , m_picturePool(nullptr)
     , m_packet(nullptr)
+    , m_codecGeneration(0)
+    , m_keyframeInterval(0)
+    , m_framesSinceKeyframe(0)
+    , m_keyframeRequested(false)
     , m_initialized(false)
+    , m_rateWindowBytes(0)
     , m_frameNumber(0)
-    , m_pts(0) {
+    , m_pts(0)
+    , m_hasEncoded(false)
+    , m_firstTimestamp(0)
+    , m_lastEncodedTimestamp(0)
+    , m_nextDueTimestamp(0)
+    , m_skippedChanges(false)
+    , m_hasPicture(false)
+    , m_lastSequence(0) {
 }
 
 FFmpegEncoder::~FFmpegEncoder() {
@@ -406,11 +1473,50 @@ bool FFmpegEncoder::initialize(const EncoderConfig& config) {
 void FFmpegEncoder::shutdown() {
 }
 
+ReconfigureResult FFmpegEncoder::reconfigure(const EncoderConfig& config) {
+    return ReconfigureResult();
+}
+
 bool FFmpegEncoder::encodeFrame(const capture::Frame& frame) {
     return false;
 }
 
-bool FFmpegEncoder::getEncodedPacket(std::vector<uint8_t>& packet) {
+bool FFmpegEncoder::prepareFrame(const capture::Frame& frame, PreparedFramePtr& prepared) {
+    return false;
+}
+
+bool FFmpegEncoder::prepareKeepAlive(uint64_t timestamp, PreparedFramePtr& prepared) {
+    return false;
+}
+
+uint64_t FFmpegEncoder::pendingChangesDue() {
+    return 0;
+}
+
+bool FFmpegEncoder::convertPicture(const capture::Frame& frame) {
+    return false;
+}
+
+bool FFmpegEncoder::prepareScaled(const PlanarImage& source, const capture::Frame& frame, PreparedFramePtr& prepared) {
+    return false;
+}
+
+bool FFmpegEncoder::getPicture(const PreparedFramePtr& prepared, PlanarImage& picture) {
+    return false;
+}
+
+bool FFmpegEncoder::finishPrepare(const capture::Frame& frame, bool contiguous, PreparedFramePtr& prepared) {
+    return false;
+}
+
+bool FFmpegEncoder::encodePreparedFrame(const PreparedFramePtr& prepared) {
+    return false;
+}
+
+void FFmpegEncoder::requestKeyframe() {
+}
+
+bool FFmpegEncoder::getEncodedPacket(EncodedPacketPtr& packet) {
     return false;
 }
 
@@ -421,22 +1527,89 @@ EncoderStats FFmpegEncoder::getStats() const {
 void FFmpegEncoder::cleanupFFmpeg() {
 }
 
+bool FFmpegEncoder::allocatePicture(AVFrame* frame) {
+    return false;
+}
+
+bool FFmpegEncoder::makePictureWritable(bool preserveContent) {
+    return false;
+}
+
 bool FFmpegEncoder::initializeCodec(const EncoderConfig& config) {
     return false;
 }
 
+std::vector<std::string> FFmpegEncoder::candidateEncoders(const std::string& codec, bool hardware) {
+    return {};
+}
+
+void FFmpegEncoder::applyRateControl(const EncoderConfig& config) {
+}
+
+void FFmpegEncoder::applyLowLatency(const EncoderConfig& config) {
+}
+
+bool FFmpegEncoder::initializePicture() {
+    return false;
+}
+
+void FFmpegEncoder::releasePicture() {
+}
+
+void FFmpegEncoder::initializeConversion(const EncoderConfig& config) {
+}
+
 bool FFmpegEncoder::initializeScaler(int srcWidth, int srcHeight, int srcFormat) {
     return false;
 }
 
+bool FFmpegEncoder::needsCodecRebuild(const EncoderConfig& config) const {
+    return false;
+}
+
+bool FFmpegEncoder::supportsRateReconfig(const EncoderConfig& config) const {
+    return false;
+}
+
+bool FFmpegEncoder::rebuildCodec(const EncoderConfig& config) {
+    return false;
+}
+
 bool FFmpegEncoder::convertFrame(const capture::Frame& frame, AVFrame* avFrame) {
     return false;
 }
 
+void FFmpegEncoder::convertBands(const capture::Frame& frame, AVFrame* avFrame) {
+}
+
+bool FFmpegEncoder::canConvertIncrementally(const capture::Frame& frame) const {
+    return false;
+}
+
+void FFmpegEncoder::convertDirtyRects(const capture::Frame& frame, AVFrame* avFrame) {
+}
+
+void FFmpegEncoder::recordConversionTime(float totalMs, bool fullFrame) {
+}
+
+void FFmpegEncoder::attachRegionsOfInterest(const capture::Frame& frame, bool contiguous, AVFrame* avFrame) {
+}
+
 bool FFmpegEncoder::encodeAVFrame(AVFrame* frame) {
     return false;
 }
 
+bool FFmpegEncoder::shouldSkipFrame(const capture::Frame& frame) {
+    return false;
+}
+
+void FFmpegEncoder::skipFrame(const capture::Frame& frame, bool contiguous) {
+}
+
+int64_t FFmpegEncoder::nextPts(const capture::Frame& frame) {
+    return 0;
+}
+
 } // namespace encoder
 } // namespace talos
 
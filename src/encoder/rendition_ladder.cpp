@@ -0,0 +1,445 @@
+#include "encoder/rendition_ladder.h"
+#include "capture/capture_engine.h"
+#include "core/logger.h"
+#include <algorithm>
+
+namespace talos {
+namespace encoder {
+
+namespace {
+
+// Same smoothing as the per-stream timings
+constexpr float kTimingSmoothing = 0.1f;
+
+float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief One prepared picture per rung, all for the same frame
+ */
+struct LadderPreparedFrame : PreparedFrame {
+    std::vector<PreparedFramePtr> rungs;
+    uint64_t generation = 0;    // Rung set it was prepared for
+};
+
+} // namespace
+
+RenditionLadder::RenditionLadder()
+    : m_generation(0)
+    , m_lastSequence(0)
+    , m_initialized(false)
+    , m_keyframeRequests(0)
+    , m_encodeMs(0.0f) {
+}
+
+RenditionLadder::~RenditionLadder() {
+    shutdown();
+}
+
+bool RenditionLadder::rungConfigs(const EncoderConfig& config, std::vector<EncoderConfig>& rungs) {
+    rungs.clear();
+
+    EncoderConfig main = config;
+    main.renditions.clear();
+    rungs.push_back(main);
+
+    int64_t mainArea = std::max<int64_t>(static_cast<int64_t>(config.width) * config.height, 1);
+    for (size_t i = 0; i < config.renditions.size(); ++i) {
+        const RenditionConfig& rendition = config.renditions[i];
+        const EncoderConfig& above = rungs.back();
+
+        int height = rendition.height > 0 ? rendition.height : above.height;
+        int width = rendition.width > 0
+            ? rendition.width
+            : static_cast<int>((static_cast<int64_t>(height) * config.width + config.height / 2) /
+                               std::max(config.height, 1));
+
+        // Each rung is scaled from the one above, which only goes down
+        EncoderConfig rung = main;
+        rung.width = width & ~1;
+        rung.height = height & ~1;
+        if (rung.width < 2 || rung.height < 2 || rung.width > above.width || rung.height > above.height) {
+            Logger::getInstance().log(LogLevel::Error,
+                "Rendition " + std::to_string(width) + "x" + std::to_string(height) +
+                " must be smaller than the stream above it");
+            return false;
+        }
+
+        int64_t area = static_cast<int64_t>(rung.width) * rung.height;
+        rung.bitrate = rendition.bitrate > 0
+            ? rendition.bitrate : static_cast<int>(static_cast<int64_t>(config.bitrate) * area / mainArea);
+        rung.streamId = config.streamId + static_cast<int>(i) + 1;
+        rung.conversionBands = 1;   // Nothing to convert
+
+        // Focus regions stay in capture coordinates; the encoder scales them
+        rungs.push_back(rung);
+    }
+    return true;
+}
+
+bool RenditionLadder::initialize(const EncoderConfig& config) {
+    if (m_initialized) {
+        Logger::getInstance().log(LogLevel::Warning, "Rendition ladder already initialized");
+        return true;
+    }
+
+    std::vector<EncoderConfig> rungs;
+    if (!rungConfigs(config, rungs) || !createRungs(rungs)) {
+        return false;
+    }
+
+    m_encodePool = std::make_unique<ThreadPool>(rungs.size() - 1);
+    m_config = config;
+    m_initialized = true;
+
+    std::string ladder;
+    for (const auto& rung : rungs) {
+        ladder += (ladder.empty() ? "" : ", ") + std::to_string(rung.width) + "x" + std::to_string(rung.height);
+    }
+    Logger::getInstance().log(LogLevel::Info,
+        "Rendition ladder initialized: " + ladder + " (scaler: " + YuvScaler::kernelName() + ")");
+    return true;
+}
+
+bool RenditionLadder::createRungs(const std::vector<EncoderConfig>& configs) {
+    std::vector<std::unique_ptr<FFmpegEncoder>> rungs;
+    for (const auto& config : configs) {
+        auto rung = std::make_unique<FFmpegEncoder>();
+        if (!rung->initialize(config)) {
+            Logger::getInstance().log(LogLevel::Error,
+                "Failed to initialize encoder for stream " + std::to_string(config.streamId));
+            return false;
+        }
+        rungs.push_back(std::move(rung));
+    }
+
+    std::lock_guard<std::mutex> lock(m_rungsMutex);
+    m_rungs = std::move(rungs);
+    m_rungConfigs = configs;
+    return true;
+}
+
+void RenditionLadder::flushRungs() {
+    for (auto& rung : m_rungs) {
+        rung->shutdown();
+    }
+    collectPackets();
+}
+
+void RenditionLadder::shutdown() {
+    if (!m_initialized) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+
+    // Rungs stay around so their statistics can still be read
+    flushRungs();
+    m_encodePool.reset();
+    m_initialized = false;
+
+    Logger::getInstance().log(LogLevel::Info, "Rendition ladder shut down");
+}
+
+ReconfigureResult RenditionLadder::reconfigure(const EncoderConfig& config) {
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+
+    ReconfigureResult result;
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return result;
+    }
+
+    std::vector<EncoderConfig> rungs;
+    if (!rungConfigs(config, rungs)) {
+        return result;
+    }
+
+    if (rungs.size() != m_rungs.size()) {
+        // Streams come or go: flush the old set and start over
+        std::vector<EncoderConfig> previous = m_rungConfigs;
+        flushRungs();
+        if (!createRungs(rungs)) {
+            Logger::getInstance().log(LogLevel::Error, "Reconfiguration failed, restoring previous renditions");
+            if (!createRungs(previous)) {
+                Logger::getInstance().log(LogLevel::Error, "Failed to restore rendition ladder");
+                m_initialized = false;
+            }
+            m_generation++;
+            return result;
+        }
+        m_encodePool = std::make_unique<ThreadPool>(rungs.size() - 1);
+        result.codecRebuilt = true;
+        result.keyframeForced = true;
+        m_generation++;
+    } else {
+        // Each stream applies what it can in place
+        for (size_t i = 0; i < m_rungs.size(); ++i) {
+            ReconfigureResult rungResult = m_rungs[i]->reconfigure(rungs[i]);
+            if (!rungResult.success) {
+                // The failed rung restored itself; put the ones before it back too
+                Logger::getInstance().log(LogLevel::Error,
+                    "Failed to reconfigure stream " + std::to_string(rungs[i].streamId));
+                for (size_t j = 0; j < i; ++j) {
+                    m_rungs[j]->reconfigure(m_rungConfigs[j]);
+                }
+                m_generation++;
+                return result;
+            }
+            result.keyframeForced = result.keyframeForced || rungResult.keyframeForced;
+            result.codecRebuilt = result.codecRebuilt || rungResult.codecRebuilt;
+
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_rungsMutex);
+            m_rungConfigs = rungs;
+        }
+
+        // A rebuilt rung drops frames prepared for its old codec; drop them
+        // from every stream alike
+        if (result.codecRebuilt) {
+            m_generation++;
+        }
+    }
+
+    m_config = config;
+    result.success = true;
+    return result;
+}
+
+bool RenditionLadder::encodeFrame(const capture::Frame& frame) {
+    PreparedFramePtr prepared;
+    if (!prepareFrame(frame, prepared)) {
+        return false;
+    }
+    return !prepared || encodePreparedFrame(prepared);
+}
+
+bool RenditionLadder::prepareFrame(const capture::Frame& frame, PreparedFramePtr& prepared) {
+    prepared.reset();
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+
+    m_lastSequence = frame.sequence;
+    auto result = std::make_shared<LadderPreparedFrame>();
+    result->rungs.resize(m_rungs.size());
+
+    // The only RGB conversion
+    if (!m_rungs[0]->prepareFrame(frame, result->rungs[0])) {
+        return false;
+    }
+
+    // Every rung sees the same frame, so they skip it together and the
+    // rungs below have nothing to do either
+    if (!result->rungs[0]) {
+        PlanarImage none;
+        for (size_t i = 1; i < m_rungs.size(); ++i) {
+            m_rungs[i]->prepareScaled(none, frame, result->rungs[i]);
+        }
+        return true;
+    }
+
+    for (size_t i = 1; i < m_rungs.size(); ++i) {
+        PlanarImage above;
+        if (!FFmpegEncoder::getPicture(result->rungs[i - 1], above) ||
+            !m_rungs[i]->prepareScaled(above, frame, result->rungs[i])) {
+            Logger::getInstance().log(LogLevel::Error,
+                "Failed to scale stream " + std::to_string(m_rungConfigs[i].streamId));
+            return false;
+        }
+    }
+
+    result->pts = result->rungs[0]->pts;
+    result->captureTimestamp = frame.timestamp;
+    result->generation = m_generation;
+    prepared = std::move(result);
+    return true;
+}
+
+bool RenditionLadder::prepareKeepAlive(uint64_t timestamp, PreparedFramePtr& prepared) {
+    prepared.reset();
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+
+    auto result = std::make_shared<LadderPreparedFrame>();
+    result->rungs.resize(m_rungs.size());
+    if (!m_rungs[0]->prepareKeepAlive(timestamp, result->rungs[0])) {
+        return false;
+    }
+    if (!result->rungs[0]) {
+        return true;
+    }
+
+    // The main picture may hold changes of frames the rungs dropped, so the
+    // rungs below are scaled from it again rather than repeated. Reusing
+    // the last sequence number marks the stand-in as not contiguous, which
+    // keeps the next real frame contiguous.
+    capture::Frame repeat;
+    repeat.width = 0;
+    repeat.height = 0;
+    repeat.timestamp = timestamp;
+    repeat.sequence = m_lastSequence;
+    for (size_t i = 1; i < m_rungs.size(); ++i) {
+        PlanarImage above;
+        if (!FFmpegEncoder::getPicture(result->rungs[i - 1], above) ||
+            !m_rungs[i]->prepareScaled(above, repeat, result->rungs[i])) {
+            Logger::getInstance().log(LogLevel::Error,
+                "Failed to scale stream " + std::to_string(m_rungConfigs[i].streamId));
+            return false;
+        }
+    }
+
+    result->pts = result->rungs[0]->pts;
+    result->captureTimestamp = timestamp;
+    result->generation = m_generation;
+    prepared = std::move(result);
+    return true;
+}
+
+uint64_t RenditionLadder::pendingChangesDue() {
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+
+    // The lower rungs follow the main one in prepareKeepAlive()
+    if (!m_initialized || m_rungs.empty()) {
+        return 0;
+    }
+    return m_rungs[0]->pendingChangesDue();
+}
+
+bool RenditionLadder::encodePreparedFrame(const PreparedFramePtr& prepared) {
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+
+    auto* picture = dynamic_cast<LadderPreparedFrame*>(prepared.get());
+    if (!picture) {
+        Logger::getInstance().log(LogLevel::Error, "Prepared frame does not belong to this encoder");
+        return false;
+    }
+
+    // Prepared for rungs reconfigure() has since replaced
+    if (picture->generation != m_generation) {
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> ok(m_rungs.size(), 1);
+    m_encodePool->parallelFor(m_rungs.size(), [&](size_t i) {
+        if (picture->rungs[i]) {
+            ok[i] = m_rungs[i]->encodePreparedFrame(picture->rungs[i]);
+        }
+    });
+    float encodeMs = elapsedMs(start);
+
+    collectPackets();
+
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_encodeMs = m_encodeMs == 0.0f ? encodeMs : m_encodeMs + kTimingSmoothing * (encodeMs - m_encodeMs);
+    }
+
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        Logger::getInstance().log(LogLevel::Error, "Failed to encode renditions");
+        return false;
+    }
+    return true;
+}
+
+void RenditionLadder::collectPackets() {
+    EncodedPacketPtr packet;
+    std::lock_guard<std::mutex> lock(m_packetMutex);
+    for (auto& rung : m_rungs) {
+        while (rung->getEncodedPacket(packet)) {
+            m_packetQueue.push_back(std::move(packet));
+        }
+    }
+}
+
+void RenditionLadder::requestKeyframe() {
+    {
+        // Each stream coalesces and spaces its own requests
+        std::lock_guard<std::mutex> lock(m_rungsMutex);
+        for (auto& rung : m_rungs) {
+            rung->requestKeyframe();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_keyframeRequests++;
+}
+
+void RenditionLadder::requestKeyframe(int streamId) {
+    std::lock_guard<std::mutex> lock(m_rungsMutex);
+    for (size_t i = 0; i < m_rungs.size(); ++i) {
+        if (m_rungConfigs[i].streamId == streamId) {
+            m_rungs[i]->requestKeyframe();
+        }
+    }
+}
+
+bool RenditionLadder::getEncodedPacket(EncodedPacketPtr& packet) {
+    std::lock_guard<std::mutex> lock(m_packetMutex);
+
+    if (m_packetQueue.empty()) {
+        return false;
+    }
+
+    packet = std::move(m_packetQueue.front());
+    m_packetQueue.pop_front();
+    return true;
+}
+
+EncoderStats RenditionLadder::getStats() const {
+    EncoderStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_rungsMutex);
+        for (size_t i = 0; i < m_rungs.size(); ++i) {
+            EncoderStats rung = m_rungs[i]->getStats();
+            if (i == 0) {
+                stats = rung;
+            } else {
+                stats.bytesEncoded += rung.bytesEncoded;
+                stats.packetsGenerated += rung.packetsGenerated;
+                stats.currentBitrate += rung.currentBitrate;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    stats.keyframeRequests = m_keyframeRequests;
+    stats.encodeMs = m_encodeMs;
+    return stats;
+}
+
+bool RenditionLadder::getStreamStats(int streamId, EncoderStats& stats) const {
+    std::lock_guard<std::mutex> lock(m_rungsMutex);
+    for (size_t i = 0; i < m_rungs.size(); ++i) {
+        if (m_rungConfigs[i].streamId == streamId) {
+            stats = m_rungs[i]->getStats();
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<EncoderConfig> RenditionLadder::getStreams() const {
+    std::lock_guard<std::mutex> lock(m_rungsMutex);
+    return m_rungConfigs;
+}
+
+} // namespace encoder
+} // namespace talos
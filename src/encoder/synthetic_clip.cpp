@@ -0,0 +1,165 @@
+#include "encoder/synthetic_clip.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace talos {
+namespace encoder {
+
+namespace {
+
+// Glyph cell of the synthetic text, in pixels
+constexpr int kCellWidth = 8;
+constexpr int kCellHeight = 14;
+
+} // namespace
+
+SyntheticClip::SyntheticClip(int width, int height, int framerate)
+    : m_width(width & ~1)
+    , m_height(height & ~1)
+    , m_intervalUs(1000000 / std::max(framerate, 1))
+    , m_startUs(std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count())
+    , m_seed(1)
+    , m_caretColumn(0)
+    , m_caretRow(0)
+    , m_cursorX(0)
+    , m_cursorY(0) {
+    // Window covering the middle of the screen, text area inset by a margin
+    m_window = {m_width / 8, m_height / 10, m_width * 3 / 4, m_height * 3 / 4};
+    m_text = {m_window.x + 16, m_window.y + 40,
+              (m_window.width - 32) / kCellWidth * kCellWidth,
+              (m_window.height - 56) / kCellHeight * kCellHeight};
+}
+
+void SyntheticClip::render(int index, capture::Frame& frame) {
+    if (index == 0) {
+        frame.width = m_width;
+        frame.height = m_height;
+        frame.stride = m_width * 4;
+        frame.pixelFormat = capture::PixelFormat::BGRA8;
+        frame.data.resize(static_cast<size_t>(frame.stride) * m_height);
+    }
+    frame.sequence = static_cast<uint64_t>(index) + 1;
+    frame.timestamp = m_startUs + static_cast<uint64_t>(index) * m_intervalUs;
+    frame.identical = false;
+    frame.dirtyRects.clear();
+
+    if (index % kSceneLength == 0) {
+        drawScene(index / kSceneLength, frame);
+        return;
+    }
+
+    // Remove the cursor first so scrolling never moves it
+    toggleCursor(frame);
+
+    if (index % 8 == 0) {
+        scrollText(frame);
+    } else {
+        typeGlyphs(frame, 3);
+    }
+
+    m_cursorX = (m_cursorX + 23) % std::max(m_width - 16, 1);
+    m_cursorY = (m_cursorY + 11) % std::max(m_height - 16, 1);
+    toggleCursor(frame);
+}
+
+uint32_t SyntheticClip::random() {
+    m_seed = m_seed * 1664525u + 1013904223u;
+    return m_seed;
+}
+
+uint8_t* SyntheticClip::pixel(capture::Frame& frame, int x, int y) {
+    return frame.data.data() + static_cast<size_t>(y) * frame.stride + x * 4;
+}
+
+void SyntheticClip::fillRect(capture::Frame& frame, const capture::Rect& rect, uint32_t color) {
+    int right = std::min(rect.x + rect.width, m_width);
+    int bottom = std::min(rect.y + rect.height, m_height);
+    for (int y = rect.y; y < bottom; ++y) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(pixel(frame, rect.x, y));
+        std::fill(row, row + std::max(right - rect.x, 0), color);
+    }
+}
+
+void SyntheticClip::drawScene(int scene, capture::Frame& frame) {
+    static const uint32_t kDesktops[] = {0xFF2D5F8Bu, 0xFF3C3C3Cu, 0xFF6B8E23u, 0xFF8B4513u};
+    fillRect(frame, {0, 0, m_width, m_height}, kDesktops[scene % 4]);
+    int taskbar = std::min(40, m_height / 4);
+    fillRect(frame, {0, m_height - taskbar, m_width, taskbar}, 0xFF202020u);
+    fillRect(frame, m_window, 0xFFFFFFFFu);
+    fillRect(frame, {m_window.x, m_window.y, m_window.width, 28}, 0xFFDDDDDDu);
+
+    // Start with a half-full page of text
+    m_caretColumn = 0;
+    m_caretRow = 0;
+    int cells = (m_text.width / kCellWidth) * (m_text.height / kCellHeight) / 2;
+    typeGlyphs(frame, cells);
+
+    m_cursorX = m_width / 2;
+    m_cursorY = m_height / 2;
+    toggleCursor(frame);
+
+    // Everything was redrawn: no regions means the whole frame
+    frame.dirtyRects.clear();
+}
+
+void SyntheticClip::typeGlyphs(capture::Frame& frame, int count) {
+    int columns = m_text.width / kCellWidth;
+    int rows = m_text.height / kCellHeight;
+    if (columns <= 0 || rows <= 0) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (m_caretColumn >= columns) {
+            m_caretColumn = 0;
+            if (++m_caretRow >= rows) {
+                scrollText(frame);
+                m_caretRow = rows - 1;
+            }
+        }
+
+        // Every sixth cell is a space, the rest a random 5x7 glyph
+        int x = m_text.x + m_caretColumn * kCellWidth;
+        int y = m_text.y + m_caretRow * kCellHeight;
+        uint32_t bits = random();
+        if (bits % 6 != 0) {
+            for (int gy = 0; gy < 7; ++gy) {
+                for (int gx = 0; gx < 5; ++gx) {
+                    if (bits & (1u << ((gy * 5 + gx) % 32))) {
+                        std::memset(pixel(frame, x + 1 + gx, y + 3 + gy), 0x10, 3);
+                    }
+                }
+            }
+        }
+        frame.dirtyRects.push_back({x, y, kCellWidth, kCellHeight});
+        m_caretColumn++;
+    }
+}
+
+void SyntheticClip::scrollText(capture::Frame& frame) {
+    if (m_text.width <= 0 || m_text.height < kCellHeight) {
+        return;
+    }
+    size_t rowBytes = static_cast<size_t>(m_text.width) * 4;
+    for (int y = m_text.y; y < m_text.y + m_text.height - kCellHeight; ++y) {
+        std::memcpy(pixel(frame, m_text.x, y), pixel(frame, m_text.x, y + kCellHeight), rowBytes);
+    }
+    fillRect(frame, {m_text.x, m_text.y + m_text.height - kCellHeight, m_text.width, kCellHeight}, 0xFFFFFFFFu);
+    frame.dirtyRects.push_back(m_text);
+}
+
+void SyntheticClip::toggleCursor(capture::Frame& frame) {
+    // XOR twice restores what was underneath
+    capture::Rect rect = {m_cursorX, m_cursorY, std::min(16, m_width - m_cursorX), std::min(16, m_height - m_cursorY)};
+    for (int y = rect.y; y < rect.y + rect.height; ++y) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(pixel(frame, rect.x, y));
+        for (int x = 0; x < std::min(rect.width, 16 - (y - rect.y)); ++x) {
+            row[x] ^= 0x00FFFFFFu;
+        }
+    }
+    frame.dirtyRects.push_back(rect);
+}
+
+} // namespace encoder
+} // namespace talos
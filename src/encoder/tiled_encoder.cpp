@@ -0,0 +1,556 @@
+#include "encoder/tiled_encoder.h"
+#include "core/logger.h"
+#include <algorithm>
+
+namespace talos {
+namespace encoder {
+
+namespace {
+
+// Same smoothing as the per-tile timings
+constexpr float kTimingSmoothing = 0.1f;
+
+// Tile edges fall on macroblock boundaries
+constexpr int kTileAlign = 16;
+
+float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief One prepared picture per tile, all for the same frame
+ */
+struct TiledPreparedFrame : PreparedFrame {
+    std::vector<PreparedFramePtr> tiles;
+    uint64_t generation = 0;    // Tile set it was prepared for
+};
+
+// Edges of count equal parts of length, inner ones aligned
+std::vector<int> splitEdges(int length, int count) {
+    std::vector<int> edges(count + 1);
+    for (int i = 0; i < count; ++i) {
+        int64_t edge = static_cast<int64_t>(length) * i / count;
+        edges[i] = static_cast<int>((edge + kTileAlign / 2) / kTileAlign * kTileAlign);
+    }
+    edges[count] = length & ~1;
+    return edges;
+}
+
+} // namespace
+
+TiledEncoder::TiledEncoder()
+    : m_generation(0)
+    , m_keyframeRequested(false)
+    , m_initialized(false)
+    , m_keyframeRequests(0)
+    , m_requestedKeyframes(0)
+    , m_encodeMs(0.0f) {
+}
+
+TiledEncoder::~TiledEncoder() {
+    shutdown();
+}
+
+std::vector<capture::Rect> TiledEncoder::layoutTiles(int width, int height, int columns, int rows) {
+    std::vector<capture::Rect> rects;
+    if (columns < 1 || rows < 1) {
+        return rects;
+    }
+
+    std::vector<int> xs = splitEdges(width, columns);
+    std::vector<int> ys = splitEdges(height, rows);
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            capture::Rect rect = {xs[column], ys[row], xs[column + 1] - xs[column], ys[row + 1] - ys[row]};
+            if (rect.width < kTileAlign || rect.height < kTileAlign) {
+                return {};
+            }
+            rects.push_back(rect);
+        }
+    }
+    return rects;
+}
+
+bool TiledEncoder::initialize(const EncoderConfig& config) {
+    if (m_initialized) {
+        Logger::getInstance().log(LogLevel::Warning, "Tiled encoder already initialized");
+        return true;
+    }
+
+    std::vector<capture::Rect> rects = layoutTiles(config.width, config.height, config.tileColumns, config.tileRows);
+    if (rects.empty()) {
+        Logger::getInstance().log(LogLevel::Error,
+            "Cannot split " + std::to_string(config.width) + "x" + std::to_string(config.height) + " into " +
+            std::to_string(config.tileColumns) + "x" + std::to_string(config.tileRows) + " tiles");
+        return false;
+    }
+
+    if (!createTiles(config, rects)) {
+        return false;
+    }
+
+    // One thread per tile, the caller included
+    m_preparePool = std::make_unique<ThreadPool>(rects.size() - 1);
+    m_encodePool = std::make_unique<ThreadPool>(rects.size() - 1);
+
+    m_config = config;
+    m_keyframeRequested.store(false, std::memory_order_relaxed);
+    m_initialized = true;
+
+    Logger::getInstance().log(LogLevel::Info,
+        "Tiled encoder initialized: " + std::to_string(config.tileColumns) + "x" + std::to_string(config.tileRows) +
+        " tiles of about " + std::to_string(rects[0].width) + "x" + std::to_string(rects[0].height));
+    return true;
+}
+
+EncoderConfig TiledEncoder::tileConfig(const EncoderConfig& config, const capture::Rect& rect, int streamId) const {
+    EncoderConfig tile = config;
+    tile.width = rect.width;
+    tile.height = rect.height;
+    tile.tileColumns = 1;
+    tile.tileRows = 1;
+    tile.streamId = streamId;
+
+    // Bits follow area
+    int64_t tileArea = static_cast<int64_t>(rect.width) * rect.height;
+    int64_t frameArea = std::max<int64_t>(static_cast<int64_t>(config.width) * config.height, 1);
+    tile.bitrate = static_cast<int>(static_cast<int64_t>(config.bitrate) * tileArea / frameArea);
+
+    // Keyframes only where every tile has one
+    tile.sceneCut = false;
+    tile.keyframeRequestIntervalMs = 0;
+
+    // The tiles are the parallelism; share the cores between them
+    int tiles = std::max(config.tileColumns * config.tileRows, 1);
+    int threads = config.threadCount > 0 ? config.threadCount : static_cast<int>(ThreadPool::hardwareConcurrency());
+    tile.threadCount = std::max(threads / tiles, 1);
+    tile.conversionBands = 1;
+
+    // Focus regions in tile coordinates
+    tile.focusRegions.clear();
+    for (const auto& focus : config.focusRegions) {
+        int left = std::max(focus.x, rect.x);
+        int top = std::max(focus.y, rect.y);
+        int right = std::min(focus.x + focus.width, rect.x + rect.width);
+        int bottom = std::min(focus.y + focus.height, rect.y + rect.height);
+        if (left < right && top < bottom) {
+            RoiRegion region = focus;
+            region.x = left - rect.x;
+            region.y = top - rect.y;
+            region.width = right - left;
+            region.height = bottom - top;
+            tile.focusRegions.push_back(region);
+        }
+    }
+    return tile;
+}
+
+bool TiledEncoder::createTiles(const EncoderConfig& config, const std::vector<capture::Rect>& rects) {
+    std::vector<std::unique_ptr<VideoEncoder>> tiles;
+    for (size_t i = 0; i < rects.size(); ++i) {
+        auto tile = VideoEncoder::create("ffmpeg");
+        if (!tile || !tile->initialize(tileConfig(config, rects[i], static_cast<int>(i)))) {
+            Logger::getInstance().log(LogLevel::Error, "Failed to initialize tile encoder " + std::to_string(i));
+            return false;
+        }
+        tiles.push_back(std::move(tile));
+    }
+
+    std::lock_guard<std::mutex> lock(m_tilesMutex);
+    m_tiles = std::move(tiles);
+    m_rects = rects;
+    m_views.clear();
+    for (size_t i = 0; i < rects.size(); ++i) {
+        m_views.push_back(std::make_unique<capture::Frame>());
+    }
+    return true;
+}
+
+void TiledEncoder::destroyTiles() {
+    std::lock_guard<std::mutex> lock(m_tilesMutex);
+    m_tiles.clear();
+    m_rects.clear();
+    m_views.clear();
+}
+
+void TiledEncoder::flushTiles() {
+    for (auto& tile : m_tiles) {
+        tile->shutdown();
+    }
+    collectPackets();
+}
+
+void TiledEncoder::shutdown() {
+    if (!m_initialized) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+
+    // Tiles stay around so their statistics can still be read
+    flushTiles();
+    m_preparePool.reset();
+    m_encodePool.reset();
+    m_initialized = false;
+
+    Logger::getInstance().log(LogLevel::Info, "Tiled encoder shut down");
+}
+
+ReconfigureResult TiledEncoder::reconfigure(const EncoderConfig& config) {
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+
+    ReconfigureResult result;
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return result;
+    }
+
+    std::vector<capture::Rect> rects = layoutTiles(config.width, config.height, config.tileColumns, config.tileRows);
+    if (rects.empty()) {
+        Logger::getInstance().log(LogLevel::Error, "Invalid tile layout, keeping the current configuration");
+        return result;
+    }
+
+    bool layoutChanged = rects.size() != m_rects.size() ||
+        !std::equal(rects.begin(), rects.end(), m_rects.begin(), [](const capture::Rect& a, const capture::Rect& b) {
+            return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+        });
+
+    if (layoutChanged) {
+        // New streams: flush the old tiles, then start over with an IDR everywhere
+        EncoderConfig previous = m_config;
+        std::vector<capture::Rect> previousRects = m_rects;
+        flushTiles();
+        destroyTiles();
+        if (!createTiles(config, rects)) {
+            Logger::getInstance().log(LogLevel::Error, "Reconfiguration failed, restoring previous tiles");
+            if (!createTiles(previous, previousRects)) {
+                Logger::getInstance().log(LogLevel::Error, "Failed to restore tiled encoder");
+                m_initialized = false;
+            }
+            m_generation++;
+            return result;
+        }
+        m_preparePool = std::make_unique<ThreadPool>(rects.size() - 1);
+        m_encodePool = std::make_unique<ThreadPool>(rects.size() - 1);
+        result.codecRebuilt = true;
+        result.keyframeForced = true;
+        m_generation++;
+    } else {
+        bool failed = false;
+        for (size_t i = 0; i < m_tiles.size(); ++i) {
+            ReconfigureResult tileResult = m_tiles[i]->reconfigure(tileConfig(config, rects[i], static_cast<int>(i)));
+            failed = failed || !tileResult.success;
+            result.keyframeForced = result.keyframeForced || tileResult.keyframeForced;
+            result.codecRebuilt = result.codecRebuilt || tileResult.codecRebuilt;
+        }
+
+        if (failed) {
+            // Put every tile back on the same settings
+            Logger::getInstance().log(LogLevel::Error, "Tile reconfiguration failed, restoring previous settings");
+            for (size_t i = 0; i < m_tiles.size(); ++i) {
+                m_tiles[i]->reconfigure(tileConfig(m_config, m_rects[i], static_cast<int>(i)));
+            }
+            result = ReconfigureResult();
+            result.keyframeForced = true;
+        }
+
+        // A tile that drops a stale prepared frame must not be the only one
+        if (result.codecRebuilt) {
+            m_generation++;
+        }
+
+        // Tiles that kept their codec follow the rebuilt ones with an IDR on the same frame
+        if (result.keyframeForced) {
+            for (auto& tile : m_tiles) {
+                tile->requestKeyframe();
+            }
+        }
+
+        if (failed) {
+            return result;
+        }
+    }
+
+    m_config = config;
+    result.success = true;
+    Logger::getInstance().log(LogLevel::Info,
+        "Tiled encoder reconfigured: " + std::to_string(config.tileColumns) + "x" +
+        std::to_string(config.tileRows) + " tiles" + (layoutChanged ? " (tiles rebuilt)" : ""));
+    return result;
+}
+
+bool TiledEncoder::encodeFrame(const capture::Frame& frame) {
+    PreparedFramePtr prepared;
+    if (!prepareFrame(frame, prepared)) {
+        return false;
+    }
+    return !prepared || encodePreparedFrame(prepared);
+}
+
+void TiledEncoder::makeView(const capture::Frame& frame, size_t tile) {
+    // Tiles are laid out for the configured size; follow the capture if it differs
+    const capture::Rect& rect = m_rects[tile];
+    int left = static_cast<int>(static_cast<int64_t>(rect.x) * frame.width / m_config.width);
+    int top = static_cast<int>(static_cast<int64_t>(rect.y) * frame.height / m_config.height);
+    int right = static_cast<int>(static_cast<int64_t>(rect.x + rect.width) * frame.width / m_config.width);
+    int bottom = static_cast<int>(static_cast<int64_t>(rect.y + rect.height) * frame.height / m_config.height);
+
+    capture::Frame& view = *m_views[tile];
+    view.width = right - left;
+    view.height = bottom - top;
+    view.stride = frame.stride;
+    view.pixelFormat = frame.pixelFormat;
+    view.timestamp = frame.timestamp;
+    view.sequence = frame.sequence;
+    view.identical = frame.identical;
+    view.borrow(frame.pixels() + static_cast<size_t>(top) * frame.stride + static_cast<size_t>(left) * 4, nullptr);
+
+    view.dirtyRects.clear();
+    for (const auto& dirty : frame.dirtyRects) {
+        int x0 = std::max(dirty.x, left);
+        int y0 = std::max(dirty.y, top);
+        int x1 = std::min(dirty.x + dirty.width, right);
+        int y1 = std::min(dirty.y + dirty.height, bottom);
+        if (x0 < x1 && y0 < y1) {
+            view.dirtyRects.push_back({x0 - left, y0 - top, x1 - x0, y1 - y0});
+        }
+    }
+
+    // Nothing changed in this tile, but it must not be skipped on its own:
+    // an empty rectangle means "changed, with nothing to convert"
+    if (view.dirtyRects.empty() && !frame.dirtyRects.empty() && !frame.identical) {
+        view.dirtyRects.push_back({0, 0, 0, 0});
+    }
+}
+
+bool TiledEncoder::prepareFrame(const capture::Frame& frame, PreparedFramePtr& prepared) {
+    prepared.reset();
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+
+    // Views are plain pointer offsets, which needs packed 32-bit pixels
+    if (frame.pixelFormat != capture::PixelFormat::BGRA8 && frame.pixelFormat != capture::PixelFormat::RGBA8) {
+        Logger::getInstance().log(LogLevel::Error, "Tiled encoding needs BGRA or RGBA frames");
+        return false;
+    }
+
+    for (size_t i = 0; i < m_tiles.size(); ++i) {
+        makeView(frame, i);
+    }
+
+    auto result = std::make_shared<TiledPreparedFrame>();
+    result->tiles.resize(m_tiles.size());
+    std::vector<char> ok(m_tiles.size(), 0);
+    m_preparePool->parallelFor(m_tiles.size(), [&](size_t i) {
+        ok[i] = m_tiles[i]->prepareFrame(*m_views[i], result->tiles[i]);
+    });
+
+    // The views borrow the caller's frame only for this call
+    for (auto& view : m_views) {
+        view->release();
+    }
+
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        Logger::getInstance().log(LogLevel::Error, "Failed to prepare tiles");
+        return false;
+    }
+
+    // Every tile sees the same frame, so they skip it together
+    auto first = std::find_if(result->tiles.begin(), result->tiles.end(),
+        [](const PreparedFramePtr& tile) { return tile != nullptr; });
+    if (first == result->tiles.end()) {
+        return true;
+    }
+
+    result->pts = (*first)->pts;
+    result->captureTimestamp = frame.timestamp;
+    result->generation = m_generation;
+    prepared = std::move(result);
+    return true;
+}
+
+bool TiledEncoder::prepareKeepAlive(uint64_t timestamp, PreparedFramePtr& prepared) {
+    prepared.reset();
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+
+    // Only tiles with something due repeat their picture; the others stay
+    // null, as when they skip a frame
+    auto result = std::make_shared<TiledPreparedFrame>();
+    result->tiles.resize(m_tiles.size());
+    for (size_t i = 0; i < m_tiles.size(); ++i) {
+        if (!m_tiles[i]->prepareKeepAlive(timestamp, result->tiles[i])) {
+            Logger::getInstance().log(LogLevel::Error, "Failed to prepare tiles");
+            return false;
+        }
+    }
+
+    auto first = std::find_if(result->tiles.begin(), result->tiles.end(),
+        [](const PreparedFramePtr& tile) { return tile != nullptr; });
+    if (first == result->tiles.end()) {
+        return true;
+    }
+
+    result->pts = (*first)->pts;
+    result->captureTimestamp = timestamp;
+    result->generation = m_generation;
+    prepared = std::move(result);
+    return true;
+}
+
+uint64_t TiledEncoder::pendingChangesDue() {
+    std::lock_guard<std::mutex> prepareLock(m_prepareMutex);
+
+    // The earliest tile decides
+    uint64_t due = 0;
+    for (const auto& tile : m_tiles) {
+        uint64_t tileDue = tile->pendingChangesDue();
+        if (tileDue != 0 && (due == 0 || tileDue < due)) {
+            due = tileDue;
+        }
+    }
+    return due;
+}
+
+bool TiledEncoder::encodePreparedFrame(const PreparedFramePtr& prepared) {
+    std::lock_guard<std::mutex> encodeLock(m_encodeMutex);
+
+    if (!m_initialized) {
+        Logger::getInstance().log(LogLevel::Error, "Encoder not initialized");
+        return false;
+    }
+
+    auto* picture = dynamic_cast<TiledPreparedFrame*>(prepared.get());
+    if (!picture) {
+        Logger::getInstance().log(LogLevel::Error, "Prepared frame does not belong to this encoder");
+        return false;
+    }
+
+    // Prepared for tiles reconfigure() has since replaced
+    if (picture->generation != m_generation) {
+        return true;
+    }
+
+    // Handed to every tile before any of them encodes, so all of them
+    // make this frame the keyframe
+    if (m_keyframeRequested.load(std::memory_order_acquire)) {
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::chrono::milliseconds(std::max(m_config.keyframeRequestIntervalMs, 0));
+        if (now - m_lastRequestedKeyframe >= interval) {
+            m_keyframeRequested.store(false, std::memory_order_relaxed);
+            m_lastRequestedKeyframe = now;
+            for (auto& tile : m_tiles) {
+                tile->requestKeyframe();
+            }
+
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_requestedKeyframes++;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> ok(m_tiles.size(), 1);
+    m_encodePool->parallelFor(m_tiles.size(), [&](size_t i) {
+        if (picture->tiles[i]) {
+            ok[i] = m_tiles[i]->encodePreparedFrame(picture->tiles[i]);
+        }
+    });
+    float encodeMs = elapsedMs(start);
+
+    collectPackets();
+
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_encodeMs = m_encodeMs == 0.0f ? encodeMs : m_encodeMs + kTimingSmoothing * (encodeMs - m_encodeMs);
+    }
+
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        Logger::getInstance().log(LogLevel::Error, "Failed to encode tiles");
+        return false;
+    }
+    return true;
+}
+
+void TiledEncoder::collectPackets() {
+    EncodedPacketPtr packet;
+    std::lock_guard<std::mutex> lock(m_packetMutex);
+    for (auto& tile : m_tiles) {
+        while (tile->getEncodedPacket(packet)) {
+            m_packetQueue.push_back(std::move(packet));
+        }
+    }
+}
+
+void TiledEncoder::requestKeyframe() {
+    m_keyframeRequested.store(true, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_keyframeRequests++;
+}
+
+bool TiledEncoder::getEncodedPacket(EncodedPacketPtr& packet) {
+    std::lock_guard<std::mutex> lock(m_packetMutex);
+
+    if (m_packetQueue.empty()) {
+        return false;
+    }
+
+    packet = std::move(m_packetQueue.front());
+    m_packetQueue.pop_front();
+    return true;
+}
+
+EncoderStats TiledEncoder::getStats() const {
+    EncoderStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_tilesMutex);
+        for (size_t i = 0; i < m_tiles.size(); ++i) {
+            EncoderStats tile = m_tiles[i]->getStats();
+            if (i == 0) {
+                stats = tile;
+                stats.conversionBandMs.clear();
+            } else {
+                stats.bytesEncoded += tile.bytesEncoded;
+                stats.packetsGenerated += tile.packetsGenerated;
+                stats.currentBitrate += tile.currentBitrate;
+                stats.fullConversions += tile.fullConversions;
+                stats.partialConversions += tile.partialConversions;
+                stats.averageFps = std::min(stats.averageFps, tile.averageFps);
+                stats.latencyMs = std::max(stats.latencyMs, tile.latencyMs);
+                stats.maxLatencyMs = std::max(stats.maxLatencyMs, tile.maxLatencyMs);
+                stats.conversionMs = std::max(stats.conversionMs, tile.conversionMs);
+            }
+            stats.conversionBandMs.push_back(tile.conversionMs);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    stats.keyframeRequests = m_keyframeRequests;
+    stats.requestedKeyframes = m_requestedKeyframes;
+    stats.encodeMs = m_encodeMs;
+    return stats;
+}
+
+std::vector<TileInfo> TiledEncoder::getTiles() const {
+    std::lock_guard<std::mutex> lock(m_tilesMutex);
+
+    std::vector<TileInfo> tiles;
+    for (size_t i = 0; i < m_rects.size(); ++i) {
+        tiles.push_back({static_cast<int>(i), m_rects[i]});
+    }
+    return tiles;
+}
+
+} // namespace encoder
+} // namespace talos
@@ -1,5 +1,7 @@
 #include "encoder/video_encoder.h"
 #include "encoder/ffmpeg_encoder.h"
+#include "encoder/tiled_encoder.h"
+#include "encoder/rendition_ladder.h"
 #include "core/logger.h"
 #include <memory>
 
@@ -11,6 +13,12 @@ std::unique_ptr<VideoEncoder> VideoEncoder::create(const std::string& type) {
     if (type == "ffmpeg" || type.empty()) {
         return std::make_unique<encoder::FFmpegEncoder>();
     }
+    if (type == "tiled") {
+        return std::make_unique<encoder::TiledEncoder>();
+    }
+    if (type == "ladder") {
+        return std::make_unique<encoder::RenditionLadder>();
+    }
 #endif
     
     Logger::getInstance().log(LogLevel::Error, "No encoder available for type: " + type);
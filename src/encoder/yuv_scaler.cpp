@@ -0,0 +1,187 @@
+#include "encoder/yuv_scaler.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TALOS_YUV_SCALER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define TALOS_YUV_SCALER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace talos {
+namespace encoder {
+
+namespace {
+
+/**
+ * @brief Source position of output sample i in 16.16 fixed point, with
+ *        the first and last samples of both sizes centred on each other
+ */
+int64_t sourcePosition(int i, int srcSize, int dstSize) {
+    int64_t position = ((2 * static_cast<int64_t>(i) + 1) * srcSize << 16) / (2 * static_cast<int64_t>(dstSize));
+    return std::max<int64_t>(position - (1 << 15), 0);
+}
+
+/**
+ * @brief dst[x] = rounded average of the 2x2 block at (2x, 0) in rows r0 and r1
+ */
+void halveRow(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int width) {
+    int x = 0;
+#if defined(TALOS_YUV_SCALER_SSE2)
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i two = _mm_set1_epi16(2);
+    for (; x + 16 <= width; x += 16) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * x));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * x + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * x));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * x + 16));
+
+        // Even plus odd bytes of both rows, in 16-bit lanes
+        __m128i sum0 = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a0, lowBytes), _mm_srli_epi16(a0, 8)),
+                                     _mm_add_epi16(_mm_and_si128(b0, lowBytes), _mm_srli_epi16(b0, 8)));
+        __m128i sum1 = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a1, lowBytes), _mm_srli_epi16(a1, 8)),
+                                     _mm_add_epi16(_mm_and_si128(b1, lowBytes), _mm_srli_epi16(b1, 8)));
+        sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, two), 2);
+        sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(sum0, sum1));
+    }
+#elif defined(TALOS_YUV_SCALER_NEON)
+    for (; x + 16 <= width; x += 16) {
+        uint16x8_t sum0 = vpadalq_u8(vpaddlq_u8(vld1q_u8(r0 + 2 * x)), vld1q_u8(r1 + 2 * x));
+        uint16x8_t sum1 = vpadalq_u8(vpaddlq_u8(vld1q_u8(r0 + 2 * x + 16)), vld1q_u8(r1 + 2 * x + 16));
+        vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(sum0, 2), vrshrn_n_u16(sum1, 2)));
+    }
+#endif
+    for (; x < width; ++x) {
+        dst[x] = static_cast<uint8_t>((r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+    }
+}
+
+/**
+ * @brief dst[x] = a[x] + (b[x] - a[x]) * weight / 256, rounded; weight 1..255
+ */
+void blendRows(const uint8_t* a, const uint8_t* b, int weight, uint8_t* dst, int width) {
+    int x = 0;
+#if defined(TALOS_YUV_SCALER_SSE2)
+    // a * (256 - w) + b * w stays below 65536, so 16-bit lanes suffice
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weightA = _mm_set1_epi16(static_cast<int16_t>(256 - weight));
+    const __m128i weightB = _mm_set1_epi16(static_cast<int16_t>(weight));
+    const __m128i half = _mm_set1_epi16(128);
+    for (; x + 16 <= width; x += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+        __m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), weightA),
+                                    _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), weightB));
+        __m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), weightA),
+                                     _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), weightB));
+        low = _mm_srli_epi16(_mm_add_epi16(low, half), 8);
+        high = _mm_srli_epi16(_mm_add_epi16(high, half), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(low, high));
+    }
+#elif defined(TALOS_YUV_SCALER_NEON)
+    const uint8x8_t weightA = vdup_n_u8(static_cast<uint8_t>(256 - weight));
+    const uint8x8_t weightB = vdup_n_u8(static_cast<uint8_t>(weight));
+    for (; x + 16 <= width; x += 16) {
+        uint8x16_t va = vld1q_u8(a + x);
+        uint8x16_t vb = vld1q_u8(b + x);
+        uint16x8_t low = vmlal_u8(vmull_u8(vget_low_u8(va), weightA), vget_low_u8(vb), weightB);
+        uint16x8_t high = vmlal_u8(vmull_u8(vget_high_u8(va), weightA), vget_high_u8(vb), weightB);
+        vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(low, 8), vrshrn_n_u16(high, 8)));
+    }
+#endif
+    for (; x < width; ++x) {
+        dst[x] = static_cast<uint8_t>((a[x] * (256 - weight) + b[x] * weight + 128) >> 8);
+    }
+}
+
+} // namespace
+
+const char* YuvScaler::kernelName() {
+#if defined(TALOS_YUV_SCALER_SSE2)
+    return "sse2";
+#elif defined(TALOS_YUV_SCALER_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+bool YuvScaler::scale(const PlanarImage& src, const PlanarImage& dst) {
+    if (src.width <= 0 || src.height <= 0 || dst.width <= 0 || dst.height <= 0 ||
+        dst.width > src.width || dst.height > src.height) {
+        return false;
+    }
+
+    for (int plane = 0; plane < 3; ++plane) {
+        int srcWidth = plane == 0 ? src.width : (src.width + 1) / 2;
+        int srcHeight = plane == 0 ? src.height : (src.height + 1) / 2;
+        int dstWidth = plane == 0 ? dst.width : (dst.width + 1) / 2;
+        int dstHeight = plane == 0 ? dst.height : (dst.height + 1) / 2;
+        scalePlane(src.data[plane], src.linesize[plane], srcWidth, srcHeight,
+                   dst.data[plane], dst.linesize[plane], dstWidth, dstHeight);
+    }
+    return true;
+}
+
+void YuvScaler::scalePlane(const uint8_t* src, int srcStride, int srcWidth, int srcHeight,
+                           uint8_t* dst, int dstStride, int dstWidth, int dstHeight) {
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        for (int y = 0; y < dstHeight; ++y) {
+            std::memcpy(dst + static_cast<size_t>(y) * dstStride, src + static_cast<size_t>(y) * srcStride, dstWidth);
+        }
+        return;
+    }
+
+    if (srcWidth == 2 * dstWidth && srcHeight == 2 * dstHeight) {
+        for (int y = 0; y < dstHeight; ++y) {
+            const uint8_t* row = src + static_cast<size_t>(2 * y) * srcStride;
+            halveRow(row, row + srcStride, dst + static_cast<size_t>(y) * dstStride, dstWidth);
+        }
+        return;
+    }
+
+    // Horizontal taps, shared by every row of the plane
+    m_columns.resize(dstWidth);
+    m_columnWeights.resize(dstWidth);
+    for (int x = 0; x < dstWidth; ++x) {
+        int64_t position = sourcePosition(x, srcWidth, dstWidth);
+        int column = static_cast<int>(position >> 16);
+        int weight = static_cast<int>((position >> 8) & 0xFF);
+        if (column >= srcWidth - 1) {
+            column = srcWidth - 1;
+            weight = 0;
+        }
+        m_columns[x] = column;
+        m_columnWeights[x] = static_cast<uint8_t>(weight);
+    }
+
+    // One spare byte so the right tap of the last column stays in bounds
+    m_row.resize(static_cast<size_t>(srcWidth) + 1);
+
+    for (int y = 0; y < dstHeight; ++y) {
+        int64_t position = sourcePosition(y, srcHeight, dstHeight);
+        int line = static_cast<int>(position >> 16);
+        int weight = static_cast<int>((position >> 8) & 0xFF);
+        const uint8_t* top = src + static_cast<size_t>(std::min(line, srcHeight - 1)) * srcStride;
+        if (line >= srcHeight - 1 || weight == 0) {
+            std::memcpy(m_row.data(), top, srcWidth);
+        } else {
+            blendRows(top, top + srcStride, weight, m_row.data(), srcWidth);
+        }
+        m_row[srcWidth] = m_row[srcWidth - 1];
+
+        uint8_t* out = dst + static_cast<size_t>(y) * dstStride;
+        for (int x = 0; x < dstWidth; ++x) {
+            int left = m_row[m_columns[x]];
+            int right = m_row[m_columns[x] + 1];
+            int w = m_columnWeights[x];
+            out[x] = static_cast<uint8_t>((left * (256 - w) + right * w + 128) >> 8);
+        }
+    }
+}
+
+} // namespace encoder
+} // namespace talos
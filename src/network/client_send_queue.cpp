@@ -0,0 +1,200 @@
+#include "network/client_send_queue.h"
+#include "core/logger.h"
+#include <algorithm>
+
+namespace talos {
+namespace network {
+
+ClientSendQueue::ClientSendQueue(const SendQueueConfig& config)
+    : m_config(config)
+    , m_bytes(0)
+    , m_shedding(false)
+    , m_keyframeRequested(false)
+    , m_closed(false) {
+    m_config.lowWatermarkBytes = std::min(m_config.lowWatermarkBytes, m_config.highWatermarkBytes);
+    m_config.maxPackets = std::max<size_t>(m_config.maxPackets, 1);
+}
+
+void ClientSendQueue::setKeyframeRequestHandler(std::function<void()> handler) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_keyframeRequestHandler = std::move(handler);
+}
+
+bool ClientSendQueue::overHigh(size_t incoming) const {
+    return m_bytes + incoming > m_config.highWatermarkBytes || m_queue.size() + 1 > m_config.maxPackets;
+}
+
+void ClientSendQueue::dropDisposable() {
+    for (const auto& packet : m_queue) {
+        if (packet->disposable) {
+            m_bytes -= packet->size;
+            m_stats.disposableDropped++;
+        }
+    }
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                                 [](const encoder::EncodedPacketPtr& packet) { return packet->disposable; }),
+                  m_queue.end());
+}
+
+void ClientSendQueue::dropToKeyframe() {
+    m_stats.gopDropped += m_queue.size();
+    m_stats.keyframeSkips++;
+    m_queue.clear();
+    m_bytes = 0;
+    m_synced.clear();
+}
+
+bool ClientSendQueue::push(const encoder::EncodedPacketPtr& packet) {
+    if (!packet) {
+        return false;
+    }
+
+    bool accepted = false;
+    bool skipped = false;
+    bool needKeyframe = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) {
+            return false;
+        }
+
+        int stream = packet->streamId;
+        if (m_shedding && m_bytes <= m_config.lowWatermarkBytes) {
+            m_shedding = false;
+        }
+
+        if (m_synced.count(stream) == 0 && !packet->keyframe) {
+            // Still waiting for this stream's keyframe
+            m_stats.gopDropped++;
+        } else if (overHigh(packet->size)) {
+            // Step 1: frames nothing depends on
+            m_shedding = true;
+            dropDisposable();
+            if (packet->disposable) {
+                m_stats.disposableDropped++;
+            } else if (!overHigh(packet->size)) {
+                accepted = true;
+            } else {
+                // Step 2: restart every stream at its next keyframe
+                bool othersWaiting = std::any_of(m_synced.begin(), m_synced.end(),
+                                                 [stream](int synced) { return synced != stream; });
+                dropToKeyframe();
+                skipped = true;
+                if (packet->keyframe) {
+                    accepted = true;
+                } else {
+                    m_stats.gopDropped++;
+                }
+                if ((!packet->keyframe || othersWaiting) && !m_keyframeRequested) {
+                    m_keyframeRequested = true;
+                    needKeyframe = true;
+                }
+            }
+        } else if (m_shedding && packet->disposable) {
+            m_stats.disposableDropped++;
+        } else {
+            accepted = true;
+        }
+
+        if (accepted) {
+            if (packet->keyframe) {
+                m_synced.insert(stream);
+                m_keyframeRequested = false;
+            }
+            m_queue.push_back(packet);
+            m_bytes += packet->size;
+            m_stats.packetsQueued++;
+            m_stats.peakBytes = std::max(m_stats.peakBytes, m_bytes);
+        }
+    }
+
+    if (accepted) {
+        m_queued.notify();
+    }
+    if (skipped) {
+        Logger::instance().warn("Client send queue overflowed, skipping to the next keyframe");
+    }
+    if (needKeyframe) {
+        requestKeyframe();
+    }
+    return accepted;
+}
+
+size_t ClientSendQueue::take(std::vector<encoder::EncodedPacketPtr>& packets, size_t maxPackets) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = std::min(maxPackets, m_queue.size());
+    for (size_t i = 0; i < count; ++i) {
+        m_bytes -= m_queue.front()->size;
+        packets.push_back(std::move(m_queue.front()));
+        m_queue.pop_front();
+    }
+    m_stats.packetsSent += count;
+
+    if (m_shedding && m_bytes <= m_config.lowWatermarkBytes) {
+        m_shedding = false;
+    }
+    return count;
+}
+
+bool ClientSendQueue::waitForPackets(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        uint32_t epoch = m_queued.prepareWait();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed) {
+                m_queued.cancelWait();
+                return false;
+            }
+            if (!m_queue.empty()) {
+                m_queued.cancelWait();
+                return true;
+            }
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            m_queued.cancelWait();
+            return false;
+        }
+        if (!m_queued.wait(epoch, remaining)) {
+            return false;
+        }
+    }
+}
+
+void ClientSendQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_queue.clear();
+        m_bytes = 0;
+    }
+    m_queued.notify();
+}
+
+void ClientSendQueue::requestKeyframe() {
+    std::function<void()> handler;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        handler = m_keyframeRequestHandler;
+        m_stats.keyframeRequests++;
+    }
+
+    // Outside the lock: the encoder may take its own
+    if (handler) {
+        handler();
+    }
+}
+
+SendQueueStats ClientSendQueue::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SendQueueStats stats = m_stats;
+    stats.queuedPackets = m_queue.size();
+    stats.queuedBytes = m_bytes;
+    return stats;
+}
+
+} // namespace network
+} // namespace talos
@@ -0,0 +1,235 @@
+#include "network/packet_fanout.h"
+#include "core/logger.h"
+#include <algorithm>
+
+namespace talos {
+namespace network {
+
+PacketFanout::PacketFanout(size_t capacity)
+    : m_ring(std::max<size_t>(capacity, 1))
+    , m_head(0)
+    , m_gopOverflowReported(false)
+    , m_nextClient(1)
+    , m_closed(false) {
+}
+
+void PacketFanout::setKeyframeRequestHandler(std::function<void()> handler) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_keyframeRequestHandler = std::move(handler);
+}
+
+void PacketFanout::publish(const encoder::EncodedPacketPtr& packet) {
+    if (!packet) {
+        return;
+    }
+
+    bool gopOverflow = false;
+    {
+        // The slot's previous packet is released here once no cursor needs it
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (packet->keyframe) {
+            auto previous = m_lastKeyframe.find(packet->streamId);
+            if (previous != m_lastKeyframe.end() && m_head - previous->second > m_ring.size() &&
+                !m_gopOverflowReported) {
+                m_gopOverflowReported = true;
+                gopOverflow = true;
+            }
+            m_lastKeyframe[packet->streamId] = m_head;
+        }
+        m_ring[m_head % m_ring.size()] = packet;
+        m_head++;
+        m_stats.packetsPublished++;
+    }
+    m_published.notify();
+
+    if (gopOverflow) {
+        Logger::instance().warn("GOP longer than the fan-out ring of " + std::to_string(m_ring.size()) +
+                                " packets; joining clients will wait for keyframes");
+    }
+}
+
+PacketFanout::ClientId PacketFanout::addClient(int streamId, JoinMode mode) {
+    ClientId id;
+    bool primed = false;
+    uint64_t backlog = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        id = m_nextClient++;
+        Client& client = m_clients[id];
+        client.cursor = m_head;
+        client.streamId = streamId;
+        if (mode == JoinMode::Burst && primeFromCache(client)) {
+            primed = true;
+            backlog = m_head - client.cursor;
+            client.stats.primedPackets = backlog;
+            m_stats.primedJoins++;
+        }
+        m_stats.clients = m_clients.size();
+    }
+
+    if (primed) {
+        Logger::instance().info("Fan-out client " + std::to_string(id) + " added, primed with " +
+                                std::to_string(backlog) + " cached packets");
+    } else {
+        Logger::instance().info("Fan-out client " + std::to_string(id) + " added, waiting for a keyframe");
+        requestKeyframe();
+    }
+    return id;
+}
+
+void PacketFanout::removeClient(ClientId client) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_clients.erase(client) == 0) {
+            return;
+        }
+        m_stats.clients = m_clients.size();
+    }
+    Logger::instance().info("Fan-out client " + std::to_string(client) + " removed");
+}
+
+bool PacketFanout::wants(const Client& client, const encoder::EncodedPacket& packet) const {
+    return client.streamId == kAllStreams || client.streamId == packet.streamId;
+}
+
+uint64_t PacketFanout::oldestSequence() const {
+    return m_head > m_ring.size() ? m_head - m_ring.size() : 0;
+}
+
+bool PacketFanout::primeFromCache(Client& client) {
+    // Start where every wanted stream has its newest keyframe behind the
+    // cursor; streams whose keyframe already left the ring join at their next
+    uint64_t oldest = oldestSequence();
+    uint64_t start = m_head;
+    bool found = false;
+    for (const auto& keyframe : m_lastKeyframe) {
+        if (keyframe.second < oldest ||
+            (client.streamId != kAllStreams && keyframe.first != client.streamId)) {
+            continue;
+        }
+        start = std::min(start, keyframe.second);
+        found = true;
+    }
+
+    client.synced.clear();
+    client.cursor = found ? start : m_head;
+    return found;
+}
+
+size_t PacketFanout::read(ClientId id, std::vector<encoder::EncodedPacketPtr>& packets, size_t maxPackets) {
+    size_t count = 0;
+    bool needKeyframe = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_clients.find(id);
+        if (it == m_clients.end()) {
+            return 0;
+        }
+        Client& client = it->second;
+
+        // Overwritten before the client got to them: restart from the cache
+        if (client.cursor < oldestSequence()) {
+            uint64_t lost = client.cursor;
+            client.stats.overruns++;
+            m_stats.overruns++;
+            needKeyframe = !primeFromCache(client);
+            client.stats.packetsSkipped += client.cursor - lost;
+        }
+
+        while (client.cursor < m_head && count < maxPackets) {
+            const encoder::EncodedPacketPtr& packet = m_ring[client.cursor % m_ring.size()];
+            client.cursor++;
+            if (!wants(client, *packet)) {
+                continue;
+            }
+
+            // Decoding of each stream can only start at a keyframe
+            if (client.synced.count(packet->streamId) == 0) {
+                if (!packet->keyframe) {
+                    client.stats.packetsSkipped++;
+                    continue;
+                }
+                client.synced.insert(packet->streamId);
+            }
+
+            packets.push_back(packet);
+            count++;
+        }
+        client.stats.packetsRead += count;
+    }
+
+    if (needKeyframe) {
+        Logger::instance().warn("Fan-out client " + std::to_string(id) + " fell behind with no cached keyframe");
+        requestKeyframe();
+    }
+    return count;
+}
+
+bool PacketFanout::waitForPackets(ClientId id, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        uint32_t epoch = m_published.prepareWait();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_clients.find(id);
+            if (m_closed || it == m_clients.end()) {
+                m_published.cancelWait();
+                return false;
+            }
+            if (it->second.cursor < m_head) {
+                m_published.cancelWait();
+                return true;
+            }
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            m_published.cancelWait();
+            return false;
+        }
+        if (!m_published.wait(epoch, remaining)) {
+            return false;
+        }
+    }
+}
+
+void PacketFanout::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_published.notify();
+}
+
+void PacketFanout::requestKeyframe() {
+    std::function<void()> handler;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        handler = m_keyframeRequestHandler;
+        m_stats.keyframeRequests++;
+    }
+
+    // Outside the lock: the encoder may take its own
+    if (handler) {
+        handler();
+    }
+}
+
+FanoutStats PacketFanout::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+bool PacketFanout::getClientStats(ClientId id, FanoutClientStats& stats) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_clients.find(id);
+    if (it == m_clients.end()) {
+        return false;
+    }
+    stats = it->second.stats;
+    return true;
+}
+
+} // namespace network
+} // namespace talos
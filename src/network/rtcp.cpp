@@ -0,0 +1,71 @@
+#include "network/rtcp.h"
+
+namespace talos {
+namespace network {
+
+namespace {
+
+// RTCP packet types
+constexpr uint8_t kTypeFirLegacy = 192;  // RFC 2032
+constexpr uint8_t kTypePayloadFeedback = 206;
+
+// Payload-specific feedback formats
+constexpr uint8_t kFormatPli = 1;
+constexpr uint8_t kFormatFir = 4;
+
+constexpr size_t kHeaderSize = 4;
+constexpr size_t kFeedbackHeaderSize = 12;  // Header, sender SSRC, media SSRC
+constexpr size_t kFirEntrySize = 8;         // SSRC, sequence number, reserved
+
+uint32_t readU32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+} // namespace
+
+bool parseRtcpKeyframeRequest(const uint8_t* data, size_t size, uint32_t mediaSsrc,
+                              RtcpKeyframeRequest& request) {
+    request = RtcpKeyframeRequest();
+
+    size_t pos = 0;
+    while (pos + kHeaderSize <= size) {
+        const uint8_t* packet = data + pos;
+        uint8_t version = packet[0] >> 6;
+        uint8_t format = packet[0] & 0x1F;
+        uint8_t type = packet[1];
+        size_t length = (static_cast<size_t>((packet[2] << 8) | packet[3]) + 1) * 4;
+        if (version != 2 || pos + length > size) {
+            break;
+        }
+
+        if (type == kTypePayloadFeedback && length >= kFeedbackHeaderSize) {
+            uint32_t sender = readU32(packet + 4);
+            uint32_t media = readU32(packet + 8);
+
+            if (format == kFormatPli && media == mediaSsrc) {
+                request.pictureLoss = true;
+                request.senderSsrc = sender;
+            } else if (format == kFormatFir) {
+                // The media SSRC field is unused in FIR; the target is in each entry
+                for (size_t entry = kFeedbackHeaderSize; entry + kFirEntrySize <= length; entry += kFirEntrySize) {
+                    if (readU32(packet + entry) == mediaSsrc) {
+                        request.fullIntraRequest = true;
+                        request.senderSsrc = sender;
+                        request.firSequence = packet[entry + 4];
+                        break;
+                    }
+                }
+            }
+        } else if (type == kTypeFirLegacy && length >= 8 && readU32(packet + 4) == mediaSsrc) {
+            request.fullIntraRequest = true;
+        }
+
+        pos += length;
+    }
+
+    return request.any();
+}
+
+} // namespace network
+} // namespace talos
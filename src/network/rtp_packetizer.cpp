@@ -0,0 +1,267 @@
+#include "network/rtp_packetizer.h"
+#include "core/logger.h"
+#include <algorithm>
+
+namespace talos {
+namespace network {
+
+namespace {
+
+constexpr size_t kRtpHeaderSize = 12;
+constexpr size_t kAggregationSizeField = 2;
+
+// NAL unit types of the RTP payload formats
+constexpr uint8_t kH264StapA = 24;
+constexpr uint8_t kH264FuA = 28;
+constexpr uint8_t kH265Ap = 48;
+constexpr uint8_t kH265Fu = 49;
+
+constexpr uint8_t kFuStart = 0x80;
+constexpr uint8_t kFuEnd = 0x40;
+
+void writeU16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+void writeU32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+} // namespace
+
+RtpPacketizer::RtpPacketizer(const RtpPacketizerConfig& config)
+    : m_config(config)
+    , m_sequence(0) {
+    m_config.maxPacketSize = std::max<size_t>(m_config.maxPacketSize, kRtpHeaderSize + 16);
+}
+
+uint32_t RtpPacketizer::timestamp90kHz(const encoder::EncodedPacket& packet) {
+    if (packet.timeBaseDen <= 0) {
+        return 0;
+    }
+    // RTP timestamps wrap modulo 2^32
+    int64_t ticks = packet.pts * 90000 * packet.timeBaseNum / packet.timeBaseDen;
+    return static_cast<uint32_t>(ticks);
+}
+
+void RtpPacketizer::clear() {
+    m_scratch.clear();
+    m_layout.clear();
+    m_pieces.clear();
+    m_packets.clear();
+}
+
+void RtpPacketizer::release() {
+    clear();
+    m_packet.reset();
+}
+
+bool RtpPacketizer::packetize(const encoder::EncodedPacketPtr& packet, uint32_t timestamp) {
+    clear();
+    m_packet = packet;
+    if (!packet || packet->nalUnits.empty()) {
+        return true;
+    }
+
+    const std::vector<encoder::NalUnit>& units = packet->nalUnits;
+    const size_t payloadBudget = m_config.maxPacketSize - kRtpHeaderSize;
+    const size_t nalHeaderSize = m_config.hevc ? 2 : 1;
+
+    if (m_config.mode == RtpPacketization::SingleNal) {
+        for (const auto& unit : units) {
+            if (unit.size > payloadBudget) {
+                Logger::instance().error("NAL unit of " + std::to_string(unit.size) +
+                                         " bytes does not fit a packet in packetization-mode 0");
+                release();
+                return false;
+            }
+        }
+    }
+
+    size_t groupFirst = 0;
+    size_t groupCount = 0;
+    size_t groupBytes = nalHeaderSize;
+
+    auto flushGroup = [&]() {
+        if (groupCount == 1) {
+            emitSingle(packet->data + units[groupFirst].offset, units[groupFirst].size, timestamp);
+        } else if (groupCount > 1) {
+            emitAggregate(units, groupFirst, groupCount, packet->data, timestamp);
+        }
+        groupCount = 0;
+        groupBytes = nalHeaderSize;
+    };
+
+    for (size_t i = 0; i < units.size(); ++i) {
+        const encoder::NalUnit& unit = units[i];
+        if (unit.size < nalHeaderSize) {
+            continue;
+        }
+
+        if (m_config.mode == RtpPacketization::SingleNal) {
+            emitSingle(packet->data + unit.offset, unit.size, timestamp);
+            continue;
+        }
+
+        if (unit.size > payloadBudget) {
+            flushGroup();
+            emitFragments(packet->data + unit.offset, unit.size, timestamp);
+            continue;
+        }
+
+        // A unit that fits alone is packed with its neighbours while the aggregate still fits
+        size_t added = kAggregationSizeField + unit.size;
+        if (groupCount > 0 && (!m_config.aggregate || groupBytes + added > payloadBudget)) {
+            flushGroup();
+        }
+        if (groupCount == 0) {
+            groupFirst = i;
+        }
+        groupCount++;
+        groupBytes += added;
+    }
+    flushGroup();
+
+    if (m_packets.empty()) {
+        return true;
+    }
+
+    // The scratch buffer is complete, so its pieces can be resolved now
+    m_pieces.resize(m_layout.size());
+    for (size_t i = 0; i < m_layout.size(); ++i) {
+        const Piece& piece = m_layout[i];
+        m_pieces[i].data = piece.data ? piece.data : m_scratch.data() + piece.scratchOffset;
+        m_pieces[i].size = piece.size;
+    }
+
+    if (packet->endOfFrame) {
+        m_scratch[m_packets.back().header + 1] |= 0x80;
+    }
+
+    return true;
+}
+
+const UdpBuffer* RtpPacketizer::packetPieces(size_t index, size_t& count) const {
+    const Packet& packet = m_packets[index];
+    count = packet.pieces;
+    return m_pieces.data() + packet.firstPiece;
+}
+
+void RtpPacketizer::beginPacket(uint32_t timestamp) {
+    Packet packet;
+    packet.header = m_scratch.size();
+    packet.firstPiece = m_layout.size();
+    packet.pieces = 0;
+    packet.size = 0;
+    m_packets.push_back(packet);
+
+    uint8_t* header = addScratch(kRtpHeaderSize);
+    header[0] = 0x80;  // Version 2, no padding, extension or CSRCs
+    header[1] = static_cast<uint8_t>(m_config.payloadType & 0x7F);
+    writeU16(header + 2, m_sequence++);
+    writeU32(header + 4, timestamp);
+    writeU32(header + 8, m_config.ssrc);
+}
+
+uint8_t* RtpPacketizer::addScratch(size_t size) {
+    // Adjacent scratch bytes of one packet extend the same piece
+    Packet& packet = m_packets.back();
+    size_t offset = m_scratch.size();
+    m_scratch.resize(offset + size);
+    if (packet.pieces > 0 && m_layout.back().data == nullptr &&
+        m_layout.back().scratchOffset + m_layout.back().size == offset) {
+        m_layout.back().size += size;
+    } else {
+        m_layout.push_back({nullptr, offset, size});
+        packet.pieces++;
+    }
+    packet.size += size;
+    return m_scratch.data() + offset;
+}
+
+void RtpPacketizer::addPayload(const uint8_t* data, size_t size) {
+    Packet& packet = m_packets.back();
+    m_layout.push_back({data, 0, size});
+    packet.pieces++;
+    packet.size += size;
+}
+
+void RtpPacketizer::emitSingle(const uint8_t* nal, size_t size, uint32_t timestamp) {
+    beginPacket(timestamp);
+    addPayload(nal, size);
+}
+
+void RtpPacketizer::emitAggregate(const std::vector<encoder::NalUnit>& units, size_t first, size_t count,
+                                  const uint8_t* data, uint32_t timestamp) {
+    beginPacket(timestamp);
+
+    if (m_config.hevc) {
+        // F is ORed, LayerId and TID are the lowest of the aggregated units
+        uint8_t forbidden = 0;
+        uint8_t layerId = 0x3F;
+        uint8_t temporalId = 0x07;
+        for (size_t i = first; i < first + count; ++i) {
+            const uint8_t* nal = data + units[i].offset;
+            forbidden |= nal[0] & 0x80;
+            layerId = std::min<uint8_t>(layerId, static_cast<uint8_t>(((nal[0] & 0x01) << 5) | (nal[1] >> 3)));
+            temporalId = std::min<uint8_t>(temporalId, static_cast<uint8_t>(nal[1] & 0x07));
+        }
+        uint8_t* header = addScratch(2);
+        header[0] = static_cast<uint8_t>(forbidden | (kH265Ap << 1) | (layerId >> 5));
+        header[1] = static_cast<uint8_t>(((layerId & 0x1F) << 3) | temporalId);
+    } else {
+        // F is ORed, NRI is the highest of the aggregated units
+        uint8_t forbidden = 0;
+        uint8_t nri = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            const uint8_t* nal = data + units[i].offset;
+            forbidden |= nal[0] & 0x80;
+            nri = std::max<uint8_t>(nri, static_cast<uint8_t>(nal[0] & 0x60));
+        }
+        *addScratch(1) = static_cast<uint8_t>(forbidden | nri | kH264StapA);
+    }
+
+    for (size_t i = first; i < first + count; ++i) {
+        writeU16(addScratch(kAggregationSizeField), static_cast<uint16_t>(units[i].size));
+        addPayload(data + units[i].offset, units[i].size);
+    }
+}
+
+void RtpPacketizer::emitFragments(const uint8_t* nal, size_t size, uint32_t timestamp) {
+    // The NAL header is not sent itself; the FU headers carry its fields
+    const size_t nalHeaderSize = m_config.hevc ? 2 : 1;
+    const size_t fuHeaderSize = m_config.hevc ? 3 : 2;
+    const size_t chunk = m_config.maxPacketSize - kRtpHeaderSize - fuHeaderSize;
+
+    size_t offset = nalHeaderSize;
+    while (offset < size) {
+        size_t length = std::min(chunk, size - offset);
+        uint8_t flags = 0;
+        if (offset == nalHeaderSize) {
+            flags |= kFuStart;
+        }
+        if (offset + length == size) {
+            flags |= kFuEnd;
+        }
+
+        beginPacket(timestamp);
+        uint8_t* header = addScratch(fuHeaderSize);
+        if (m_config.hevc) {
+            header[0] = static_cast<uint8_t>((nal[0] & 0x81) | (kH265Fu << 1));
+            header[1] = nal[1];
+            header[2] = static_cast<uint8_t>(flags | ((nal[0] >> 1) & 0x3F));
+        } else {
+            header[0] = static_cast<uint8_t>((nal[0] & 0xE0) | kH264FuA);
+            header[1] = static_cast<uint8_t>(flags | (nal[0] & 0x1F));
+        }
+        addPayload(nal + offset, length);
+        offset += length;
+    }
+}
+
+} // namespace network
+} // namespace talos
@@ -0,0 +1,383 @@
+#include "network/udp_batch_sender.h"
+#include "core/logger.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(PLATFORM_WINDOWS)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#if defined(PLATFORM_LINUX)
+#include <netinet/udp.h>
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#endif
+
+namespace talos {
+namespace network {
+
+namespace {
+
+static_assert(sizeof(UdpAddress::storage) >= sizeof(sockaddr_in6), "UdpAddress too small for IPv6");
+
+constexpr size_t kMaxDatagramBytes = 65507;   // IPv4 UDP payload limit
+
+#if defined(PLATFORM_LINUX)
+constexpr size_t kMaxGsoSegments = 64;        // UDP_MAX_SEGMENTS of older kernels
+constexpr size_t kMaxIovecs = 1024;           // UIO_MAXIOV
+
+bool wouldBlock(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS;
+}
+#endif
+
+} // namespace
+
+bool UdpAddress::parse(const std::string& host, uint16_t port, UdpAddress& address) {
+    address = UdpAddress();
+
+    sockaddr_in v4;
+    std::memset(&v4, 0, sizeof(v4));
+    if (inet_pton(AF_INET, host.c_str(), &v4.sin_addr) == 1) {
+        v4.sin_family = AF_INET;
+        v4.sin_port = htons(port);
+        std::memcpy(address.storage, &v4, sizeof(v4));
+        address.length = sizeof(v4);
+        return true;
+    }
+
+    sockaddr_in6 v6;
+    std::memset(&v6, 0, sizeof(v6));
+    if (inet_pton(AF_INET6, host.c_str(), &v6.sin6_addr) == 1) {
+        v6.sin6_family = AF_INET6;
+        v6.sin6_port = htons(port);
+        std::memcpy(address.storage, &v6, sizeof(v6));
+        address.length = sizeof(v6);
+        return true;
+    }
+    return false;
+}
+
+bool UdpAddress::isIpv6() const {
+    return length == sizeof(sockaddr_in6);
+}
+
+bool UdpAddress::operator==(const UdpAddress& other) const {
+    return length == other.length && std::memcmp(storage, other.storage, length) == 0;
+}
+
+UdpBatchSender::UdpBatchSender(size_t maxBatch)
+    : m_socket(kInvalidSocket)
+    , m_ipv6(false)
+    , m_gso(false)
+    , m_maxBatch(std::max<size_t>(maxBatch, 1)) {
+}
+
+UdpBatchSender::~UdpBatchSender() {
+    close();
+}
+
+bool UdpBatchSender::open(bool ipv6, uint16_t localPort, int sendBufferBytes) {
+    close();
+
+    int family = ipv6 ? AF_INET6 : AF_INET;
+#if defined(PLATFORM_WINDOWS)
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        Logger::instance().error("WSAStartup failed");
+        return false;
+    }
+    SOCKET handle = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == INVALID_SOCKET) {
+        Logger::instance().error("Failed to create UDP socket: " + std::to_string(WSAGetLastError()));
+        WSACleanup();
+        return false;
+    }
+    m_socket = static_cast<Socket>(handle);
+    u_long nonBlocking = 1;
+    ioctlsocket(handle, FIONBIO, &nonBlocking);
+#elif defined(PLATFORM_LINUX)
+    m_socket = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_socket == kInvalidSocket) {
+        Logger::instance().error(std::string("Failed to create UDP socket: ") + std::strerror(errno));
+        return false;
+    }
+#else
+    m_socket = socket(family, SOCK_DGRAM, 0);
+    if (m_socket == kInvalidSocket) {
+        Logger::instance().error(std::string("Failed to create UDP socket: ") + std::strerror(errno));
+        return false;
+    }
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(m_socket, F_SETFD, FD_CLOEXEC);
+#endif
+    m_ipv6 = ipv6;
+
+    if (sendBufferBytes > 0 &&
+        setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&sendBufferBytes),
+                   sizeof(sendBufferBytes)) != 0) {
+        Logger::instance().warn("Could not set UDP send buffer to " + std::to_string(sendBufferBytes) + " bytes");
+    }
+
+    if (localPort != 0) {
+        UdpAddress local;
+        UdpAddress::parse(ipv6 ? "::" : "0.0.0.0", localPort, local);
+        if (bind(m_socket, reinterpret_cast<const sockaddr*>(local.storage), local.length) != 0) {
+            Logger::instance().error("Failed to bind UDP port " + std::to_string(localPort));
+            close();
+            return false;
+        }
+    }
+
+#if defined(PLATFORM_LINUX)
+    // Kernels before 4.18 do not know the option at all
+    int segment = 0;
+    socklen_t length = sizeof(segment);
+    m_gso = getsockopt(m_socket, SOL_UDP, UDP_SEGMENT, &segment, &length) == 0;
+#endif
+
+    Logger::instance().info(std::string("UDP batch sender opened") + (m_gso ? " with GSO" : ""));
+    return true;
+}
+
+void UdpBatchSender::close() {
+    if (m_socket != kInvalidSocket) {
+#if defined(PLATFORM_WINDOWS)
+        closesocket(static_cast<SOCKET>(m_socket));
+        WSACleanup();
+#else
+        ::close(m_socket);
+#endif
+        m_socket = kInvalidSocket;
+    }
+    m_gso = false;
+    m_addresses.clear();
+    m_pieces.clear();
+    m_pending.clear();
+}
+
+bool UdpBatchSender::queue(const UdpAddress& to, const UdpBuffer* pieces, size_t count) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size += pieces[i].size;
+    }
+    if (size == 0 || size > kMaxDatagramBytes || to.length == 0 || to.isIpv6() != m_ipv6) {
+        return false;
+    }
+
+    // Consecutive datagrams to one client share the address, which lets them form GSO runs
+    if (m_addresses.empty() || !(m_addresses.back() == to)) {
+        m_addresses.push_back(to);
+    }
+
+    Datagram datagram;
+    datagram.address = m_addresses.size() - 1;
+    datagram.firstPiece = m_pieces.size();
+    datagram.pieces = count;
+    datagram.size = size;
+    m_pieces.insert(m_pieces.end(), pieces, pieces + count);
+    m_pending.push_back(datagram);
+    return true;
+}
+
+size_t UdpBatchSender::flush() {
+    if (m_pending.empty()) {
+        return 0;
+    }
+
+    uint64_t sentBefore = m_stats.datagramsSent;
+    if (!isOpen()) {
+        m_stats.datagramsDropped += m_pending.size();
+    } else {
+#if defined(PLATFORM_LINUX)
+        m_iovecs.resize(m_pieces.size());
+        for (size_t i = 0; i < m_pieces.size(); ++i) {
+            m_iovecs[i].iov_base = const_cast<void*>(m_pieces[i].data);
+            m_iovecs[i].iov_len = m_pieces[i].size;
+        }
+
+        size_t next = 0;
+        while (next < m_pending.size()) {
+            next += sendBatch(next);
+        }
+#else
+        for (size_t i = 0; i < m_pending.size(); ++i) {
+            if (sendOne(m_pending[i]) < 0) {
+                m_stats.datagramsDropped += m_pending.size() - i;
+                break;
+            }
+        }
+#endif
+    }
+
+    m_addresses.clear();
+    m_pieces.clear();
+    m_pending.clear();
+    return static_cast<size_t>(m_stats.datagramsSent - sentBefore);
+}
+
+#if defined(PLATFORM_LINUX)
+
+size_t UdpBatchSender::gsoRun(size_t first) const {
+    // All segments but the last must be exactly gso_size bytes
+    const Datagram& head = m_pending[first];
+    size_t bytes = head.size;
+    size_t iovecs = head.pieces;
+    size_t run = 1;
+    while (first + run < m_pending.size() && run < kMaxGsoSegments) {
+        const Datagram& next = m_pending[first + run];
+        if (next.address != head.address || next.size > head.size ||
+            bytes + next.size > kMaxDatagramBytes || iovecs + next.pieces > kMaxIovecs) {
+            break;
+        }
+        bytes += next.size;
+        iovecs += next.pieces;
+        run++;
+        if (next.size < head.size) {
+            break;
+        }
+    }
+    return run;
+}
+
+size_t UdpBatchSender::sendBatch(size_t first) {
+    const size_t controlSpace = CMSG_SPACE(sizeof(uint16_t));
+    m_messages.clear();
+    m_messageDatagrams.clear();
+    m_control.assign(m_maxBatch * controlSpace, 0);
+
+    size_t index = first;
+    while (index < m_pending.size() && m_messages.size() < m_maxBatch) {
+        size_t run = m_gso ? gsoRun(index) : 1;
+        const Datagram& head = m_pending[index];
+        const Datagram& tail = m_pending[index + run - 1];
+
+        mmsghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_hdr.msg_name = m_addresses[head.address].storage;
+        message.msg_hdr.msg_namelen = m_addresses[head.address].length;
+        message.msg_hdr.msg_iov = &m_iovecs[head.firstPiece];
+        message.msg_hdr.msg_iovlen = tail.firstPiece + tail.pieces - head.firstPiece;
+
+        if (run > 1) {
+            char* control = &m_control[m_messages.size() * controlSpace];
+            message.msg_hdr.msg_control = control;
+            message.msg_hdr.msg_controllen = controlSpace;
+            cmsghdr* header = CMSG_FIRSTHDR(&message.msg_hdr);
+            header->cmsg_level = SOL_UDP;
+            header->cmsg_type = UDP_SEGMENT;
+            header->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segmentSize = static_cast<uint16_t>(head.size);
+            std::memcpy(CMSG_DATA(header), &segmentSize, sizeof(segmentSize));
+        }
+
+        m_messages.push_back(message);
+        m_messageDatagrams.push_back(run);
+        index += run;
+    }
+
+    int sent = sendmmsg(m_socket, m_messages.data(), static_cast<unsigned int>(m_messages.size()), 0);
+    m_stats.systemCalls++;
+
+    if (sent < 0) {
+        int error = errno;
+        if (error == EINTR) {
+            return 0;
+        }
+        if (wouldBlock(error)) {
+            // The rest of this flush would only queue up behind a full buffer
+            m_stats.datagramsDropped += m_pending.size() - first;
+            return m_pending.size() - first;
+        }
+        if (m_messageDatagrams[0] > 1 && (error == EIO || error == EINVAL || error == EMSGSIZE)) {
+            // No checksum offload or a route MTU below the segment size
+            Logger::instance().warn(std::string("UDP GSO rejected, sending datagrams individually: ") +
+                                    std::strerror(error));
+            m_gso = false;
+            return 0;
+        }
+        m_stats.datagramsDropped += m_messageDatagrams[0];
+        return m_messageDatagrams[0];
+    }
+
+    // A short count means message [sent] failed; the next call reports why
+    size_t consumed = 0;
+    for (int i = 0; i < sent; ++i) {
+        size_t run = m_messageDatagrams[i];
+        for (size_t d = first + consumed; d < first + consumed + run; ++d) {
+            m_stats.bytesSent += m_pending[d].size;
+        }
+        m_stats.datagramsSent += run;
+        if (run > 1) {
+            m_stats.gsoMessages++;
+        }
+        consumed += run;
+    }
+    return consumed;
+}
+
+#else
+
+int UdpBatchSender::sendOne(const Datagram& datagram) {
+    const UdpAddress& to = m_addresses[datagram.address];
+    const UdpBuffer* pieces = &m_pieces[datagram.firstPiece];
+    m_stats.systemCalls++;
+
+#if defined(PLATFORM_WINDOWS)
+    std::vector<WSABUF> buffers(datagram.pieces);
+    for (size_t i = 0; i < datagram.pieces; ++i) {
+        buffers[i].buf = static_cast<CHAR*>(const_cast<void*>(pieces[i].data));
+        buffers[i].len = static_cast<ULONG>(pieces[i].size);
+    }
+    DWORD bytes = 0;
+    if (WSASendTo(static_cast<SOCKET>(m_socket), buffers.data(), static_cast<DWORD>(buffers.size()), &bytes, 0,
+                  reinterpret_cast<const sockaddr*>(to.storage), static_cast<int>(to.length),
+                  nullptr, nullptr) != 0) {
+        if (WSAGetLastError() == WSAEWOULDBLOCK) {
+            return -1;
+        }
+        m_stats.datagramsDropped++;
+        return 0;
+    }
+#else
+    std::vector<iovec> iovecs(datagram.pieces);
+    for (size_t i = 0; i < datagram.pieces; ++i) {
+        iovecs[i].iov_base = const_cast<void*>(pieces[i].data);
+        iovecs[i].iov_len = pieces[i].size;
+    }
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_name = const_cast<unsigned char*>(to.storage);
+    message.msg_namelen = to.length;
+    message.msg_iov = iovecs.data();
+    message.msg_iovlen = static_cast<int>(iovecs.size());
+    if (sendmsg(m_socket, &message, 0) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+            return -1;
+        }
+        m_stats.datagramsDropped++;
+        return 0;
+    }
+#endif
+
+    m_stats.datagramsSent++;
+    m_stats.bytesSent += datagram.size;
+    return 1;
+}
+
+#endif
+
+} // namespace network
+} // namespace talos
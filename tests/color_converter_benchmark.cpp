@@ -0,0 +1,118 @@
+// Milliseconds per frame of each color conversion kernel this CPU can run,
+// and of sws_scale for comparison
+//
+// Usage: color_converter_benchmark [frames]
+
+#include "encoder/color_converter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef NO_FFMPEG
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/pixfmt.h>
+}
+#endif
+
+using talos::capture::PixelFormat;
+using talos::encoder::ColorConverter;
+using talos::encoder::ColorMatrix;
+
+namespace {
+
+struct Resolution {
+    const char* name;
+    int width;
+    int height;
+};
+
+struct Buffers {
+    int width;
+    int height;
+    std::vector<uint8_t> src;
+    std::vector<uint8_t> planes[3];
+    uint8_t* data[3];
+    int stride[3];
+
+    Buffers(int w, int h, PixelFormat dstFormat)
+        : width(w), height(h), src(static_cast<size_t>(w) * h * 4), data(), stride() {
+        uint32_t state = 0x12345678;
+        for (uint8_t& byte : src) {
+            state = state * 1664525 + 1013904223;
+            byte = static_cast<uint8_t>(state >> 24);
+        }
+
+        bool planar = dstFormat == PixelFormat::YUV420P;
+        int chromaWidth = (w + 1) / 2;
+        stride[0] = w;
+        stride[1] = planar ? chromaWidth : chromaWidth * 2;
+        stride[2] = planar ? chromaWidth : 0;
+        for (int i = 0; i < 3; ++i) {
+            planes[i].resize(static_cast<size_t>(stride[i]) * (i == 0 ? h : (h + 1) / 2));
+            data[i] = planes[i].empty() ? nullptr : planes[i].data();
+        }
+    }
+};
+
+// One warm-up run, then the average of the timed ones
+double millisecondsPerFrame(int frames, const std::function<void()>& convert) {
+    convert();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        convert();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / frames;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 100;
+
+    const Resolution resolutions[] = {{"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"2160p", 3840, 2160}};
+    const PixelFormat formats[] = {PixelFormat::NV12, PixelFormat::YUV420P};
+
+    std::printf("%-8s %-8s %-10s %10s\n", "size", "output", "kernel", "ms/frame");
+    for (const Resolution& resolution : resolutions) {
+        for (PixelFormat format : formats) {
+            Buffers buffers(resolution.width, resolution.height, format);
+            const char* output = format == PixelFormat::NV12 ? "nv12" : "yuv420p";
+
+            for (const std::string& kernel : ColorConverter::supportedKernels()) {
+                ColorConverter converter;
+                converter.selectKernel(kernel);
+                converter.configure(PixelFormat::BGRA8, format, ColorMatrix::BT709, false);
+                double ms = millisecondsPerFrame(frames, [&]() {
+                    converter.convert(buffers.src.data(), buffers.width * 4, buffers.width, buffers.height,
+                                      buffers.data, buffers.stride);
+                });
+                std::printf("%-8s %-8s %-10s %10.3f\n", resolution.name, output, kernel.c_str(), ms);
+            }
+
+#ifndef NO_FFMPEG
+            SwsContext* context = sws_getContext(
+                buffers.width, buffers.height, AV_PIX_FMT_BGRA,
+                buffers.width, buffers.height, format == PixelFormat::NV12 ? AV_PIX_FMT_NV12 : AV_PIX_FMT_YUV420P,
+                SWS_BILINEAR, nullptr, nullptr, nullptr);
+            if (context) {
+                const uint8_t* srcData[1] = {buffers.src.data()};
+                int srcStride[1] = {buffers.width * 4};
+                double ms = millisecondsPerFrame(frames, [&]() {
+                    sws_scale(context, srcData, srcStride, 0, buffers.height, buffers.data, buffers.stride);
+                });
+                std::printf("%-8s %-8s %-10s %10.3f\n", resolution.name, output, "sws_scale", ms);
+                sws_freeContext(context);
+            }
+#endif
+        }
+    }
+    return EXIT_SUCCESS;
+}
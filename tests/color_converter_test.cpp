@@ -0,0 +1,267 @@
+// Checks every color conversion kernel this CPU can run against the scalar
+// reference, and the scalar reference against sws_scale
+
+#include "encoder/color_converter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef NO_FFMPEG
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/pixfmt.h>
+}
+#endif
+
+using talos::capture::PixelFormat;
+using talos::encoder::ColorConverter;
+using talos::encoder::ColorMatrix;
+
+namespace {
+
+// The SIMD kernels share the scalar fixed-point arithmetic exactly
+constexpr int kKernelTolerance = 0;
+
+// sws_scale rounds its own intermediates, dithers the output and filters
+// chroma over more than one 2x2 block; on the smooth test image that keeps
+// it within these bounds of the box-filtered reference
+constexpr int kSwsLumaTolerance = 2;
+constexpr int kSwsChromaTolerance = 3;
+
+struct Size {
+    int width;
+    int height;
+};
+
+struct Case {
+    PixelFormat srcFormat;
+    PixelFormat dstFormat;
+    ColorMatrix matrix;
+    bool fullRange;
+};
+
+std::string describe(const Case& c, const Size& size) {
+    std::string text = c.srcFormat == PixelFormat::BGRA8 ? "bgra" : "rgba";
+    text += c.dstFormat == PixelFormat::NV12 ? "->nv12" : "->yuv420p";
+    text += c.matrix == ColorMatrix::BT601 ? " bt601" : " bt709";
+    text += c.fullRange ? " full " : " limited ";
+    return text + std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+std::vector<Case> allCases() {
+    std::vector<Case> cases;
+    for (PixelFormat src : {PixelFormat::BGRA8, PixelFormat::RGBA8}) {
+        for (PixelFormat dst : {PixelFormat::YUV420P, PixelFormat::NV12}) {
+            for (ColorMatrix matrix : {ColorMatrix::BT601, ColorMatrix::BT709}) {
+                for (bool fullRange : {false, true}) {
+                    cases.push_back({src, dst, matrix, fullRange});
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+/**
+ * @brief Source image with padded rows
+ */
+struct Image {
+    int width;
+    int height;
+    int stride;
+    std::vector<uint8_t> pixels;
+
+    Image(int w, int h)
+        : width(w), height(h), stride(w * 4 + 12), pixels(static_cast<size_t>(stride) * h) {}
+
+    uint8_t* row(int y) { return pixels.data() + static_cast<size_t>(y) * stride; }
+};
+
+Image noiseImage(const Size& size, uint32_t seed) {
+    Image image(size.width, size.height);
+    uint32_t state = seed;
+    for (uint8_t& byte : image.pixels) {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        byte = static_cast<uint8_t>(state);
+    }
+    return image;
+}
+
+/**
+ * @brief Destination planes with padded rows, pre-filled with a marker
+ */
+struct Picture {
+    int width;
+    int height;
+    bool planar;
+    std::vector<uint8_t> planes[3];
+    uint8_t* data[3];
+    int stride[3];
+
+    Picture(int w, int h, PixelFormat format)
+        : width(w), height(h), planar(format == PixelFormat::YUV420P), data(), stride() {
+        int chromaWidth = (w + 1) / 2;
+        int chromaHeight = (h + 1) / 2;
+        stride[0] = w + 16;
+        stride[1] = (planar ? chromaWidth : chromaWidth * 2) + 16;
+        stride[2] = planar ? chromaWidth + 16 : 0;
+        planes[0].assign(static_cast<size_t>(stride[0]) * h, 0xCD);
+        planes[1].assign(static_cast<size_t>(stride[1]) * chromaHeight, 0xCD);
+        planes[2].assign(static_cast<size_t>(stride[2]) * chromaHeight, 0xCD);
+        for (int i = 0; i < 3; ++i) {
+            data[i] = planes[i].empty() ? nullptr : planes[i].data();
+        }
+    }
+
+    int planeCount() const { return planar ? 3 : 2; }
+    int planeWidth(int plane) const {
+        int chromaWidth = (width + 1) / 2;
+        return plane == 0 ? width : (planar ? chromaWidth : chromaWidth * 2);
+    }
+    int planeHeight(int plane) const { return plane == 0 ? height : (height + 1) / 2; }
+};
+
+/**
+ * @brief Compare the visible samples of two pictures
+ * @return true if no sample differs by more than the plane's tolerance
+ */
+bool comparePictures(const Picture& expected, const Picture& actual,
+                     int lumaTolerance, int chromaTolerance, const std::string& label) {
+    for (int plane = 0; plane < expected.planeCount(); ++plane) {
+        int tolerance = plane == 0 ? lumaTolerance : chromaTolerance;
+        for (int y = 0; y < expected.planeHeight(plane); ++y) {
+            const uint8_t* a = expected.data[plane] + static_cast<size_t>(y) * expected.stride[plane];
+            const uint8_t* b = actual.data[plane] + static_cast<size_t>(y) * actual.stride[plane];
+            for (int x = 0; x < expected.planeWidth(plane); ++x) {
+                if (std::abs(a[x] - b[x]) > tolerance) {
+                    std::cout << "FAIL " << label << ": plane " << plane << " (" << x << ", " << y
+                              << ") expected " << int(a[x]) << " got " << int(b[x]) << "\n";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+Picture convertWith(const std::string& kernel, const Case& c, Image& image) {
+    ColorConverter converter;
+    converter.selectKernel(kernel);
+    converter.configure(c.srcFormat, c.dstFormat, c.matrix, c.fullRange);
+    Picture picture(image.width, image.height, c.dstFormat);
+    converter.convert(image.pixels.data(), image.stride, image.width, image.height,
+                      picture.data, picture.stride);
+    return picture;
+}
+
+int testKernels() {
+    // Odd sizes exercise the paired last column and row, widths around the
+    // vector lengths the SIMD tails
+    const Size sizes[] = {{1, 1}, {2, 2}, {3, 5}, {7, 3}, {15, 4}, {17, 9}, {31, 17},
+                          {33, 2}, {64, 64}, {129, 67}, {1920, 6}};
+
+    int failures = 0;
+    for (const std::string& kernel : ColorConverter::supportedKernels()) {
+        if (kernel == "scalar") {
+            continue;
+        }
+        int kernelFailures = 0;
+        for (const Case& c : allCases()) {
+            for (const Size& size : sizes) {
+                Image image = noiseImage(size, static_cast<uint32_t>(size.width * 7919 + size.height));
+                Picture expected = convertWith("scalar", c, image);
+                Picture actual = convertWith(kernel, c, image);
+                if (!comparePictures(expected, actual, kKernelTolerance, kKernelTolerance,
+                                     kernel + " " + describe(c, size))) {
+                    kernelFailures++;
+                }
+            }
+        }
+        std::cout << (kernelFailures ? "FAIL " : "ok   ") << kernel << " matches scalar\n";
+        failures += kernelFailures;
+    }
+    return failures;
+}
+
+#ifndef NO_FFMPEG
+// Changes by less than two levels per pixel in any channel
+Image gradientImage(const Size& size) {
+    Image image(size.width, size.height);
+    for (int y = 0; y < size.height; ++y) {
+        uint8_t* p = image.row(y);
+        for (int x = 0; x < size.width; ++x, p += 4) {
+            p[0] = static_cast<uint8_t>(x * 255 / std::max(size.width - 1, 1));
+            p[1] = static_cast<uint8_t>(y * 255 / std::max(size.height - 1, 1));
+            p[2] = static_cast<uint8_t>(255 - (p[0] + p[1]) / 2);
+            p[3] = 255;
+        }
+    }
+    return image;
+}
+
+bool convertWithSws(const Case& c, Image& image, Picture& picture) {
+    AVPixelFormat src = c.srcFormat == PixelFormat::BGRA8 ? AV_PIX_FMT_BGRA : AV_PIX_FMT_RGBA;
+    AVPixelFormat dst = c.dstFormat == PixelFormat::NV12 ? AV_PIX_FMT_NV12 : AV_PIX_FMT_YUV420P;
+    SwsContext* context = sws_getContext(image.width, image.height, src,
+                                         image.width, image.height, dst,
+                                         SWS_BILINEAR | SWS_ACCURATE_RND, nullptr, nullptr, nullptr);
+    if (!context) {
+        return false;
+    }
+
+    int colorspace = c.matrix == ColorMatrix::BT601 ? SWS_CS_ITU601 : SWS_CS_ITU709;
+    sws_setColorspaceDetails(context,
+                             sws_getCoefficients(colorspace), 1,
+                             sws_getCoefficients(colorspace), c.fullRange ? 1 : 0,
+                             0, 1 << 16, 1 << 16);
+
+    const uint8_t* srcData[1] = {image.pixels.data()};
+    int srcStride[1] = {image.stride};
+    sws_scale(context, srcData, srcStride, 0, image.height, picture.data, picture.stride);
+    sws_freeContext(context);
+    return true;
+}
+
+int testAgainstSws() {
+    const Size sizes[] = {{256, 144}, {255, 143}};
+
+    int failures = 0;
+    for (const Case& c : allCases()) {
+        for (const Size& size : sizes) {
+            Image image = gradientImage(size);
+            Picture expected(size.width, size.height, c.dstFormat);
+            if (!convertWithSws(c, image, expected)) {
+                std::cout << "FAIL sws_scale context for " << describe(c, size) << "\n";
+                failures++;
+                continue;
+            }
+            Picture actual = convertWith("scalar", c, image);
+            if (!comparePictures(expected, actual, kSwsLumaTolerance, kSwsChromaTolerance,
+                                 "sws_scale " + describe(c, size))) {
+                failures++;
+            }
+        }
+    }
+    std::cout << (failures ? "FAIL " : "ok   ") << "scalar matches sws_scale\n";
+    return failures;
+}
+#endif
+
+} // namespace
+
+int main() {
+    int failures = testKernels();
+#ifndef NO_FFMPEG
+    failures += testAgainstSws();
+#else
+    std::cout << "skip sws_scale comparison, built without FFmpeg\n";
+#endif
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+// Bitrate of the synthetic desktop clip with regions of interest off and on,
+// at equal CRF, so the cost of the quality offsets can be read directly
+//
+// Usage: roi_bitrate_benchmark [encoder] [frames]
+
+#include "encoder/ffmpeg_encoder.h"
+#include "encoder/synthetic_clip.h"
+#include "capture/capture_engine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using talos::capture::Frame;
+using talos::encoder::EncodedPacketPtr;
+using talos::encoder::EncoderConfig;
+using talos::encoder::FFmpegEncoder;
+using talos::encoder::SyntheticClip;
+
+namespace {
+
+struct Variant {
+    const char* name;
+    bool regionOfInterest;
+    float changedOffset;
+    float staticOffset;
+};
+
+/**
+ * @brief Encode the clip once
+ * @return Bits per second at the configured framerate, or a negative value on failure
+ */
+double encodeClip(const EncoderConfig& config, int frames) {
+    FFmpegEncoder encoder;
+    if (!encoder.initialize(config) || encoder.getStats().encoderName != config.encoderName) {
+        return -1.0;
+    }
+
+    SyntheticClip clip(config.width, config.height, config.framerate);
+    Frame frame;
+    EncodedPacketPtr packet;
+    uint64_t bytes = 0;
+    bool ok = true;
+    for (int i = 0; i < frames && ok; ++i) {
+        clip.render(i, frame);
+        ok = encoder.encodeFrame(frame);
+        while (encoder.getEncodedPacket(packet)) {
+            bytes += packet->size;
+        }
+    }
+
+    encoder.shutdown();
+    while (encoder.getEncodedPacket(packet)) {
+        bytes += packet->size;
+    }
+    return ok ? static_cast<double>(bytes * 8) * config.framerate / frames : -1.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string encoderName = argc > 1 ? argv[1] : "libx264";
+    int frames = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 3 * SyntheticClip::kSceneLength;
+
+    const int crfs[] = {18, 23, 28};
+    const Variant variants[] = {
+        {"off", false, 0.0f, 0.0f},
+        {"changed", true, -0.1f, 0.0f},           // The EncoderConfig defaults
+        {"changed+static", true, -0.3f, 0.3f},
+    };
+
+    EncoderConfig base;
+    base.width = 1920;
+    base.height = 1080;
+    base.framerate = 30;
+    base.encoderName = encoderName;
+    base.useHardwareAccel = false;
+    base.preset = "veryfast";
+
+    std::printf("%s, %dx%d, %d frames\n", encoderName.c_str(), base.width, base.height, frames);
+    std::printf("%-4s %-16s %10s %8s\n", "crf", "roi", "kbps", "delta");
+    for (int crf : crfs) {
+        double offBitrate = 0.0;
+        for (const Variant& variant : variants) {
+            EncoderConfig config = base;
+            config.crf = crf;
+            config.regionOfInterest = variant.regionOfInterest;
+            config.roiChangedOffset = variant.changedOffset;
+            config.roiStaticOffset = variant.staticOffset;
+
+            double bitrate = encodeClip(config, frames);
+            if (bitrate < 0.0) {
+                std::fprintf(stderr, "Cannot encode with %s\n", encoderName.c_str());
+                return EXIT_FAILURE;
+            }
+            if (!variant.regionOfInterest) {
+                offBitrate = bitrate;
+            }
+
+            double delta = offBitrate > 0.0 ? 100.0 * (bitrate - offBitrate) / offBitrate : 0.0;
+            std::printf("%-4d %-16s %10.0f %+7.1f%%\n", crf, variant.name, bitrate / 1000.0, delta);
+        }
+    }
+    return EXIT_SUCCESS;
+}
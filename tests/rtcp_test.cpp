@@ -0,0 +1,109 @@
+// Checks that RTCP keyframe requests are only reported for the served stream
+
+#include "network/rtcp.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using talos::network::RtcpKeyframeRequest;
+using talos::network::parseRtcpKeyframeRequest;
+
+namespace {
+
+constexpr uint32_t kServed = 0x11223344u;
+constexpr uint32_t kOther = 0x55667788u;
+constexpr uint32_t kClient = 0x0A0B0C0Du;
+
+void writeU32(std::vector<uint8_t>& packet, uint32_t value) {
+    packet.push_back(static_cast<uint8_t>(value >> 24));
+    packet.push_back(static_cast<uint8_t>(value >> 16));
+    packet.push_back(static_cast<uint8_t>(value >> 8));
+    packet.push_back(static_cast<uint8_t>(value));
+}
+
+void writeHeader(std::vector<uint8_t>& packet, uint8_t format, uint8_t type, size_t words) {
+    packet.push_back(static_cast<uint8_t>(0x80 | format));
+    packet.push_back(type);
+    packet.push_back(static_cast<uint8_t>((words - 1) >> 8));
+    packet.push_back(static_cast<uint8_t>(words - 1));
+}
+
+void appendPli(std::vector<uint8_t>& packet, uint32_t media) {
+    writeHeader(packet, 1, 206, 3);
+    writeU32(packet, kClient);
+    writeU32(packet, media);
+}
+
+// FIR with one entry per (SSRC, sequence number)
+void appendFir(std::vector<uint8_t>& packet, const std::vector<std::pair<uint32_t, uint8_t>>& entries) {
+    writeHeader(packet, 4, 206, 3 + 2 * entries.size());
+    writeU32(packet, kClient);
+    writeU32(packet, 0);
+    for (const auto& entry : entries) {
+        writeU32(packet, entry.first);
+        writeU32(packet, static_cast<uint32_t>(entry.second) << 24);
+    }
+}
+
+void appendReceiverReport(std::vector<uint8_t>& packet) {
+    writeHeader(packet, 0, 201, 2);
+    writeU32(packet, kClient);
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "FAIL " << what << "\n";
+        failures++;
+    }
+}
+
+} // namespace
+
+int main() {
+    RtcpKeyframeRequest request;
+
+    std::vector<uint8_t> pli;
+    appendReceiverReport(pli);
+    appendPli(pli, kServed);
+    check(parseRtcpKeyframeRequest(pli.data(), pli.size(), kServed, request) && request.pictureLoss &&
+              request.senderSsrc == kClient,
+          "PLI for the served stream");
+    check(!parseRtcpKeyframeRequest(pli.data(), pli.size(), kOther, request), "PLI for another stream");
+
+    // The entry for the served stream is reported, wherever it is
+    std::vector<uint8_t> fir;
+    appendReceiverReport(fir);
+    appendFir(fir, {{kOther, 9}, {kServed, 3}, {kOther + 1, 7}});
+    check(parseRtcpKeyframeRequest(fir.data(), fir.size(), kServed, request) && request.fullIntraRequest &&
+              request.firSequence == 3 && !request.pictureLoss,
+          "FIR entry for the served stream");
+
+    std::vector<uint8_t> firOther;
+    appendFir(firOther, {{kOther, 9}});
+    check(!parseRtcpKeyframeRequest(firOther.data(), firOther.size(), kServed, request) &&
+              !request.fullIntraRequest,
+          "FIR naming only another stream");
+
+    std::vector<uint8_t> legacy;
+    writeHeader(legacy, 0, 192, 2);
+    writeU32(legacy, kServed);
+    check(parseRtcpKeyframeRequest(legacy.data(), legacy.size(), kServed, request) && request.fullIntraRequest,
+          "RFC 2032 FIR for the served stream");
+    check(!parseRtcpKeyframeRequest(legacy.data(), legacy.size(), kOther, request), "RFC 2032 FIR for another stream");
+
+    // Truncated after the first packet: what came before still counts
+    std::vector<uint8_t> truncated = pli;
+    appendFir(truncated, {{kServed, 1}});
+    truncated.resize(truncated.size() - 4);
+    check(parseRtcpKeyframeRequest(truncated.data(), truncated.size(), kServed, request) && request.pictureLoss &&
+              !request.fullIntraRequest,
+          "truncated compound packet");
+
+    std::cout << (failures ? "FAIL " : "ok   ") << "RTCP keyframe requests\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
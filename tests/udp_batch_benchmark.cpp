@@ -0,0 +1,275 @@
+// Loopback benchmark of UdpBatchSender with one sendmmsg() message per
+// datagram, with batching, and with batching plus GSO, for a growing number
+// of clients. Frames are packetized once and queued for every client, as a
+// shared RTP session does.
+//
+// Each combination runs twice: unpaced, for the most packets per second
+// one sending thread manages, and paced at 30 fps, for the CPU time the
+// sending thread spends per client on a real stream.
+//
+// Usage: udp_batch_benchmark [seconds] [clients...]
+
+#include "encoder/encoded_packet.h"
+#include "network/rtp_packetizer.h"
+#include "network/udp_batch_sender.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using talos::encoder::EncodedPacket;
+using talos::encoder::EncodedPacketPtr;
+using talos::encoder::NalUnit;
+using talos::network::RtpPacketizer;
+using talos::network::RtpPacketizerConfig;
+using talos::network::UdpAddress;
+using talos::network::UdpBatchSender;
+using talos::network::UdpBuffer;
+using talos::network::UdpSendStats;
+
+namespace {
+
+constexpr int kPacedFps = 30;
+
+// A 30-frame GOP at roughly 8 Mbps: one large IDR frame, small P frames
+constexpr int kGopLength = 30;
+constexpr size_t kKeyframeBytes = 150000;
+constexpr size_t kDeltaFrameBytes = 25000;
+
+struct Mode {
+    const char* name;
+    size_t maxBatch;
+    bool gso;
+};
+
+struct Result {
+    double seconds = 0.0;
+    double cpuSeconds = 0.0;
+    uint64_t frames = 0;
+    uint64_t received = 0;
+    UdpSendStats stats;
+};
+
+double threadCpuSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) + now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Annex B access unit of the given slice size, parameter sets first for keyframes
+ */
+EncodedPacketPtr makeFrame(std::vector<uint8_t>& storage, size_t sliceBytes, bool keyframe) {
+    auto packet = std::make_shared<EncodedPacket>();
+    storage.clear();
+    auto addNal = [&](uint8_t header, size_t size) {
+        static const uint8_t kStartCode[] = {0, 0, 0, 1};
+        storage.insert(storage.end(), kStartCode, kStartCode + 4);
+        NalUnit unit = {storage.size(), size, static_cast<uint8_t>(header & 0x1F)};
+        storage.push_back(header);
+        for (size_t i = 1; i < size; ++i) {
+            storage.push_back(static_cast<uint8_t>(i * 131 + 7));
+        }
+        packet->nalUnits.push_back(unit);
+    };
+    if (keyframe) {
+        addNal(0x67, 24);  // SPS
+        addNal(0x68, 6);   // PPS
+        addNal(0x65, sliceBytes);
+    } else {
+        addNal(0x41, sliceBytes);
+    }
+    packet->data = storage.data();
+    packet->size = storage.size();
+    packet->keyframe = keyframe;
+    return packet;
+}
+
+/**
+ * @brief Loopback sockets standing in for the clients, drained by one thread
+ */
+class Receivers {
+public:
+    explicit Receivers(int count) : m_running(true), m_received(0) {
+        for (int i = 0; i < count; ++i) {
+            int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+            int bufferBytes = 8 * 1024 * 1024;
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+            UdpAddress address;
+            UdpAddress::parse("127.0.0.1", 0, address);
+            bind(fd, reinterpret_cast<const sockaddr*>(address.storage), address.length);
+
+            sockaddr_in bound = {};
+            socklen_t length = sizeof(bound);
+            getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &length);
+            UdpAddress::parse("127.0.0.1", ntohs(bound.sin_port), address);
+
+            m_sockets.push_back(fd);
+            m_addresses.push_back(address);
+        }
+        m_thread = std::thread(&Receivers::drain, this);
+    }
+
+    ~Receivers() {
+        m_running = false;
+        m_thread.join();
+        for (int fd : m_sockets) {
+            ::close(fd);
+        }
+    }
+
+    const std::vector<UdpAddress>& addresses() const { return m_addresses; }
+    uint64_t received() const { return m_received; }
+
+private:
+    void drain() {
+        constexpr unsigned int kBatch = 64;
+        std::vector<uint8_t> buffers(kBatch * 2048);
+        std::vector<iovec> iovecs(kBatch);
+        std::vector<mmsghdr> messages(kBatch);
+        std::vector<pollfd> fds;
+        for (int fd : m_sockets) {
+            fds.push_back({fd, POLLIN, 0});
+        }
+
+        while (m_running) {
+            if (poll(fds.data(), fds.size(), 10) <= 0) {
+                continue;
+            }
+            for (const pollfd& entry : fds) {
+                if (!(entry.revents & POLLIN)) {
+                    continue;
+                }
+                for (unsigned int i = 0; i < kBatch; ++i) {
+                    iovecs[i] = {&buffers[i * 2048], 2048};
+                    messages[i] = {};
+                    messages[i].msg_hdr.msg_iov = &iovecs[i];
+                    messages[i].msg_hdr.msg_iovlen = 1;
+                }
+                int count;
+                while ((count = recvmmsg(entry.fd, messages.data(), kBatch, 0, nullptr)) > 0) {
+                    m_received += static_cast<uint64_t>(count);
+                }
+            }
+        }
+    }
+
+    std::vector<int> m_sockets;
+    std::vector<UdpAddress> m_addresses;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_received;
+    std::thread m_thread;
+};
+
+/**
+ * @brief Send for the given time
+ * @param fps Frames per second, 0 = as fast as possible
+ */
+bool run(const Mode& mode, int clients, double seconds, int fps, Result& result) {
+    UdpBatchSender sender(mode.maxBatch);
+    if (!sender.open()) {
+        return false;
+    }
+    if (mode.gso && !sender.gsoEnabled()) {
+        return false;
+    }
+    if (!mode.gso) {
+        sender.disableGso();
+    }
+
+    Receivers receivers(clients);
+    RtpPacketizerConfig config;
+    config.ssrc = 0x5441u;
+    RtpPacketizer packetizer(config);
+
+    // Built up front so that only packetizing and sending is timed
+    std::vector<uint8_t> keyStorage;
+    std::vector<uint8_t> deltaStorage;
+    EncodedPacketPtr keyFrame = makeFrame(keyStorage, kKeyframeBytes, true);
+    EncodedPacketPtr deltaFrame = makeFrame(deltaStorage, kDeltaFrameBytes, false);
+
+    double cpuStart = threadCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(seconds);
+    uint64_t frame = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (fps > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(frame * 1000000 / fps));
+        }
+        const EncodedPacketPtr& packet = frame % kGopLength == 0 ? keyFrame : deltaFrame;
+        packetizer.packetize(packet, static_cast<uint32_t>(frame * 3000));
+
+        // Client by client, so each one's packets form GSO runs
+        for (const UdpAddress& address : receivers.addresses()) {
+            for (size_t i = 0; i < packetizer.packetCount(); ++i) {
+                size_t count = 0;
+                const UdpBuffer* pieces = packetizer.packetPieces(i, count);
+                sender.queue(address, pieces, count);
+            }
+        }
+        sender.flush();
+        frame++;
+    }
+    result.cpuSeconds = threadCpuSeconds() - cpuStart;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Let the receivers catch up before counting
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    result.frames = frame;
+    result.received = receivers.received();
+    result.stats = sender.getStats();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::max(std::atof(argv[1]), 0.1) : 2.0;
+    std::vector<int> clientCounts;
+    for (int i = 2; i < argc; ++i) {
+        clientCounts.push_back(std::max(std::atoi(argv[i]), 1));
+    }
+    if (clientCounts.empty()) {
+        clientCounts = {1, 8, 32};
+    }
+
+    const Mode modes[] = {
+        {"sendmmsg x1", 1, false},   // One datagram per system call
+        {"sendmmsg", 64, false},
+        {"sendmmsg+gso", 64, true},
+    };
+
+    std::printf("%-14s %7s %12s %12s %10s %10s %12s\n",
+                "mode", "clients", "sent pkt/s", "recv pkt/s", "pkts/call", "ns/pkt", "cpu%/client");
+    for (int clients : clientCounts) {
+        for (const Mode& mode : modes) {
+            Result unpaced;
+            Result paced;
+            if (!run(mode, clients, seconds, 0, unpaced) || !run(mode, clients, seconds, kPacedFps, paced)) {
+                std::printf("%-14s %7d %12s\n", mode.name, clients, "unavailable");
+                continue;
+            }
+            const UdpSendStats& stats = unpaced.stats;
+            double sentRate = stats.datagramsSent / unpaced.seconds;
+            double receivedRate = unpaced.received / unpaced.seconds;
+            double perCall = stats.systemCalls ? static_cast<double>(stats.datagramsSent) / stats.systemCalls : 0.0;
+            double nsPerPacket = stats.datagramsSent ? unpaced.cpuSeconds * 1e9 / stats.datagramsSent : 0.0;
+            double cpuPerClient = 100.0 * paced.cpuSeconds / paced.seconds / clients;
+            std::printf("%-14s %7d %12.0f %12.0f %10.1f %10.0f %12.3f\n",
+                        mode.name, clients, sentRate, receivedRate, perCall, nsPerPacket, cpuPerClient);
+        }
+    }
+    return EXIT_SUCCESS;
+}